@@ -0,0 +1,77 @@
+/// @file allocation_counter.cpp
+/// @brief Interposes the glibc malloc family to count allocations per thread. Counting is per thread so allocations
+/// made by the middleware's own threads do not show up in the measured loop. operator new is left to libstdc++, which
+/// allocates through malloc and aligned_alloc and so is counted here as well.
+
+#include "allocation_counter.hpp"
+
+#include <cerrno>
+#include <cstddef>
+
+
+extern "C"
+{
+void* __libc_malloc(std::size_t p_Size);
+void* __libc_calloc(std::size_t p_Count, std::size_t p_Size);
+void* __libc_realloc(void* p_Pointer, std::size_t p_Size);
+void* __libc_memalign(std::size_t p_Alignment, std::size_t p_Size);
+}
+
+namespace
+{
+
+// Initial exec, so reading the counter never allocates the thread's TLS block from inside malloc.
+__attribute__((tls_model("initial-exec"))) thread_local uint64_t t_AllocationCount = 0;
+
+} // namespace
+
+uint64_t ThreadAllocationCount()
+{
+	return t_AllocationCount;
+}
+
+extern "C"
+{
+
+void* malloc(std::size_t p_Size)
+{
+	++t_AllocationCount;
+	return __libc_malloc(p_Size);
+}
+
+void* calloc(std::size_t p_Count, std::size_t p_Size)
+{
+	++t_AllocationCount;
+	return __libc_calloc(p_Count, p_Size);
+}
+
+void* realloc(void* p_Pointer, std::size_t p_Size)
+{
+	// Shrinking or growing in place is counted too, it may move the block.
+	if (p_Size != 0) ++t_AllocationCount;
+	return __libc_realloc(p_Pointer, p_Size);
+}
+
+void* memalign(std::size_t p_Alignment, std::size_t p_Size)
+{
+	++t_AllocationCount;
+	return __libc_memalign(p_Alignment, p_Size);
+}
+
+void* aligned_alloc(std::size_t p_Alignment, std::size_t p_Size)
+{
+	++t_AllocationCount;
+	return __libc_memalign(p_Alignment, p_Size);
+}
+
+int posix_memalign(void** p_Pointer, std::size_t p_Alignment, std::size_t p_Size)
+{
+	if (p_Alignment < sizeof(void*) || (p_Alignment & (p_Alignment - 1)) != 0) return EINVAL;
+	++t_AllocationCount;
+	void* t_Pointer = __libc_memalign(p_Alignment, p_Size);
+	if (t_Pointer == nullptr) return ENOMEM;
+	*p_Pointer = t_Pointer;
+	return 0;
+}
+
+} // extern "C"
@@ -0,0 +1,12 @@
+/// @file allocation_counter.hpp
+/// @brief Counts the heap allocations made by the calling thread, to report and check allocations per frame in the
+/// benchmarks and tests. The malloc family replacements in allocation_counter.cpp feed it, which also catches operator
+/// new and any C code allocating.
+
+#pragma once
+
+#include <cstdint>
+
+
+/// @brief Number of times the calling thread has allocated from the heap so far.
+uint64_t ThreadAllocationCount();
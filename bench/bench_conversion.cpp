@@ -0,0 +1,349 @@
+/// @file bench_conversion.cpp
+/// @brief Benchmarks the per-frame conversion of SDK data into ROS 2 messages, the tracker_tf transforms and the filter
+/// stage.
+/// Synthetic frames of realistic size are fed through the real SDKMinimalClient callbacks (via a StreamDataSource, as
+/// a replay would), then the convert*DataToROS functions publish them on a node without subscribers. Each benchmark
+/// reports the time per frame and, in the allocs/frame counter, the heap allocations the conversion made per frame,
+/// and fails when that is not 0.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "conversion_environment.hpp"
+#include "manus_ros2_publisher.hpp"
+#include "MotionPredictor.hpp"
+#include "PoseResampler.hpp"
+#include "SDKMinimalClient.hpp"
+#include "SignalFilter.hpp"
+#include "tracker_tf.hpp"
+
+
+namespace
+{
+
+/// @brief Reports the allocations made by this thread since p_Before, per benchmark iteration, and fails the
+/// benchmark when there were any. The converters reuse their messages, so after the first frame this must be 0;
+/// whatever remains is made by the conversion or the middleware's publish.
+void ReportAllocationsPerFrame(benchmark::State& p_State, uint64_t p_Before)
+{
+	const uint64_t t_Allocations = ThreadAllocationCount() - p_Before;
+	p_State.counters["allocs/frame"] = benchmark::Counter((double)t_Allocations, benchmark::Counter::kAvgIterations);
+	if (t_Allocations != 0)
+	{
+		p_State.SkipWithError("allocated on the heap after the first frame");
+	}
+}
+
+/// @brief One skeleton stream frame of Arg(0) hands, two per user. The cost should grow linearly with the users.
+void BM_ConvertSkeletonData(benchmark::State& p_State)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	t_Environment.FeedSkeletons((uint32_t)p_State.range(0));
+
+	convertSkeletonDataToROS(*t_Environment.publisher); // Sizes the persistent messages.
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (auto _ : p_State)
+	{
+		convertSkeletonDataToROS(*t_Environment.publisher);
+	}
+	ReportAllocationsPerFrame(p_State, t_Before);
+	p_State.counters["nodes/frame"] = (double)(p_State.range(0) * c_NodesPerHand);
+}
+
+/// @brief One ergonomics stream frame, both hands.
+void BM_ConvertErgonomicsData(benchmark::State& p_State)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	t_Environment.FeedErgonomics();
+
+	convertErgonomicsDataToROS(*t_Environment.publisher); // Sizes the persistent messages.
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (auto _ : p_State)
+	{
+		convertErgonomicsDataToROS(*t_Environment.publisher);
+	}
+	ReportAllocationsPerFrame(p_State, t_Before);
+}
+
+/// @brief One tracker stream frame of Arg(0) trackers, alternating right and left hand trackers.
+void BM_ConvertTrackerData(benchmark::State& p_State)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	t_Environment.FeedTrackers((uint32_t)p_State.range(0));
+
+	convertTrackerDataToROS(*t_Environment.publisher); // Sizes the persistent messages.
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (auto _ : p_State)
+	{
+		convertTrackerDataToROS(*t_Environment.publisher);
+	}
+	ReportAllocationsPerFrame(p_State, t_Before);
+}
+
+void BM_TrackerXyzToHumanXyz(benchmark::State& p_State)
+{
+	Vector3d t_Position(0.1, 0.2, 1.0);
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (auto _ : p_State)
+	{
+		benchmark::DoNotOptimize(t_Position);
+		Vector3d t_Human = tracker_xyz_to_human_xyz(t_Position);
+		benchmark::DoNotOptimize(t_Human);
+	}
+	ReportAllocationsPerFrame(p_State, t_Before);
+}
+
+void BM_TrackerQuatToHumanRotation(benchmark::State& p_State)
+{
+	Vector4d t_Quaternion(0.0, 0.3826834, 0.0, 0.9238795); // xyzw
+	bool t_IsRightHand = true;
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (auto _ : p_State)
+	{
+		benchmark::DoNotOptimize(t_Quaternion);
+		Quaterniond t_Human = tracker_quat_to_human_rotation(t_Quaternion, t_IsRightHand);
+		benchmark::DoNotOptimize(t_Human);
+		t_IsRightHand = !t_IsRightHand;
+	}
+	ReportAllocationsPerFrame(p_State, t_Before);
+}
+
+/// @brief Arg(0) tracker poses of one hand, with plausible unit quaternions.
+class TrackerPoseBlock
+{
+public:
+	explicit TrackerPoseBlock(size_t p_Count)
+		: m_Values(7 * p_Count), m_Count(p_Count)
+	{
+		for (size_t i = 0; i < p_Count; i++)
+		{
+			const double t_Angle = 0.01 * (double)i;
+			Arrays().x[i] = 0.1 + 0.001 * (double)i;
+			Arrays().y[i] = 0.2;
+			Arrays().z[i] = 1.0;
+			Arrays().qx[i] = 0.0;
+			Arrays().qy[i] = std::sin(t_Angle);
+			Arrays().qz[i] = 0.0;
+			Arrays().qw[i] = std::cos(t_Angle);
+		}
+	}
+
+	TrackerPoseArrays Arrays()
+	{
+		double* t_Base = m_Values.data();
+		return { t_Base, t_Base + m_Count, t_Base + 2 * m_Count, t_Base + 3 * m_Count, t_Base + 4 * m_Count, t_Base + 5 * m_Count, t_Base + 6 * m_Count };
+	}
+
+private:
+	std::vector<double> m_Values;
+	size_t m_Count;
+};
+
+/// @brief The per-pose path: tracker_xyz_to_human_xyz() and tracker_quat_to_human_rotation() for every pose, as
+/// process_pose() did before the batch transform.
+void BM_TrackersToHumanPerPose(benchmark::State& p_State)
+{
+	const size_t t_Count = (size_t)p_State.range(0);
+	TrackerPoseBlock t_In(t_Count);
+	TrackerPoseBlock t_Out(t_Count);
+	const TrackerPoseArrays t_I = t_In.Arrays();
+	const TrackerPoseArrays t_O = t_Out.Arrays();
+	for (auto _ : p_State)
+	{
+		for (size_t i = 0; i < t_Count; i++)
+		{
+			const Vector3d t_Position = tracker_xyz_to_human_xyz(Vector3d(t_I.x[i], t_I.y[i], t_I.z[i]));
+			const Quaterniond t_Rotation = tracker_quat_to_human_rotation(Vector4d(t_I.qx[i], t_I.qy[i], t_I.qz[i], t_I.qw[i]), true);
+			t_O.x[i] = t_Position.x();
+			t_O.y[i] = t_Position.y();
+			t_O.z[i] = t_Position.z();
+			t_O.qx[i] = t_Rotation.x();
+			t_O.qy[i] = t_Rotation.y();
+			t_O.qz[i] = t_Rotation.z();
+			t_O.qw[i] = t_Rotation.w();
+		}
+		benchmark::ClobberMemory();
+	}
+	p_State.SetItemsProcessed((int64_t)p_State.iterations() * (int64_t)t_Count);
+}
+
+/// @brief trackers_to_human_batch() on the same poses. max_error is the largest difference to the per-pose path.
+void BM_TrackersToHumanBatch(benchmark::State& p_State)
+{
+	const size_t t_Count = (size_t)p_State.range(0);
+	TrackerPoseBlock t_In(t_Count);
+	TrackerPoseBlock t_Out(t_Count);
+	const TrackerPoseArrays t_I = t_In.Arrays();
+	const TrackerPoseArrays t_O = t_Out.Arrays();
+	for (auto _ : p_State)
+	{
+		trackers_to_human_batch(t_I, t_O, t_Count, true);
+		benchmark::ClobberMemory();
+	}
+	p_State.SetItemsProcessed((int64_t)p_State.iterations() * (int64_t)t_Count);
+
+	double t_MaxError = 0.0;
+	for (size_t i = 0; i < t_Count; i++)
+	{
+		const Quaterniond t_Rotation = tracker_quat_to_human_rotation(Vector4d(t_I.qx[i], t_I.qy[i], t_I.qz[i], t_I.qw[i]), true);
+		t_MaxError = std::max(t_MaxError, std::abs(t_O.x[i] + t_I.x[i]));
+		t_MaxError = std::max(t_MaxError, (Vector4d(t_O.qx[i], t_O.qy[i], t_O.qz[i], t_O.qw[i]) - t_Rotation.coeffs()).cwiseAbs().maxCoeff());
+	}
+	p_State.counters["max_error"] = t_MaxError;
+}
+
+/// @brief The filter stage on the nodes of Arg(1) hands of a 120hz stream, with filter type Arg(0): 1 One Euro,
+/// 2 critically damped, 3 median of 5. Every frame adds fresh jitter to the poses.
+void BM_FilterSkeletonNodes(benchmark::State& p_State)
+{
+	SignalFilterConfig t_Config;
+	t_Config.type = (SignalFilterType)p_State.range(0);
+	t_Config.beta = 0.5;
+	t_Config.outlierThreshold = 0.01;
+	const size_t t_Count = (size_t)p_State.range(1) * c_NodesPerHand;
+	SignalFilterBank t_Filter;
+	t_Filter.Configure(t_Config, 7, t_Count, 3);
+
+	// Process() works on whole blocks of lanes.
+	const size_t t_Stride = (t_Count + SignalFilterBank::c_Lanes - 1) / SignalFilterBank::c_Lanes * SignalFilterBank::c_Lanes;
+	std::vector<double> t_Values(7 * t_Stride);
+	double* t_Components[7];
+	for (size_t c = 0; c < 7; c++)
+	{
+		t_Components[c] = &t_Values[c * t_Stride];
+	}
+	int64_t t_TimeNs = 1000000000LL;
+	uint32_t t_Frame = 0;
+	for (auto _ : p_State)
+	{
+		p_State.PauseTiming();
+		const double t_Jitter = 0.001 * (double)(t_Frame++ % 7);
+		for (size_t i = 0; i < t_Count; i++)
+		{
+			t_Components[0][i] = 0.01 * (double)(i % c_NodesPerHand) + t_Jitter;
+			t_Components[1][i] = t_Jitter;
+			t_Components[2][i] = 0.0;
+			t_Components[3][i] = t_Jitter;
+			t_Components[4][i] = 0.0;
+			t_Components[5][i] = 0.0;
+			t_Components[6][i] = 1.0;
+		}
+		t_TimeNs += 8333333;
+		p_State.ResumeTiming();
+
+		t_Filter.Process(t_Components, t_Count, t_TimeNs);
+		benchmark::ClobberMemory();
+	}
+	p_State.counters["nodes/frame"] = (double)t_Count;
+}
+
+/// @brief Predicting the nodes of Arg(0) hands of a 120hz stream 20 ms ahead, while every node turns and moves at a
+/// constant rate, including the measurement of earlier predictions.
+void BM_PredictSkeletonNodes(benchmark::State& p_State)
+{
+	const size_t t_Count = (size_t)p_State.range(0) * c_NodesPerHand;
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(t_Count, 15.0);
+	PredictionErrorStats t_Stats;
+
+	// Process() works on whole blocks of lanes.
+	const size_t t_Stride = (t_Count + PosePredictor::c_Lanes - 1) / PosePredictor::c_Lanes * PosePredictor::c_Lanes;
+	std::vector<double> t_Values(7 * t_Stride);
+	double* t_Components[7];
+	for (size_t c = 0; c < 7; c++)
+	{
+		t_Components[c] = &t_Values[c * t_Stride];
+	}
+	int64_t t_TimeNs = 1000000000LL;
+	uint32_t t_Frame = 0;
+	for (auto _ : p_State)
+	{
+		p_State.PauseTiming();
+		const double t_Angle = 0.02 * (double)t_Frame;
+		const double t_Offset = 0.001 * (double)t_Frame++;
+		for (size_t i = 0; i < t_Count; i++)
+		{
+			t_Components[0][i] = 0.01 * (double)(i % c_NodesPerHand) + t_Offset;
+			t_Components[1][i] = t_Offset;
+			t_Components[2][i] = 0.0;
+			t_Components[3][i] = std::sin(t_Angle);
+			t_Components[4][i] = 0.0;
+			t_Components[5][i] = 0.0;
+			t_Components[6][i] = std::cos(t_Angle);
+		}
+		t_TimeNs += 8333333;
+		p_State.ResumeTiming();
+
+		t_Predictor.Process(t_Components, t_Count, t_TimeNs, 0.02, t_Stats);
+		benchmark::ClobberMemory();
+	}
+	const PredictionErrorStats::Summary t_Summary = t_Stats.TakeWindow();
+	p_State.counters["nodes/frame"] = (double)t_Count;
+	p_State.counters["rotation_error"] = t_Summary.rotationMean;
+}
+
+/// @brief One tick of the resampler on Arg(0) hands, interpolating between 120hz frames with interpolation Arg(1):
+/// 0 linear, 1 Hermite. Every node turns and moves, so every rotation is a full SLERP.
+void BM_ResampleSkeletonNodes(benchmark::State& p_State)
+{
+	const size_t t_Hands = (size_t)p_State.range(0);
+	const size_t t_Count = t_Hands * c_NodesPerHand;
+	const ResampleInterpolation t_Interpolation = (ResampleInterpolation)p_State.range(1);
+	PoseHistory t_History;
+	t_History.Configure(t_Count, c_NodesPerHand);
+
+	std::vector<double> t_Values(7 * t_Count), t_Output(7 * t_Count);
+	double* t_Components[7];
+	double* t_OutputComponents[7];
+	for (size_t c = 0; c < 7; c++)
+	{
+		t_Components[c] = &t_Values[c * t_Count];
+		t_OutputComponents[c] = &t_Output[c * t_Count];
+	}
+	std::vector<uint32_t> t_Keys(t_Hands, 1), t_SampleKeys(t_Hands);
+	const int64_t t_FrameNs = 8333333;
+	for (int64_t t_Frame = 0; t_Frame < (int64_t)PoseHistory::c_MaxFrames; t_Frame++)
+	{
+		const double t_Angle = 0.05 * (double)t_Frame;
+		for (size_t i = 0; i < t_Count; i++)
+		{
+			t_Components[0][i] = 0.01 * (double)(i % c_NodesPerHand) + 0.001 * (double)t_Frame;
+			t_Components[1][i] = 0.0;
+			t_Components[2][i] = 0.0;
+			t_Components[3][i] = std::sin(t_Angle);
+			t_Components[4][i] = 0.0;
+			t_Components[5][i] = 0.0;
+			t_Components[6][i] = std::cos(t_Angle);
+		}
+		t_History.Push(t_Components, t_Count, t_Keys.data(), t_Frame * t_FrameNs);
+	}
+
+	// A 1 kHz schedule sweeping the interval between two frames in the middle of the history.
+	int64_t t_Tick = 0;
+	bool t_Held = false;
+	for (auto _ : p_State)
+	{
+		const int64_t t_SampleNs = 4 * t_FrameNs + (t_Tick++ % 8) * 1000000;
+		benchmark::DoNotOptimize(t_History.Sample(t_SampleNs, t_Interpolation, t_OutputComponents, t_SampleKeys.data(), t_Held));
+		benchmark::ClobberMemory();
+	}
+	p_State.counters["nodes/tick"] = (double)t_Count;
+}
+
+} // namespace
+
+BENCHMARK(BM_ConvertSkeletonData)->Arg(2)->Arg(MAX_NUMBER_OF_SKELETONS);
+BENCHMARK(BM_ConvertErgonomicsData);
+BENCHMARK(BM_ConvertTrackerData)->Arg(2)->Arg(MAX_NUMBER_OF_TRACKERS);
+BENCHMARK(BM_TrackerXyzToHumanXyz);
+BENCHMARK(BM_TrackerQuatToHumanRotation);
+BENCHMARK(BM_TrackersToHumanPerPose)->Arg(2)->Arg(16)->Arg(MAX_NUMBER_OF_TRACKERS);
+BENCHMARK(BM_TrackersToHumanBatch)->Arg(2)->Arg(16)->Arg(MAX_NUMBER_OF_TRACKERS);
+BENCHMARK(BM_FilterSkeletonNodes)->ArgsProduct({ { 1, 2, 3 }, { 2, MAX_NUMBER_OF_SKELETONS } });
+BENCHMARK(BM_PredictSkeletonNodes)->Arg(2)->Arg(MAX_NUMBER_OF_SKELETONS);
+BENCHMARK(BM_ResampleSkeletonNodes)->ArgsProduct({ { 2, MAX_NUMBER_OF_SKELETONS }, { 0, 1 } });
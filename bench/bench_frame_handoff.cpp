@@ -0,0 +1,137 @@
+/// @file bench_frame_handoff.cpp
+/// @brief Contention microbenchmark for handing skeleton frames from the SDK callback thread to the publishing thread.
+/// Compares the original mutex + heap pointer swap against the wait-free TripleBuffer used by SDKMinimalClient.
+/// Each benchmark runs the measured side in the benchmark loop while the other side hammers the handoff from a
+/// background thread as fast as it can, which is the worst case for contention.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "ManusSDKTypes.h"
+#include "TripleBuffer.hpp"
+
+
+namespace
+{
+
+/// @brief Payload the size of a two hand skeleton frame.
+struct HandoffFrame
+{
+	SkeletonNode nodes[2 * 21];
+	uint64_t sequence = 0;
+};
+
+/// @brief The handoff SDKMinimalClient used before the triple buffer: a mutex guarding a heap allocated next frame.
+class MutexHandoff
+{
+public:
+	~MutexHandoff()
+	{
+		delete m_Next;
+		delete m_Current;
+	}
+
+	void Write(uint64_t p_Sequence)
+	{
+		HandoffFrame* t_Frame = new HandoffFrame();
+		t_Frame->sequence = p_Sequence;
+		m_Mutex.lock();
+		if (m_Next != nullptr) delete m_Next;
+		m_Next = t_Frame;
+		m_Mutex.unlock();
+	}
+
+	uint64_t Read()
+	{
+		m_Mutex.lock();
+		if (m_Next != nullptr)
+		{
+			if (m_Current != nullptr) delete m_Current;
+			m_Current = m_Next;
+			m_Next = nullptr;
+		}
+		m_Mutex.unlock();
+		return m_Current != nullptr ? m_Current->sequence : 0;
+	}
+
+private:
+	std::mutex m_Mutex;
+	HandoffFrame* m_Next = nullptr;
+	HandoffFrame* m_Current = nullptr;
+};
+
+/// @brief The wait-free handoff, filling the write slot in place like the SDK callbacks do.
+class TripleBufferHandoff
+{
+public:
+	void Write(uint64_t p_Sequence)
+	{
+		m_Buffer.WriteBuffer().sequence = p_Sequence;
+		m_Buffer.Publish();
+	}
+
+	uint64_t Read()
+	{
+		m_Buffer.Update();
+		return m_Buffer.ReadBuffer().sequence;
+	}
+
+private:
+	TripleBuffer<HandoffFrame> m_Buffer;
+};
+
+/// @brief Measures the reading (publishing thread) side while a writer thread publishes continuously.
+template <typename Handoff>
+void BM_ReaderUnderContention(benchmark::State& p_State)
+{
+	Handoff t_Handoff;
+	std::atomic<bool> t_Stop{ false };
+	std::thread t_Writer([&t_Handoff, &t_Stop]() {
+		uint64_t t_Sequence = 1;
+		while (!t_Stop.load(std::memory_order_relaxed))
+		{
+			t_Handoff.Write(t_Sequence++);
+		}
+	});
+
+	for (auto _ : p_State)
+	{
+		benchmark::DoNotOptimize(t_Handoff.Read());
+	}
+
+	t_Stop.store(true);
+	t_Writer.join();
+}
+
+/// @brief Measures the writing (SDK callback) side while a reader thread takes frames continuously.
+template <typename Handoff>
+void BM_WriterUnderContention(benchmark::State& p_State)
+{
+	Handoff t_Handoff;
+	std::atomic<bool> t_Stop{ false };
+	std::thread t_Reader([&t_Handoff, &t_Stop]() {
+		while (!t_Stop.load(std::memory_order_relaxed))
+		{
+			benchmark::DoNotOptimize(t_Handoff.Read());
+		}
+	});
+
+	uint64_t t_Sequence = 1;
+	for (auto _ : p_State)
+	{
+		t_Handoff.Write(t_Sequence++);
+	}
+
+	t_Stop.store(true);
+	t_Reader.join();
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ReaderUnderContention, MutexHandoff)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ReaderUnderContention, TripleBufferHandoff)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_WriterUnderContention, MutexHandoff)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_WriterUnderContention, TripleBufferHandoff)->UseRealTime();
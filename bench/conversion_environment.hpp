@@ -0,0 +1,121 @@
+/// @file conversion_environment.hpp
+/// @brief A publisher node and SDK client fed with synthetic frames of realistic size through the real
+/// SDKMinimalClient callbacks (via a StreamDataSource, as a replay would), shared by the conversion benchmarks and the
+/// allocation test.
+
+#pragma once
+
+#include <memory>
+
+#include "manus_ros2_publisher.hpp"
+#include "SDKMinimalClient.hpp"
+
+
+constexpr uint32_t c_NodesPerHand = 21;
+constexpr uint32_t c_RightHandID = 1;
+
+/// @brief Serves hands of c_NodesPerHand nodes and hand trackers with plausible, non-constant values.
+class SyntheticSource : public StreamDataSource
+{
+public:
+	bool GetSkeletonInfo(uint32_t p_Index, SkeletonInfo* p_Info) override
+	{
+		p_Info->id = c_RightHandID + p_Index;
+		p_Info->nodesCount = c_NodesPerHand;
+		p_Info->publishTime = {};
+		return true;
+	}
+
+	bool GetSkeletonData(uint32_t p_Index, SkeletonNode* p_Nodes, uint32_t p_NodeCount) override
+	{
+		for (uint32_t i = 0; i < p_NodeCount; i++)
+		{
+			p_Nodes[i].id = i;
+			p_Nodes[i].transform.position = { 0.01f * (float)i, 0.002f * (float)p_Index, 0.0f };
+			p_Nodes[i].transform.rotation = { 1.0f, 0.0f, 0.0f, 0.0f };
+			p_Nodes[i].transform.scale = { 1.0f, 1.0f, 1.0f };
+		}
+		return true;
+	}
+
+	bool GetTrackerData(uint32_t p_Index, TrackerData* p_Data) override
+	{
+		*p_Data = TrackerData();
+		p_Data->trackerType = (p_Index % 2 == 0) ? TrackerType_RightHand : TrackerType_LeftHand;
+		p_Data->position = { 0.1f * (float)p_Index, 0.2f, 1.0f };
+		p_Data->rotation = { 0.9238795f, 0.0f, 0.3826834f, 0.0f };
+		return true;
+	}
+};
+
+/// @brief The node and client shared by all conversion benchmarks or tests of a process, created on first use.
+class ConversionEnvironment
+{
+public:
+	static ConversionEnvironment& Get()
+	{
+		static ConversionEnvironment s_Environment;
+		return s_Environment;
+	}
+
+	void FeedSkeletons(uint32_t p_SkeletonCount)
+	{
+		SkeletonStreamInfo t_Info = {};
+		t_Info.skeletonsCount = p_SkeletonCount;
+		SDKMinimalClient::OnSkeletonStreamCallback(&t_Info);
+		client->Run();
+	}
+
+	void FeedErgonomics()
+	{
+		// Without a landscape both hands map to glove ID 0.
+		m_Ergonomics->dataCount = 1;
+		m_Ergonomics->data[0].id = 0;
+		m_Ergonomics->data[0].isUserID = false;
+		for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++)
+		{
+			m_Ergonomics->data[0].data[i] = 0.01f * (float)i;
+		}
+		SDKMinimalClient::OnErgonomicsStreamCallback(m_Ergonomics.get());
+		client->Run();
+	}
+
+	void FeedTrackers(uint32_t p_TrackerCount)
+	{
+		TrackerStreamInfo t_Info = {};
+		t_Info.trackerCount = p_TrackerCount;
+		SDKMinimalClient::OnTrackerStreamCallback(&t_Info);
+		client->Run();
+	}
+
+	std::shared_ptr<ManusROS2Publisher> publisher;
+	std::unique_ptr<SDKMinimalClient> client;
+
+private:
+	ConversionEnvironment()
+		: m_Ergonomics(new ErgonomicsStream())
+	{
+		rclcpp::init(0, nullptr);
+		// Every pair of skeletons the source serves belongs to its own user, so a frame of N hands publishes on the
+		// topics of N / 2 users.
+		publisher = std::make_shared<ManusROS2Publisher>(rclcpp::NodeOptions().parameter_overrides({ { "multi_user", true } }));
+		client.reset(new SDKMinimalClient(*publisher));
+		for (uint32_t t_User = 0; t_User < SDKMinimalClient::c_MaxUsers; t_User++)
+		{
+			client->AddUserHandSkeletons(100 + t_User, c_RightHandID + 2 * t_User, c_RightHandID + 2 * t_User + 1);
+			publisher->add_user(t_User, 100 + t_User);
+		}
+		SDKMinimalClient::SetStreamDataSource(&m_Source);
+	}
+
+	~ConversionEnvironment()
+	{
+		SDKMinimalClient::SetStreamDataSource(nullptr);
+		client.reset();
+		publisher.reset();
+		rclcpp::shutdown();
+	}
+
+	SyntheticSource m_Source;
+	std::unique_ptr<ErgonomicsStream> m_Ergonomics;
+};
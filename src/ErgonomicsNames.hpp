@@ -0,0 +1,83 @@
+/// @file ErgonomicsNames.hpp
+/// @brief Names of the ErgonomicsDataType values, generated from one list that is checked against the SDK enum at
+/// compile time, so the published joint names cannot drift from the indices they label.
+
+#pragma once
+
+#include "ManusSDKTypes.h"
+
+
+/// @brief X-macro listing every ErgonomicsDataType in enum order, without the ErgonomicsDataType_ prefix.
+#define MANUS_ERGONOMICS_DATA_TYPES(X) \
+	X(LeftFingerThumbMCPSpread) \
+	X(LeftFingerThumbMCPStretch) \
+	X(LeftFingerThumbPIPStretch) \
+	X(LeftFingerThumbDIPStretch) \
+	X(LeftFingerIndexMCPSpread) \
+	X(LeftFingerIndexMCPStretch) \
+	X(LeftFingerIndexPIPStretch) \
+	X(LeftFingerIndexDIPStretch) \
+	X(LeftFingerMiddleMCPSpread) \
+	X(LeftFingerMiddleMCPStretch) \
+	X(LeftFingerMiddlePIPStretch) \
+	X(LeftFingerMiddleDIPStretch) \
+	X(LeftFingerRingMCPSpread) \
+	X(LeftFingerRingMCPStretch) \
+	X(LeftFingerRingPIPStretch) \
+	X(LeftFingerRingDIPStretch) \
+	X(LeftFingerPinkyMCPSpread) \
+	X(LeftFingerPinkyMCPStretch) \
+	X(LeftFingerPinkyPIPStretch) \
+	X(LeftFingerPinkyDIPStretch) \
+	X(RightFingerThumbMCPSpread) \
+	X(RightFingerThumbMCPStretch) \
+	X(RightFingerThumbPIPStretch) \
+	X(RightFingerThumbDIPStretch) \
+	X(RightFingerIndexMCPSpread) \
+	X(RightFingerIndexMCPStretch) \
+	X(RightFingerIndexPIPStretch) \
+	X(RightFingerIndexDIPStretch) \
+	X(RightFingerMiddleMCPSpread) \
+	X(RightFingerMiddleMCPStretch) \
+	X(RightFingerMiddlePIPStretch) \
+	X(RightFingerMiddleDIPStretch) \
+	X(RightFingerRingMCPSpread) \
+	X(RightFingerRingMCPStretch) \
+	X(RightFingerRingPIPStretch) \
+	X(RightFingerRingDIPStretch) \
+	X(RightFingerPinkyMCPSpread) \
+	X(RightFingerPinkyMCPStretch) \
+	X(RightFingerPinkyPIPStretch) \
+	X(RightFingerPinkyDIPStretch)
+
+namespace ErgonomicsNamesDetail
+{
+	// Position of each entry in the list, to check it against the enum value of the same name.
+	enum ListIndex
+	{
+#define MANUS_ERGONOMICS_LIST_INDEX(name) name,
+		MANUS_ERGONOMICS_DATA_TYPES(MANUS_ERGONOMICS_LIST_INDEX)
+#undef MANUS_ERGONOMICS_LIST_INDEX
+		Count
+	};
+
+#define MANUS_ERGONOMICS_CHECK_INDEX(name) \
+	static_assert((int)ListIndex::name == (int)ErgonomicsDataType_##name, "ErgonomicsDataType_" #name " moved in the SDK");
+	MANUS_ERGONOMICS_DATA_TYPES(MANUS_ERGONOMICS_CHECK_INDEX)
+#undef MANUS_ERGONOMICS_CHECK_INDEX
+
+	static_assert((int)ListIndex::Count == (int)ErgonomicsDataType_MAX_SIZE, "The SDK added or removed ErgonomicsDataTypes");
+}
+
+/// @brief Joint name of every ErgonomicsDataType, indexed by the enum value.
+constexpr const char* c_ErgonomicsDataTypeNames[ErgonomicsDataType_MAX_SIZE] = {
+#define MANUS_ERGONOMICS_NAME(name) #name,
+	MANUS_ERGONOMICS_DATA_TYPES(MANUS_ERGONOMICS_NAME)
+#undef MANUS_ERGONOMICS_NAME
+};
+
+/// @brief Left hand types come first in the enum, the right hand ones after.
+constexpr bool IsLeftHandErgonomicsDataType(int p_Type)
+{
+	return p_Type <= ErgonomicsDataType_LeftFingerPinkyDIPStretch;
+}
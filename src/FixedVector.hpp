@@ -0,0 +1,46 @@
+/// @file FixedVector.hpp
+/// @brief Fixed capacity, inline storage vector used for frame data so the SDK stream callbacks never allocate.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+
+/// @brief A vector-like container with all of its storage inline.
+/// Unlike std::vector, resize() never allocates and never constructs or destroys elements: it only moves the end
+/// marker, clamped to the capacity. It is meant for trivially copyable SDK structs that are overwritten right after
+/// resizing, such as the SkeletonNode and TrackerData arrays filled by the SDK.
+template <typename T, size_t Capacity>
+class FixedVector
+{
+public:
+	/// @brief Sets the number of used elements, clamped to the capacity.
+	/// @return The resulting size, which callers must use when the requested size may exceed the capacity.
+	size_t resize(size_t p_Size)
+	{
+		m_Size = p_Size < Capacity ? p_Size : Capacity;
+		return m_Size;
+	}
+
+	void clear() { m_Size = 0; }
+
+	size_t size() const { return m_Size; }
+	bool empty() const { return m_Size == 0; }
+	static constexpr size_t capacity() { return Capacity; }
+
+	T* data() { return m_Items.data(); }
+	const T* data() const { return m_Items.data(); }
+
+	T& operator[](size_t p_Index) { return m_Items[p_Index]; }
+	const T& operator[](size_t p_Index) const { return m_Items[p_Index]; }
+
+	T* begin() { return m_Items.data(); }
+	T* end() { return m_Items.data() + m_Size; }
+	const T* begin() const { return m_Items.data(); }
+	const T* end() const { return m_Items.data() + m_Size; }
+
+private:
+	std::array<T, Capacity> m_Items;
+	size_t m_Size = 0;
+};
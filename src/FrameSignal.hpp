@@ -0,0 +1,84 @@
+/// @file FrameSignal.hpp
+/// @brief Wake-up primitive used by the SDK stream callbacks to tell the publishing thread that a new frame has been
+/// handed off, so frames are converted and published as soon as they arrive instead of on the next timer tick.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "LatencyStats.hpp"
+
+
+/// @brief Signals the publishing thread from the SDK callback threads.
+/// Notify() only touches the mutex on the first frame after the publisher has drained the signal, so bursts of
+/// callbacks coalesce into a single wake-up. The arrival time of the oldest unconsumed frame is kept so the
+/// publisher can measure how long frames waited for it.
+class FrameSignal
+{
+public:
+	/// @brief Called from the SDK callback threads after a frame has been handed off.
+	void Notify()
+	{
+		int64_t t_NoArrival = 0;
+		m_OldestArrivalNs.compare_exchange_strong(t_NoArrival, SteadyNowNs(), std::memory_order_acq_rel);
+
+		if (!m_Pending.exchange(true, std::memory_order_acq_rel))
+		{
+			// Taking the lock orders this notify after a waiter that has just checked the predicate.
+			std::lock_guard<std::mutex> t_Lock(m_Mutex);
+			m_Condition.notify_one();
+		}
+	}
+
+	/// @brief Blocks until a frame is signalled, the timeout expires or Interrupt() is called.
+	/// @return true when woken by a frame, false on timeout or interrupt.
+	bool WaitFor(std::chrono::nanoseconds p_Timeout)
+	{
+		std::unique_lock<std::mutex> t_Lock(m_Mutex);
+		m_Condition.wait_for(t_Lock, p_Timeout, [this]()
+			{ return m_Pending.load(std::memory_order_acquire) || m_Interrupted.load(std::memory_order_acquire); });
+		return m_Pending.exchange(false, std::memory_order_acq_rel) && !m_Interrupted.load(std::memory_order_acquire);
+	}
+
+	/// @brief Wakes up any waiter for good, used on shutdown.
+	void Interrupt()
+	{
+		m_Interrupted.store(true, std::memory_order_release);
+		std::lock_guard<std::mutex> t_Lock(m_Mutex);
+		m_Condition.notify_all();
+	}
+
+	/// @brief Returns the steady clock time of the oldest frame signalled since the last call, or 0 if there was none.
+	int64_t TakeOldestArrivalNs() { return m_OldestArrivalNs.exchange(0, std::memory_order_acq_rel); }
+
+	static int64_t SteadyNowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	std::atomic<bool> m_Pending{ false };
+	std::atomic<bool> m_Interrupted{ false };
+	std::atomic<int64_t> m_OldestArrivalNs{ 0 };
+};
+
+/// @brief Accumulates the time frames wait between the SDK callback and the publisher picking them up. With event
+/// driven publishing this is how quickly the publishing thread gets to run, so its percentiles are the thread's jitter.
+/// Written by the publishing thread and read by the reporting timer.
+class FrameHandoffStats
+{
+public:
+	void Record(int64_t p_WaitNs) { m_Wait.Record(p_WaitNs); }
+
+	/// @brief Returns the statistics gathered since the last call and starts a new window.
+	LatencyHistogram::Summary TakeWindow() { return m_Wait.TakeWindow(); }
+
+private:
+	LatencyHistogram m_Wait;
+};
@@ -0,0 +1,91 @@
+/// @file HandSkeletonLayout.hpp
+/// @brief Node layout and bind pose of the hand skeletons the client loads: a root node with ID 0, followed by 5
+/// fingers of 4 joints, each finger a chain hanging off the root. Shared by the skeleton setup and the TF output.
+
+#pragma once
+
+#include <cstdint>
+
+#include "ManusSDKTypes.h"
+
+
+constexpr uint32_t c_HandFingerCount = 5;
+constexpr uint32_t c_HandJointsPerFinger = 4;
+constexpr uint32_t c_HandNodeCount = 1 + c_HandFingerCount * c_HandJointsPerFinger;
+
+/// @brief Node ID of a finger joint. Joint 0 is the one attached to the root.
+constexpr uint32_t HandJointNodeID(uint32_t p_Finger, uint32_t p_Joint)
+{
+	return 1 + p_Finger * c_HandJointsPerFinger + p_Joint;
+}
+
+/// @brief ID of the parent of a node. The root is its own parent, as in the skeleton setup.
+constexpr uint32_t HandNodeParentID(uint32_t p_NodeID)
+{
+	return (p_NodeID == 0 || (p_NodeID - 1) % c_HandJointsPerFinger == 0) ? 0 : p_NodeID - 1;
+}
+
+/// @brief Name of every node, indexed by node ID.
+constexpr const char* c_HandNodeNames[c_HandNodeCount] = {
+	"hand",
+	"thumb_cmc", "thumb_mcp", "thumb_ip", "thumb_tip",
+	"index_mcp", "index_pip", "index_dip", "index_tip",
+	"middle_mcp", "middle_pip", "middle_dip", "middle_tip",
+	"ring_mcp", "ring_pip", "ring_dip", "ring_tip",
+	"pinky_mcp", "pinky_pip", "pinky_dip", "pinky_tip"
+};
+
+/// @brief Bind pose position of every finger joint relative to its parent, indexed by node ID - 1.
+constexpr ManusVec3 c_HandBindPositionsRight[c_HandFingerCount * c_HandJointsPerFinger] = {
+	{ 0.025320f, 0.024950f, 0.000000f }, // Thumb CMC joint
+	{ 0.032742f, 0.000000f, 0.000000f }, // Thumb MCP joint
+	{ 0.028739f, 0.000000f, 0.000000f }, // Thumb IP joint
+	{ 0.028739f, 0.000000f, 0.000000f }, // Thumb Tip joint
+
+	{ 0.052904f, -0.011181f, 0.000000f }, // Index MCP joint
+	{ 0.038257f, 0.000000f, 0.000000f },  // Index PIP joint
+	{ 0.020884f, 0.000000f, 0.000000f },  // Index DIP joint
+	{ 0.018759f, 0.000000f, 0.000000f },  // Index Tip joint
+
+	{ 0.051287f, 0.000000f, 0.000000f }, // Middle MCP joint
+	{ 0.041861f, 0.000000f, 0.000000f }, // Middle PIP joint
+	{ 0.024766f, 0.000000f, 0.000000f }, // Middle DIP joint
+	{ 0.019683f, 0.000000f, 0.000000f }, // Middle Tip joint
+
+	{ 0.049802f, -0.011274f, 0.000000f }, // Ring MCP joint
+	{ 0.039736f, 0.000000f, 0.000000f },  // Ring PIP joint
+	{ 0.023564f, 0.000000f, 0.000000f },  // Ring DIP joint
+	{ 0.019868f, 0.000000f, 0.000000f },  // Ring Tip joint
+
+	{ 0.047309f, -0.020145f, 0.000000f }, // Pinky MCP joint
+	{ 0.033175f, 0.000000f, 0.000000f },  // Pinky PIP joint
+	{ 0.018020f, 0.000000f, 0.000000f },  // Pinky DIP joint
+	{ 0.019129f, 0.000000f, 0.000000f }   // Pinky Tip joint
+};
+
+constexpr ManusVec3 c_HandBindPositionsLeft[c_HandFingerCount * c_HandJointsPerFinger] = {
+	{ -0.025320f, 0.024950f, 0.000000f }, // Thumb CMC joint
+	{ -0.032742f, 0.000000f, 0.000000f }, // Thumb MCP joint
+	{ -0.028739f, 0.000000f, 0.000000f }, // Thumb IP joint
+	{ -0.028739f, 0.000000f, 0.000000f }, // Thumb Tip joint
+
+	{ -0.052904f, -0.011181f, 0.000000f }, // Index MCP joint
+	{ -0.038257f, 0.000000f, 0.000000f },  // Index PIP joint
+	{ -0.020884f, 0.000000f, 0.000000f },  // Index DIP joint
+	{ -0.018759f, 0.000000f, 0.000000f },  // Index Tip joint
+
+	{ -0.051287f, 0.000000f, 0.000000f }, // Middle MCP joint
+	{ -0.041861f, 0.000000f, 0.000000f }, // Middle PIP joint
+	{ -0.024766f, 0.000000f, 0.000000f }, // Middle DIP joint
+	{ -0.019683f, 0.000000f, 0.000000f }, // Middle Tip joint
+
+	{ -0.049802f, 0.011274f, 0.000000f }, // Ring MCP joint
+	{ -0.039736f, 0.000000f, 0.000000f }, // Ring PIP joint
+	{ -0.023564f, 0.000000f, 0.000000f }, // Ring DIP joint
+	{ -0.019868f, 0.000000f, 0.000000f }, // Ring Tip joint
+
+	{ -0.047309f, 0.020145f, 0.000000f }, // Pinky MCP joint
+	{ -0.033175f, 0.000000f, 0.000000f }, // Pinky PIP joint
+	{ -0.018020f, 0.000000f, 0.000000f }, // Pinky DIP joint
+	{ -0.019129f, 0.000000f, 0.000000f }  // Pinky Tip joint
+};
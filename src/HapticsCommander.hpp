@@ -0,0 +1,193 @@
+/// @file HapticsCommander.hpp
+/// @brief Hands haptics commands from the ROS executor to a dedicated thread that sends them to the gloves. Commands
+/// arriving faster than the gloves are driven are coalesced to the newest one per hand, so the executor never waits on
+/// the SDK's gRPC calls and a burst of commands cannot queue up behind them.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameSignal.hpp"
+#include "LatencyStats.hpp"
+
+
+/// @brief Latest haptics command per hand, sent at most once per period and hand from its own thread.
+/// Command() can be called from any thread and only holds a mutex to copy the powers.
+class HapticsCommander
+{
+public:
+	/// @brief Thumb, Index, Middle, Ring and Pinky, the order the SDK takes the powers in.
+	static constexpr size_t c_FingerCount = 5;
+
+	/// @brief Sends the powers of a hand, returns false when the hand cannot be driven. Called from the haptics thread.
+	using Sink = std::function<bool(uint32_t p_UserSlot, bool p_IsRightHand, const float* p_Powers)>;
+
+	struct Summary
+	{
+		uint64_t commands = 0;
+		// Commands replaced by a newer one for the same hand before they were sent.
+		uint64_t coalesced = 0;
+		uint64_t failed = 0;
+		// From Command() to the start of the SDK call, and the duration of the SDK call.
+		LatencyHistogram::Summary commandToSdk;
+		LatencyHistogram::Summary sdkCall;
+	};
+
+	explicit HapticsCommander(uint32_t p_MaxUsers) : m_Hands((size_t)p_MaxUsers * 2) {}
+	~HapticsCommander() { Stop(); }
+
+	/// @brief Starts the haptics thread. p_ThreadSetup runs first on it, to apply its scheduling.
+	void Start(Sink p_Sink, double p_MaxRateHz, std::function<void()> p_ThreadSetup)
+	{
+		m_Sink = std::move(p_Sink);
+		m_PeriodNs = p_MaxRateHz > 0.0 ? (int64_t)(1e9 / p_MaxRateHz) : 0;
+		m_Stop = false;
+		m_Thread = std::thread([this, p_ThreadSetup]() {
+			if (p_ThreadSetup) p_ThreadSetup();
+			Run();
+		});
+	}
+
+	/// @brief Stops the thread, then turns off the motors of every hand it left vibrating.
+	void Stop()
+	{
+		if (!m_Thread.joinable()) return;
+		{
+			std::lock_guard<std::mutex> t_Lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_Changed.notify_one();
+		m_Thread.join();
+
+		const float t_Off[c_FingerCount] = {};
+		for (size_t t_Hand = 0; t_Hand < m_Hands.size(); t_Hand++)
+		{
+			if (m_Hands[t_Hand].vibrating)
+			{
+				m_Sink((uint32_t)(t_Hand / 2), t_Hand % 2 == 1, t_Off);
+				m_Hands[t_Hand].vibrating = false;
+			}
+		}
+	}
+
+	/// @brief Replaces the pending command of a hand. Powers are clamped to 0 to 1, NaN turns a motor off.
+	void Command(uint32_t p_UserSlot, bool p_IsRightHand, const float* p_Powers)
+	{
+		const size_t t_Hand = (size_t)p_UserSlot * 2 + (p_IsRightHand ? 1 : 0);
+		if (t_Hand >= m_Hands.size()) return;
+		const int64_t t_NowNs = FrameSignal::SteadyNowNs();
+		m_Commands.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> t_Lock(m_Mutex);
+			Hand& t_State = m_Hands[t_Hand];
+			for (size_t i = 0; i < c_FingerCount; i++)
+			{
+				t_State.pending[i] = std::isnan(p_Powers[i]) ? 0.0f : std::min(std::max(p_Powers[i], 0.0f), 1.0f);
+			}
+			if (t_State.hasPending)
+			{
+				m_Coalesced.fetch_add(1, std::memory_order_relaxed);
+			}
+			// The latency is that of the powers actually sent, the newest command.
+			t_State.commandNs = t_NowNs;
+			t_State.hasPending = true;
+		}
+		m_Changed.notify_one();
+	}
+
+	/// @brief Returns the counts and latencies since the last call and clears them. From one reporting thread.
+	Summary TakeWindow()
+	{
+		Summary t_Summary;
+		t_Summary.commands = m_Commands.exchange(0, std::memory_order_relaxed);
+		t_Summary.coalesced = m_Coalesced.exchange(0, std::memory_order_relaxed);
+		t_Summary.failed = m_Failed.exchange(0, std::memory_order_relaxed);
+		t_Summary.commandToSdk = m_CommandToSdk.TakeWindow();
+		t_Summary.sdkCall = m_SdkCall.TakeWindow();
+		return t_Summary;
+	}
+
+private:
+	struct Hand
+	{
+		std::array<float, c_FingerCount> pending{};
+		int64_t commandNs = 0;
+		// Earliest time the next command of the hand may be sent.
+		int64_t nextSendNs = 0;
+		bool hasPending = false;
+		// Haptics thread only: whether the last powers sent were not all zero.
+		bool vibrating = false;
+	};
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> t_Lock(m_Mutex);
+		while (!m_Stop)
+		{
+			// Send the first pending hand that is due, or sleep until one is.
+			const int64_t t_NowNs = FrameSignal::SteadyNowNs();
+			int64_t t_WakeNs = INT64_MAX;
+			size_t t_Due = m_Hands.size();
+			for (size_t t_Hand = 0; t_Hand < m_Hands.size() && t_Due == m_Hands.size(); t_Hand++)
+			{
+				const Hand& t_State = m_Hands[t_Hand];
+				if (!t_State.hasPending) continue;
+				if (t_State.nextSendNs <= t_NowNs) t_Due = t_Hand;
+				else t_WakeNs = std::min(t_WakeNs, t_State.nextSendNs);
+			}
+			if (t_Due == m_Hands.size())
+			{
+				if (t_WakeNs == INT64_MAX) m_Changed.wait(t_Lock);
+				else m_Changed.wait_for(t_Lock, std::chrono::nanoseconds(t_WakeNs - t_NowNs));
+				continue;
+			}
+
+			Hand& t_State = m_Hands[t_Due];
+			const std::array<float, c_FingerCount> t_Powers = t_State.pending;
+			const int64_t t_CommandNs = t_State.commandNs;
+			t_State.hasPending = false;
+			t_State.nextSendNs = t_NowNs + m_PeriodNs;
+			t_Lock.unlock();
+
+			const int64_t t_SendNs = FrameSignal::SteadyNowNs();
+			m_CommandToSdk.Record(t_SendNs - t_CommandNs);
+			const bool t_Sent = m_Sink((uint32_t)(t_Due / 2), t_Due % 2 == 1, t_Powers.data());
+			m_SdkCall.Record(FrameSignal::SteadyNowNs() - t_SendNs);
+			if (!t_Sent)
+			{
+				m_Failed.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				t_State.vibrating = std::any_of(t_Powers.begin(), t_Powers.end(), [](float p_Power) { return p_Power > 0.0f; });
+			}
+
+			t_Lock.lock();
+		}
+	}
+
+	Sink m_Sink;
+	int64_t m_PeriodNs = 0;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	std::vector<Hand> m_Hands;
+	bool m_Stop = false;
+	std::thread m_Thread;
+
+	std::atomic<uint64_t> m_Commands{ 0 };
+	std::atomic<uint64_t> m_Coalesced{ 0 };
+	std::atomic<uint64_t> m_Failed{ 0 };
+	LatencyHistogram m_CommandToSdk;
+	LatencyHistogram m_SdkCall;
+};
@@ -0,0 +1,188 @@
+/// @file LatencyStats.hpp
+/// @brief Lock-free latency histograms used to attribute the time a frame spends in each stage between the SDK
+/// callback and the return from publish.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Log-linear histogram of durations in nanoseconds with lock-free recording.
+/// Durations are bucketed by power of two with c_SubBuckets linear steps per power, so percentiles are accurate to
+/// about 12%. Record() can be called from any thread; TakeWindow() reads and clears the counters and is meant to be
+/// called periodically from a single reporting thread. Samples recorded while a window is taken may end up in either
+/// window, which is fine for statistics.
+class LatencyHistogram
+{
+public:
+	struct Summary
+	{
+		uint64_t count = 0;
+		double meanUs = 0.0;
+		double p50Us = 0.0;
+		double p90Us = 0.0;
+		double p99Us = 0.0;
+		double maxUs = 0.0;
+	};
+
+	void Record(int64_t p_Ns)
+	{
+		const uint64_t t_Ns = p_Ns > 0 ? (uint64_t)p_Ns : 0;
+		m_Buckets[BucketIndex(t_Ns)].fetch_add(1, std::memory_order_relaxed);
+		m_SumNs.fetch_add(t_Ns, std::memory_order_relaxed);
+		uint64_t t_Max = m_MaxNs.load(std::memory_order_relaxed);
+		while (t_Ns > t_Max && !m_MaxNs.compare_exchange_weak(t_Max, t_Ns, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	/// @brief Returns the percentiles of the samples recorded since the last call and clears the histogram.
+	Summary TakeWindow()
+	{
+		std::array<uint64_t, c_BucketCount> t_Counts;
+		uint64_t t_Total = 0;
+		for (size_t i = 0; i < c_BucketCount; i++)
+		{
+			t_Counts[i] = m_Buckets[i].exchange(0, std::memory_order_relaxed);
+			t_Total += t_Counts[i];
+		}
+		const uint64_t t_SumNs = m_SumNs.exchange(0, std::memory_order_relaxed);
+		const uint64_t t_MaxNs = m_MaxNs.exchange(0, std::memory_order_relaxed);
+
+		Summary t_Summary;
+		t_Summary.count = t_Total;
+		if (t_Total == 0) return t_Summary;
+
+		t_Summary.meanUs = (double)t_SumNs / (double)t_Total / 1000.0;
+		t_Summary.maxUs = (double)t_MaxNs / 1000.0;
+		t_Summary.p50Us = Percentile(t_Counts, t_Total, 0.50, t_MaxNs);
+		t_Summary.p90Us = Percentile(t_Counts, t_Total, 0.90, t_MaxNs);
+		t_Summary.p99Us = Percentile(t_Counts, t_Total, 0.99, t_MaxNs);
+		return t_Summary;
+	}
+
+private:
+	static constexpr uint32_t c_SubBucketBits = 3;
+	static constexpr uint32_t c_SubBuckets = 1u << c_SubBucketBits;
+	static constexpr uint32_t c_MaxExponent = 40; // ~36 minutes, anything longer lands in the last bucket
+	static constexpr size_t c_BucketCount = (c_MaxExponent + 1) * c_SubBuckets;
+
+	static size_t BucketIndex(uint64_t p_Ns)
+	{
+		if (p_Ns < c_SubBuckets) return (size_t)p_Ns;
+		const uint32_t t_Exponent = 63 - (uint32_t)__builtin_clzll(p_Ns); // p_Ns >= c_SubBuckets so exponent >= 3
+		if (t_Exponent > c_MaxExponent) return c_BucketCount - 1;
+		const uint32_t t_Shift = t_Exponent - c_SubBucketBits;
+		const uint32_t t_Sub = (uint32_t)(p_Ns >> t_Shift) & (c_SubBuckets - 1);
+		return (size_t)(t_Exponent - c_SubBucketBits + 1) * c_SubBuckets + t_Sub;
+	}
+
+	/// @brief Upper bound in nanoseconds of the values that land in a bucket.
+	static uint64_t BucketUpperNs(size_t p_Index)
+	{
+		if (p_Index < c_SubBuckets) return p_Index;
+		const uint32_t t_Exponent = (uint32_t)(p_Index / c_SubBuckets) + c_SubBucketBits - 1;
+		const uint64_t t_Sub = p_Index % c_SubBuckets;
+		const uint32_t t_Shift = t_Exponent - c_SubBucketBits;
+		return ((c_SubBuckets + t_Sub + 1) << t_Shift) - 1;
+	}
+
+	static double Percentile(const std::array<uint64_t, c_BucketCount>& p_Counts, uint64_t p_Total, double p_Fraction, uint64_t p_MaxNs)
+	{
+		const uint64_t t_Rank = (uint64_t)(p_Fraction * (double)(p_Total - 1)) + 1;
+		uint64_t t_Seen = 0;
+		for (size_t i = 0; i < c_BucketCount; i++)
+		{
+			t_Seen += p_Counts[i];
+			if (t_Seen >= t_Rank)
+			{
+				const uint64_t t_Upper = BucketUpperNs(i);
+				return (double)(t_Upper < p_MaxNs ? t_Upper : p_MaxNs) / 1000.0;
+			}
+		}
+		return (double)p_MaxNs / 1000.0;
+	}
+
+	std::array<std::atomic<uint64_t>, c_BucketCount> m_Buckets{};
+	std::atomic<uint64_t> m_SumNs{ 0 };
+	std::atomic<uint64_t> m_MaxNs{ 0 };
+};
+
+/// @brief Streams whose latency is tracked per stage.
+enum class LatencyStream : int
+{
+	Skeleton = 0,
+	Ergonomics,
+	Tracker,
+	Gesture,
+	RawSkeleton,
+
+	Count
+};
+
+/// @brief Stages of a frame between the SDK callback and the return from publish.
+enum class LatencyStage : int
+{
+	Queue = 0, // SDK callback entry -> buffer swap in SDKMinimalClient::Run()
+	Convert,   // buffer swap -> end of the matching convert*DataToROS, excluding filtering and publish calls
+	Filter,    // time spent filtering and predicting
+	Publish,   // time spent inside publish calls
+	Total,     // SDK callback entry -> return from the last publish
+
+	Count
+};
+
+inline const char* LatencyStreamName(LatencyStream p_Stream)
+{
+	switch (p_Stream)
+	{
+	case LatencyStream::Skeleton: return "skeleton";
+	case LatencyStream::Ergonomics: return "ergonomics";
+	case LatencyStream::Tracker: return "tracker";
+	case LatencyStream::Gesture: return "gesture";
+	case LatencyStream::RawSkeleton: return "raw_skeleton";
+	default: return "unknown";
+	}
+}
+
+inline const char* LatencyStageName(LatencyStage p_Stage)
+{
+	switch (p_Stage)
+	{
+	case LatencyStage::Queue: return "queue";
+	case LatencyStage::Convert: return "convert";
+	case LatencyStage::Filter: return "filter";
+	case LatencyStage::Publish: return "publish";
+	case LatencyStage::Total: return "total";
+	default: return "unknown";
+	}
+}
+
+/// @brief One histogram per stream and stage.
+class PipelineLatency
+{
+public:
+	/// @brief Records the stages of one frame from its four timestamps, all on the steady clock.
+	/// @param p_FilterNs Time spent filtering and predicting between the swap and p_DoneNs, not recorded if 0.
+	/// @param p_PublishNs Time spent inside publish calls between the swap and p_DoneNs.
+	void RecordFrame(LatencyStream p_Stream, int64_t p_CallbackNs, int64_t p_SwapNs, int64_t p_FilterNs, int64_t p_PublishNs, int64_t p_DoneNs)
+	{
+		const int64_t t_ConvertedNs = p_DoneNs - p_PublishNs - p_FilterNs;
+		Get(p_Stream, LatencyStage::Queue).Record(p_SwapNs - p_CallbackNs);
+		Get(p_Stream, LatencyStage::Convert).Record(t_ConvertedNs - p_SwapNs);
+		if (p_FilterNs > 0) Get(p_Stream, LatencyStage::Filter).Record(p_FilterNs);
+		Get(p_Stream, LatencyStage::Publish).Record(p_PublishNs);
+		Get(p_Stream, LatencyStage::Total).Record(p_DoneNs - p_CallbackNs);
+	}
+
+	LatencyHistogram& Get(LatencyStream p_Stream, LatencyStage p_Stage)
+	{
+		return m_Histograms[(size_t)p_Stream * (size_t)LatencyStage::Count + (size_t)p_Stage];
+	}
+
+private:
+	std::array<LatencyHistogram, (size_t)LatencyStream::Count * (size_t)LatencyStage::Count> m_Histograms;
+};
@@ -0,0 +1,180 @@
+/// @file ManusClock.hpp
+/// @brief Conversion of Manus Core timestamps to local time, and an estimator for the offset and skew between the
+/// Manus Core host clock and the local clock.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "ManusSDK.h"
+
+
+/// @brief Current local wall clock time in nanoseconds since the Unix epoch.
+/// This is the clock rclcpp::Node::now() follows when use_sim_time is off.
+inline int64_t SystemNowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/// @brief Days since 1970-01-01 for a proleptic Gregorian calendar date (Howard Hinnant's days_from_civil).
+inline int64_t DaysFromCivil(int64_t p_Year, uint32_t p_Month, uint32_t p_Day)
+{
+	p_Year -= p_Month <= 2 ? 1 : 0;
+	const int64_t t_Era = (p_Year >= 0 ? p_Year : p_Year - 399) / 400;
+	const uint32_t t_YearOfEra = (uint32_t)(p_Year - t_Era * 400);
+	const uint32_t t_DayOfYear = (153 * (p_Month > 2 ? p_Month - 3 : p_Month + 9) + 2) / 5 + p_Day - 1;
+	const uint32_t t_DayOfEra = t_YearOfEra * 365 + t_YearOfEra / 4 - t_YearOfEra / 100 + t_DayOfYear;
+	return t_Era * 146097 + (int64_t)t_DayOfEra - 719468;
+}
+
+/// @brief Converts a Manus timestamp (UTC on the Core host) to nanoseconds since the Unix epoch.
+/// @return false if the timestamp is unset, is a timecode rather than a date, or could not be decoded.
+inline bool ManusTimestampToUnixNs(const ManusTimestamp& p_Timestamp, int64_t& p_UnixNs)
+{
+	if (p_Timestamp.time == 0) return false;
+
+	ManusTimestampInfo t_Info;
+	if (CoreSdk_GetTimestampInfo(p_Timestamp, &t_Info) != SDKReturnCode::SDKReturnCode_Success) return false;
+	if (t_Info.timecode || t_Info.month == 0 || t_Info.day == 0) return false;
+
+	const int64_t t_Days = DaysFromCivil(t_Info.year, t_Info.month, t_Info.day);
+	const int64_t t_Seconds = ((t_Days * 24 + t_Info.hour) * 60 + t_Info.minute) * 60 + t_Info.second;
+	p_UnixNs = t_Seconds * 1000000000LL + (int64_t)t_Info.fraction * 1000000LL; // fraction is milliseconds
+	return true;
+}
+
+/// @brief Estimates how the Manus Core host clock maps onto the local clock.
+/// Each sample is the local receive time minus the Core publish time of a frame, which is the clock offset plus a
+/// varying transport delay. Taking the minimum of each window keeps the samples closest to the pure offset, and a
+/// least squares fit with exponential forgetting over the window minima tracks the skew between the two clocks.
+/// Not thread safe: feed and query it from the publishing thread only.
+class ClockOffsetEstimator
+{
+public:
+	explicit ClockOffsetEstimator(int64_t p_WindowNs = 1000000000LL, double p_Forgetting = 0.95, int64_t p_StepThresholdNs = 100000000LL)
+		: m_WindowNs(p_WindowNs), m_Forgetting(p_Forgetting), m_StepThresholdNs(p_StepThresholdNs)
+	{
+	}
+
+	void AddSample(int64_t p_RemoteNs, int64_t p_LocalNs)
+	{
+		const int64_t t_OffsetNs = p_LocalNs - p_RemoteNs;
+		m_LastRawOffsetNs = t_OffsetNs;
+
+		// A sample well below the fit means one of the clocks was stepped, start over.
+		if (m_FitCount > 0 && (double)t_OffsetNs < OffsetAtNs(p_RemoteNs) - (double)m_StepThresholdNs)
+		{
+			Reset();
+			m_LastRawOffsetNs = t_OffsetNs;
+		}
+
+		if (m_SampleCount++ == 0)
+		{
+			m_ReferenceNs = p_RemoteNs;
+			m_WindowStartNs = p_RemoteNs;
+		}
+
+		if (!m_WindowHasSample || t_OffsetNs < m_WindowMinOffsetNs)
+		{
+			m_WindowMinOffsetNs = t_OffsetNs;
+			m_WindowMinRemoteNs = p_RemoteNs;
+			m_WindowHasSample = true;
+		}
+
+		if (p_RemoteNs - m_WindowStartNs >= m_WindowNs)
+		{
+			// The transport delay only ever raises samples, so a whole window staying well above the fit means the
+			// clocks were stepped the other way. Start over from this window rather than dragging the fit along.
+			if (m_FitCount > 0 && (double)m_WindowMinOffsetNs > OffsetAtNs(m_WindowMinRemoteNs) + (double)m_StepThresholdNs)
+			{
+				const int64_t t_MinOffsetNs = m_WindowMinOffsetNs;
+				const int64_t t_MinRemoteNs = m_WindowMinRemoteNs;
+				const uint64_t t_SampleCount = m_SampleCount;
+				Reset();
+				m_SampleCount = t_SampleCount;
+				m_ReferenceNs = t_MinRemoteNs;
+				m_WindowMinOffsetNs = t_MinOffsetNs;
+				m_WindowMinRemoteNs = t_MinRemoteNs;
+				m_WindowHasSample = true;
+			}
+			CloseWindow();
+			m_WindowStartNs = p_RemoteNs;
+		}
+	}
+
+	/// @brief Maps a Core time to the local clock.
+	int64_t ToLocalNs(int64_t p_RemoteNs) const { return p_RemoteNs + (int64_t)OffsetAtNs(p_RemoteNs); }
+
+	/// @brief Estimated offset (local - Core) at the given Core time, in nanoseconds.
+	double OffsetAtNs(int64_t p_RemoteNs) const
+	{
+		if (m_FitCount == 0)
+		{
+			return m_WindowHasSample ? (double)m_WindowMinOffsetNs : (double)m_LastRawOffsetNs;
+		}
+		return m_Intercept + m_Slope * SecondsSinceReference(p_RemoteNs);
+	}
+
+	bool IsValid() const { return m_SampleCount > 0; }
+	uint64_t SampleCount() const { return m_SampleCount; }
+	int64_t LastRawOffsetNs() const { return m_LastRawOffsetNs; }
+
+	/// @brief Rate at which the Core clock drifts relative to the local clock, in parts per million.
+	double SkewPpm() const { return m_Slope / 1000.0; } // ns per second -> ppm
+
+	void Reset()
+	{
+		m_SampleCount = 0;
+		m_FitCount = 0;
+		m_WindowHasSample = false;
+		m_Sw = m_Sx = m_Sy = m_Sxx = m_Sxy = 0.0;
+		m_Intercept = m_Slope = 0.0;
+	}
+
+private:
+	double SecondsSinceReference(int64_t p_RemoteNs) const { return (double)(p_RemoteNs - m_ReferenceNs) * 1e-9; }
+
+	void CloseWindow()
+	{
+		const double t_X = SecondsSinceReference(m_WindowMinRemoteNs);
+		const double t_Y = (double)m_WindowMinOffsetNs;
+		m_Sw = m_Forgetting * m_Sw + 1.0;
+		m_Sx = m_Forgetting * m_Sx + t_X;
+		m_Sy = m_Forgetting * m_Sy + t_Y;
+		m_Sxx = m_Forgetting * m_Sxx + t_X * t_X;
+		m_Sxy = m_Forgetting * m_Sxy + t_X * t_Y;
+
+		const double t_Denominator = m_Sw * m_Sxx - m_Sx * m_Sx;
+		if (m_FitCount > 0 && t_Denominator > 1e-9)
+		{
+			m_Slope = (m_Sw * m_Sxy - m_Sx * m_Sy) / t_Denominator;
+			m_Intercept = (m_Sy - m_Slope * m_Sx) / m_Sw;
+		}
+		else
+		{
+			m_Slope = 0.0;
+			m_Intercept = t_Y;
+		}
+		++m_FitCount;
+		m_WindowHasSample = false;
+	}
+
+	const int64_t m_WindowNs;
+	const double m_Forgetting;
+	const int64_t m_StepThresholdNs;
+
+	uint64_t m_SampleCount = 0;
+	uint64_t m_FitCount = 0;
+	int64_t m_ReferenceNs = 0;
+	int64_t m_LastRawOffsetNs = 0;
+
+	int64_t m_WindowStartNs = 0;
+	bool m_WindowHasSample = false;
+	int64_t m_WindowMinOffsetNs = 0;
+	int64_t m_WindowMinRemoteNs = 0;
+
+	double m_Sw = 0.0, m_Sx = 0.0, m_Sy = 0.0, m_Sxx = 0.0, m_Sxy = 0.0;
+	double m_Intercept = 0.0;
+	double m_Slope = 0.0;
+};
@@ -0,0 +1,402 @@
+/// @file MotionPredictor.hpp
+/// @brief Extrapolation of streamed poses a short time ahead, to hide part of the latency between the gloves and the
+/// robot, along with the error those predictions turned out to have.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+
+
+/// @brief Prediction errors of the frames recorded since the last TakeWindow(), accumulated lock-free.
+/// RecordFrame() is called from the publishing thread, TakeWindow() periodically from a single reporting thread.
+class PredictionErrorStats
+{
+public:
+	struct Summary
+	{
+		uint64_t count = 0;
+		double positionMean = 0.0; // meters
+		double positionMax = 0.0;
+		double rotationMean = 0.0; // radians
+		double rotationMax = 0.0;
+	};
+
+	/// @brief Adds the errors of p_Count predicted poses, given as sums and maxima in meters and radians.
+	void RecordFrame(uint64_t p_Count, double p_PositionSum, double p_PositionMax, double p_RotationSum, double p_RotationMax)
+	{
+		if (p_Count == 0) return;
+		m_Count.fetch_add(p_Count, std::memory_order_relaxed);
+		m_PositionSumNano.fetch_add(ToNano(p_PositionSum), std::memory_order_relaxed);
+		m_RotationSumNano.fetch_add(ToNano(p_RotationSum), std::memory_order_relaxed);
+		StoreMax(m_PositionMaxNano, ToNano(p_PositionMax));
+		StoreMax(m_RotationMaxNano, ToNano(p_RotationMax));
+	}
+
+	/// @brief Returns the errors recorded since the last call and clears them.
+	Summary TakeWindow()
+	{
+		Summary t_Summary;
+		t_Summary.count = m_Count.exchange(0, std::memory_order_relaxed);
+		const double t_PositionSum = (double)m_PositionSumNano.exchange(0, std::memory_order_relaxed) * 1e-9;
+		const double t_RotationSum = (double)m_RotationSumNano.exchange(0, std::memory_order_relaxed) * 1e-9;
+		t_Summary.positionMax = (double)m_PositionMaxNano.exchange(0, std::memory_order_relaxed) * 1e-9;
+		t_Summary.rotationMax = (double)m_RotationMaxNano.exchange(0, std::memory_order_relaxed) * 1e-9;
+		if (t_Summary.count == 0) return t_Summary;
+
+		t_Summary.positionMean = t_PositionSum / (double)t_Summary.count;
+		t_Summary.rotationMean = t_RotationSum / (double)t_Summary.count;
+		return t_Summary;
+	}
+
+private:
+	static uint64_t ToNano(double p_Value)
+	{
+		return p_Value > 0.0 ? (uint64_t)(p_Value * 1e9) : 0;
+	}
+
+	static void StoreMax(std::atomic<uint64_t>& p_Max, uint64_t p_Value)
+	{
+		uint64_t t_Max = p_Max.load(std::memory_order_relaxed);
+		while (p_Value > t_Max && !p_Max.compare_exchange_weak(t_Max, p_Value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	std::atomic<uint64_t> m_Count{ 0 };
+	std::atomic<uint64_t> m_PositionSumNano{ 0 };
+	std::atomic<uint64_t> m_RotationSumNano{ 0 };
+	std::atomic<uint64_t> m_PositionMaxNano{ 0 };
+	std::atomic<uint64_t> m_RotationMaxNano{ 0 };
+};
+
+/// @brief Predicts where a set of poses sampled together will be a look-ahead time after their sample time.
+/// Poses are passed as seven arrays, x, y, z, qx, qy, qz and qw, with one entry per element. From consecutive frames
+/// it estimates the linear velocity and the angular velocity (the log map of the rotation between the frames, divided
+/// by their time difference) of every element, low pass filtered, and replaces each pose with p + v h and
+/// exp(w h / 2) q. Every prediction is measured against the frame that arrives at its target time.
+/// As in SignalFilterBank, all state is structure of arrays and processed in blocks of c_Lanes elements. The log and
+/// exp maps use polynomials that are accurate to about 1e-7 for the rotations a frame and a look-ahead of at most
+/// c_MaxHorizonS cover. Not thread safe: use it from the publishing thread only.
+class PosePredictor
+{
+public:
+	static constexpr size_t c_Lanes = 4;
+	static constexpr double c_MaxHorizonS = 0.1;
+	static constexpr double c_MaxGapS = 0.25;
+	// Frames kept until the frame at their target time arrives. With more frames per look-ahead the oldest are
+	// dropped unmeasured.
+	static constexpr size_t c_MaxPending = 16;
+
+	/// @param p_VelocityCutoffHz Cutoff of the low pass on the estimated velocities.
+	void Configure(size_t p_Capacity, double p_VelocityCutoffHz)
+	{
+		m_Capacity = (p_Capacity + c_Lanes - 1) / c_Lanes * c_Lanes;
+		m_VelocityCutoffHz = p_VelocityCutoffHz;
+		m_State.assign(c_StateCount * m_Capacity, 0.0);
+		m_History.assign(c_MaxPending * c_HistoryCount * m_Capacity, 0.0f);
+		m_ResetFrame.assign(m_Capacity, 0);
+		m_Valid.assign(m_Capacity, 0.0);
+		m_Seed.assign(m_Capacity, 1);
+		m_PendingCount = 0;
+		m_LastTimeNs = 0;
+	}
+
+	/// @brief Restarts the velocity estimates of elements [p_Begin, p_End), whose next pose is published unchanged.
+	void Reset(size_t p_Begin, size_t p_End)
+	{
+		std::fill(m_Seed.begin() + std::min(p_Begin, m_Capacity), m_Seed.begin() + std::min(p_End, m_Capacity), 1);
+	}
+
+	/// @brief Replaces poses [0, p_Count) with their prediction p_HorizonS after p_TimeNs, after comparing them with
+	/// the earlier predictions made for this time.
+	/// @param p_Poses The seven component arrays. Each must hold p_Count rounded up to a multiple of c_Lanes elements.
+	/// @param p_HorizonS Look-ahead, clamped to c_MaxHorizonS. 0 leaves the poses unchanged.
+	void Process(double* const* p_Poses, size_t p_Count, int64_t p_TimeNs, double p_HorizonS, PredictionErrorStats& p_Stats)
+	{
+		if (p_Count == 0) return;
+		const size_t t_Count = std::min(p_Count, m_Capacity);
+		p_Count = std::min((p_Count + c_Lanes - 1) / c_Lanes * c_Lanes, m_Capacity);
+		p_HorizonS = std::min(std::max(p_HorizonS, 0.0), c_MaxHorizonS);
+
+		const double t_Dt = (double)(p_TimeNs - m_LastTimeNs) * 1e-9;
+		const bool t_Restart = m_LastTimeNs == 0 || t_Dt > c_MaxGapS || t_Dt < 0.0;
+		if (t_Restart)
+		{
+			Reset(0, m_Capacity);
+			m_PendingCount = 0;
+		}
+		else if (t_Dt > 0.0)
+		{
+			MeasurePredictions(p_Poses, p_Count, t_Count, p_TimeNs, t_Dt, p_Stats);
+		}
+		// A frame stamped like the last one carries no velocity, but is still extrapolated.
+		const bool t_Step = !t_Restart && t_Dt > 0.0;
+		if (t_Restart || t_Step) m_LastTimeNs = p_TimeNs;
+		m_Frame++;
+
+		SeedElements(p_Poses, p_Count);
+		if (t_Step) UpdateVelocities(p_Poses, p_Count, t_Dt);
+		if (p_HorizonS <= 0.0)
+		{
+			m_PendingCount = 0;
+			return;
+		}
+		StoreFrame(p_Poses, p_Count, p_TimeNs, p_HorizonS);
+		Extrapolate(p_Poses, p_Count, p_HorizonS);
+	}
+
+private:
+	using Block = Eigen::Array<double, c_Lanes, 1>;
+	using BlockMap = Eigen::Map<Block>;
+	using ConstBlockMap = Eigen::Map<const Block>;
+
+	// m_State holds, per element: the last pose (7), linear velocity (3) and angular velocity (3).
+	enum StateIndex : size_t
+	{
+		c_LastPose = 0,
+		c_Linear = 7,
+		c_Angular = 10,
+		c_StateCount = 13
+	};
+
+	double* State(size_t p_Index) { return &m_State[p_Index * m_Capacity]; }
+
+	/// @brief atan2(y, x) for y, x >= 0: atan of the smaller over the larger ratio, reduced to |t| <= tan(pi / 8) and
+	/// summed as a series to the 13th power, which is accurate to about 1e-7.
+	static Block Atan2Positive(const Block& p_Y, const Block& p_X)
+	{
+		const Block t_Ratio = p_Y.min(p_X) / p_Y.max(p_X).max(1e-300);
+		const auto t_Reduce = t_Ratio > 0.41421356237309503;
+		const Block t_T = t_Reduce.select((t_Ratio - 1.0) / (t_Ratio + 1.0), t_Ratio);
+		const Block t_T2 = t_T * t_T;
+		const Block t_Series = t_T * (1.0 + t_T2 * (-1.0 / 3 + t_T2 * (1.0 / 5 + t_T2 * (-1.0 / 7 + t_T2 * (1.0 / 9 + t_T2 * (-1.0 / 11 + t_T2 * (1.0 / 13)))))));
+		const Block t_Atan = t_Reduce.select(t_Series + M_PI / 4, t_Series);
+		return (p_Y > p_X).select(M_PI / 2 - t_Atan, t_Atan);
+	}
+
+	/// @brief sin(x) / x and cos(x) from their series in x^2, for x up to pi / 2. The coefficients are reciprocals, as
+	/// the compiler may not turn divisions by constants into multiplications.
+	static void SincCos(const Block& p_X2, Block& p_Sinc, Block& p_Cos)
+	{
+		p_Sinc = 1.0 - p_X2 * (1.0 / 6) * (1.0 - p_X2 * (1.0 / 20) * (1.0 - p_X2 * (1.0 / 42) * (1.0 - p_X2 * (1.0 / 72) * (1.0 - p_X2 * (1.0 / 110)))));
+		p_Cos = 1.0 - p_X2 * 0.5 * (1.0 - p_X2 * (1.0 / 12) * (1.0 - p_X2 * (1.0 / 30) * (1.0 - p_X2 * (1.0 / 56) * (1.0 - p_X2 * (1.0 / 90)))));
+	}
+
+	void SeedElements(double* const* p_Poses, size_t p_Count)
+	{
+		for (size_t i = 0; i < p_Count; i++)
+		{
+			if (!m_Seed[i]) continue;
+			m_Seed[i] = 0;
+			m_ResetFrame[i] = m_Frame;
+			for (size_t c = 0; c < 7; c++) State(c_LastPose + c)[i] = p_Poses[c][i];
+			for (size_t c = c_Linear; c < c_StateCount; c++) State(c)[i] = 0.0;
+		}
+	}
+
+	void UpdateVelocities(double* const* p_Poses, size_t p_Count, double p_Dt)
+	{
+		const double t_K = 2.0 * M_PI * m_VelocityCutoffHz * p_Dt;
+		const double t_Alpha = t_K / (t_K + 1.0);
+		const double t_InvDt = 1.0 / p_Dt;
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			for (size_t c = 0; c < 3; c++)
+			{
+				BlockMap t_Last(State(c_LastPose + c) + i);
+				BlockMap t_Velocity(State(c_Linear + c) + i);
+				const ConstBlockMap t_Position(p_Poses[c] + i);
+				t_Velocity += t_Alpha * ((t_Position - t_Last) * t_InvDt - t_Velocity);
+				t_Last = t_Position;
+			}
+
+			// Rotation from the last frame to this one, d = q * conj(p), in the hemisphere of the identity.
+			const ConstBlockMap qx(p_Poses[3] + i), qy(p_Poses[4] + i), qz(p_Poses[5] + i), qw(p_Poses[6] + i);
+			BlockMap px(State(c_LastPose + 3) + i), py(State(c_LastPose + 4) + i), pz(State(c_LastPose + 5) + i), pw(State(c_LastPose + 6) + i);
+			Block dw = qw * pw + qx * px + qy * py + qz * pz;
+			Block dx = -qw * px + qx * pw - qy * pz + qz * py;
+			Block dy = -qw * py + qx * pz + qy * pw - qz * px;
+			Block dz = -qw * pz - qx * py + qy * px + qz * pw;
+			const Block t_Sign = (dw < 0.0).select(Block::Constant(-1.0), Block::Constant(1.0));
+			dw *= t_Sign;
+			dx *= t_Sign;
+			dy *= t_Sign;
+			dz *= t_Sign;
+
+			// Log map: the axis scaled by the angle, 2 atan2(|v|, w) / |v| times v, which tends to 2 v / w.
+			const Block t_SinHalf = (dx * dx + dy * dy + dz * dz).sqrt();
+			const Block t_Scale = (t_SinHalf > 1e-12).select(2.0 * Atan2Positive(t_SinHalf, dw) / t_SinHalf.max(1e-12), 2.0 / dw.max(1e-12)) * t_InvDt;
+			BlockMap wx(State(c_Angular + 0) + i), wy(State(c_Angular + 1) + i), wz(State(c_Angular + 2) + i);
+			wx += t_Alpha * (dx * t_Scale - wx);
+			wy += t_Alpha * (dy * t_Scale - wy);
+			wz += t_Alpha * (dz * t_Scale - wz);
+
+			px = qx;
+			py = qy;
+			pz = qz;
+			pw = qw;
+		}
+	}
+
+	/// @brief Moves a block of poses ahead by p_H seconds at the given linear and angular velocities.
+	static void PredictBlock(Block (&p_Pose)[7], const Block (&p_Velocity)[6], double p_H)
+	{
+		for (size_t c = 0; c < 3; c++)
+		{
+			p_Pose[c] += p_H * p_Velocity[c];
+		}
+
+		// Exp map of w h / 2: (cos |x|, sin |x| / |x| * x) with x = w h / 2, the angle limited to pi / 2.
+		const Block &wx = p_Velocity[3], &wy = p_Velocity[4], &wz = p_Velocity[5];
+		const double t_HalfH = 0.5 * p_H;
+		const Block t_X2 = (wx * wx + wy * wy + wz * wz) * (t_HalfH * t_HalfH);
+		const Block t_Limit = (t_X2 > M_PI * M_PI / 4).select((M_PI * M_PI / 4) / t_X2.max(1e-300), Block::Constant(1.0)).sqrt();
+		Block t_Sinc, t_Cos;
+		SincCos(t_X2.min(M_PI * M_PI / 4), t_Sinc, t_Cos);
+		const Block t_Scale = t_Sinc * t_Limit * t_HalfH;
+		const Block ex = wx * t_Scale, ey = wy * t_Scale, ez = wz * t_Scale;
+
+		const Block qx = p_Pose[3], qy = p_Pose[4], qz = p_Pose[5], qw = p_Pose[6];
+		const Block t_W = t_Cos * qw - ex * qx - ey * qy - ez * qz;
+		const Block t_X = t_Cos * qx + ex * qw + ey * qz - ez * qy;
+		const Block t_Y = t_Cos * qy - ex * qz + ey * qw + ez * qx;
+		const Block t_Z = t_Cos * qz + ex * qy - ey * qx + ez * qw;
+		const Block t_InvNorm = (t_W * t_W + t_X * t_X + t_Y * t_Y + t_Z * t_Z).sqrt().max(1e-300).inverse();
+		p_Pose[3] = t_X * t_InvNorm;
+		p_Pose[4] = t_Y * t_InvNorm;
+		p_Pose[5] = t_Z * t_InvNorm;
+		p_Pose[6] = t_W * t_InvNorm;
+	}
+
+	void Extrapolate(double* const* p_Poses, size_t p_Count, double p_HorizonS)
+	{
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			Block t_Pose[7];
+			Block t_Velocity[6];
+			for (size_t c = 0; c < 7; c++) t_Pose[c] = ConstBlockMap(p_Poses[c] + i);
+			for (size_t c = 0; c < 6; c++) t_Velocity[c] = ConstBlockMap(State(c_Linear + c) + i);
+			PredictBlock(t_Pose, t_Velocity, p_HorizonS);
+			for (size_t c = 0; c < 7; c++) BlockMap(p_Poses[c] + i) = t_Pose[c];
+		}
+	}
+
+	/// @brief Keeps the poses and velocities of this frame, before prediction, to measure the prediction against the
+	/// frame that arrives at its target time.
+	void StoreFrame(double* const* p_Poses, size_t p_Count, int64_t p_TimeNs, double p_HorizonS)
+	{
+		if (m_PendingCount == c_MaxPending)
+		{
+			m_PendingFirst = (m_PendingFirst + 1) % c_MaxPending;
+			m_PendingCount--;
+		}
+		const size_t t_Slot = (m_PendingFirst + m_PendingCount) % c_MaxPending;
+		m_Pending[t_Slot] = { p_TimeNs, p_TimeNs + (int64_t)(p_HorizonS * 1e9), m_Frame };
+		float* t_Frame = &m_History[t_Slot * c_HistoryCount * m_Capacity];
+		for (size_t c = 0; c < 7; c++)
+		{
+			std::copy(p_Poses[c], p_Poses[c] + p_Count, t_Frame + c * m_Capacity);
+		}
+		for (size_t c = 0; c < 6; c++)
+		{
+			std::copy(State(c_Linear + c), State(c_Linear + c) + p_Count, t_Frame + (7 + c) * m_Capacity);
+		}
+		m_PendingCount++;
+	}
+
+	/// @brief Measures the prediction whose target time is nearest to this frame, within half a frame, and drops every
+	/// kept frame that is due. The kept frame is extrapolated by the time that actually passed since it, rather than
+	/// its look-ahead, so the error does not include the offset between the target and the frame times. Only elements
+	/// [0, p_Measured) are counted, the rest of the last block is padding.
+	void MeasurePredictions(double* const* p_Poses, size_t p_Count, size_t p_Measured, int64_t p_TimeNs, double p_Dt, PredictionErrorStats& p_Stats)
+	{
+		const int64_t t_HalfFrameNs = (int64_t)(p_Dt * 0.5e9);
+		size_t t_Match = c_MaxPending;
+		int64_t t_MatchDistance = t_HalfFrameNs + 1;
+		while (m_PendingCount > 0 && m_Pending[m_PendingFirst].targetNs <= p_TimeNs + t_HalfFrameNs)
+		{
+			const int64_t t_Distance = std::abs(m_Pending[m_PendingFirst].targetNs - p_TimeNs);
+			if (t_Distance < t_MatchDistance)
+			{
+				t_Match = m_PendingFirst;
+				t_MatchDistance = t_Distance;
+			}
+			m_PendingFirst = (m_PendingFirst + 1) % c_MaxPending;
+			m_PendingCount--;
+		}
+		if (t_Match == c_MaxPending) return;
+
+		// Elements restarted after the frame was kept have nothing to compare with.
+		uint64_t t_Count = 0;
+		for (size_t i = 0; i < p_Count; i++)
+		{
+			m_Valid[i] = (i < p_Measured && !m_Seed[i] && m_ResetFrame[i] < m_Pending[t_Match].frame) ? 1.0 : 0.0;
+			t_Count += m_Valid[i] != 0.0 ? 1 : 0;
+		}
+		if (t_Count == 0) return;
+
+		const float* t_Frame = &m_History[t_Match * c_HistoryCount * m_Capacity];
+		const double t_Elapsed = (double)(p_TimeNs - m_Pending[t_Match].sampleNs) * 1e-9;
+		Block t_PositionSum = Block::Zero(), t_PositionMax = Block::Zero(), t_RotationSum = Block::Zero(), t_RotationMax = Block::Zero();
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			Block t_Predicted[7];
+			Block t_Velocity[6];
+			for (size_t c = 0; c < 7; c++) t_Predicted[c] = Eigen::Map<const Eigen::Array<float, c_Lanes, 1>>(t_Frame + c * m_Capacity + i).cast<double>();
+			for (size_t c = 0; c < 6; c++) t_Velocity[c] = Eigen::Map<const Eigen::Array<float, c_Lanes, 1>>(t_Frame + (7 + c) * m_Capacity + i).cast<double>();
+			PredictBlock(t_Predicted, t_Velocity, t_Elapsed);
+			const ConstBlockMap t_Valid(&m_Valid[i]);
+
+			const Block t_Dx = ConstBlockMap(p_Poses[0] + i) - t_Predicted[0];
+			const Block t_Dy = ConstBlockMap(p_Poses[1] + i) - t_Predicted[1];
+			const Block t_Dz = ConstBlockMap(p_Poses[2] + i) - t_Predicted[2];
+			const Block t_Position = (t_Dx * t_Dx + t_Dy * t_Dy + t_Dz * t_Dz).sqrt() * t_Valid;
+
+			// Angle between the rotations, 2 atan2(|v|, |w|) of q * conj(p).
+			const ConstBlockMap qx(p_Poses[3] + i), qy(p_Poses[4] + i), qz(p_Poses[5] + i), qw(p_Poses[6] + i);
+			const Block &px = t_Predicted[3], &py = t_Predicted[4], &pz = t_Predicted[5], &pw = t_Predicted[6];
+			const Block dw = qw * pw + qx * px + qy * py + qz * pz;
+			const Block dx = -qw * px + qx * pw - qy * pz + qz * py;
+			const Block dy = -qw * py + qx * pz + qy * pw - qz * px;
+			const Block dz = -qw * pz - qx * py + qy * px + qz * pw;
+			const Block t_Rotation = 2.0 * Atan2Positive((dx * dx + dy * dy + dz * dz).sqrt(), dw.abs()) * t_Valid;
+
+			t_PositionSum += t_Position;
+			t_PositionMax = t_PositionMax.max(t_Position);
+			t_RotationSum += t_Rotation;
+			t_RotationMax = t_RotationMax.max(t_Rotation);
+		}
+		p_Stats.RecordFrame(t_Count, t_PositionSum.sum(), t_PositionMax.maxCoeff(), t_RotationSum.sum(), t_RotationMax.maxCoeff());
+	}
+
+	struct Pending
+	{
+		int64_t sampleNs;
+		int64_t targetNs;
+		uint64_t frame;
+	};
+
+	size_t m_Capacity = 0; // rounded up to whole blocks
+	double m_VelocityCutoffHz = 15.0;
+	std::vector<double> m_State;
+	// Ring of kept frames, the pose (7) and velocities (6) of each element, indexed
+	// [(slot * c_HistoryCount + component) * capacity + element]. Stored as float, which is plenty for measuring
+	// errors and halves the size.
+	static constexpr size_t c_HistoryCount = 13;
+	std::vector<float> m_History;
+	Pending m_Pending[c_MaxPending] = {};
+	size_t m_PendingFirst = 0;
+	size_t m_PendingCount = 0;
+	std::vector<uint64_t> m_ResetFrame;
+	std::vector<double> m_Valid;
+	std::vector<uint8_t> m_Seed;
+	uint64_t m_Frame = 1;
+	int64_t m_LastTimeNs = 0;
+};
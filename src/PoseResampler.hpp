@@ -0,0 +1,361 @@
+/// @file PoseResampler.hpp
+/// @brief Resampling of the pose streams onto a fixed rate: a short history of frames keyed by their Manus timestamps,
+/// interpolated at evenly spaced times a bounded delay behind the newest data, and the periodic schedule that drives it.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LatencyStats.hpp"
+
+
+enum class ResampleInterpolation : int
+{
+	Linear = 0, // positions on straight lines between the frames
+	Hermite     // positions on cubic Hermite curves through the frames, with the slopes of the neighbouring frames
+};
+
+/// @brief Parses the interpolation names used by the node parameters: linear and hermite.
+inline bool ParseResampleInterpolation(const std::string& p_Name, ResampleInterpolation& p_Interpolation)
+{
+	if (p_Name == "linear") p_Interpolation = ResampleInterpolation::Linear;
+	else if (p_Name == "hermite") p_Interpolation = ResampleInterpolation::Hermite;
+	else return false;
+	return true;
+}
+
+/// @brief The last few frames of a pose stream, to sample at any time in between.
+/// Poses are passed as seven arrays, x, y, z, qx, qy, qz and qw, with one entry per element. Elements come in groups of
+/// a fixed size, such as the nodes of a hand, each with a key that tells whether two frames hold the same thing there:
+/// a group is only interpolated between frames with the same key, otherwise it is taken from the nearest frame.
+/// Rotations are interpolated with SLERP. Frames are pushed from the publishing thread and sampled from the resampling
+/// thread, which both hold the lock for one copy of a frame.
+class PoseHistory
+{
+public:
+	static constexpr size_t c_MaxFrames = 8;
+	// Frames further apart are not interpolated between, the group is held at the nearest one.
+	static constexpr double c_MaxGapS = 0.25;
+	static constexpr uint32_t c_Absent = UINT32_MAX;
+
+	void Configure(size_t p_Capacity, size_t p_GroupSize)
+	{
+		std::lock_guard<std::mutex> t_Lock(m_Mutex);
+		m_Capacity = p_Capacity;
+		m_GroupSize = std::max<size_t>(p_GroupSize, 1);
+		m_GroupCapacity = (m_Capacity + m_GroupSize - 1) / m_GroupSize;
+		m_Poses.assign(c_MaxFrames * 7 * m_Capacity, 0.0);
+		m_Keys.assign(c_MaxFrames * m_GroupCapacity, c_Absent);
+		m_FrameCount = 0;
+		m_Newest = 0;
+	}
+
+	bool IsConfigured() const { return m_Capacity > 0; }
+
+	/// @brief Adds a frame. A frame older than the newest one is dropped, one at the same time replaces it.
+	/// @param p_Keys One key per group of p_Count elements, c_Absent for groups without data.
+	void Push(const double* const* p_Poses, size_t p_Count, const uint32_t* p_Keys, int64_t p_TimeNs)
+	{
+		p_Count = std::min(p_Count, m_Capacity);
+		std::lock_guard<std::mutex> t_Lock(m_Mutex);
+		size_t t_Slot = 0;
+		if (m_FrameCount > 0 && p_TimeNs <= m_Frames[m_Newest].timeNs)
+		{
+			if (p_TimeNs < m_Frames[m_Newest].timeNs) return;
+			t_Slot = m_Newest;
+		}
+		else
+		{
+			t_Slot = m_FrameCount > 0 ? (m_Newest + 1) % c_MaxFrames : 0;
+			m_Newest = t_Slot;
+			m_FrameCount = std::min(m_FrameCount + 1, c_MaxFrames);
+		}
+		m_Frames[t_Slot] = { p_TimeNs, p_Count };
+		for (size_t c = 0; c < 7; c++)
+		{
+			std::copy(p_Poses[c], p_Poses[c] + p_Count, Pose(t_Slot, c));
+		}
+		const size_t t_Groups = GroupCount(p_Count);
+		std::copy(p_Keys, p_Keys + t_Groups, &m_Keys[t_Slot * m_GroupCapacity]);
+	}
+
+	/// @brief Forgets every frame, such as when the stream restarts.
+	void Clear()
+	{
+		std::lock_guard<std::mutex> t_Lock(m_Mutex);
+		m_FrameCount = 0;
+	}
+
+	/// @brief Interpolates the poses at p_TimeNs into p_Out, and the key of every group into p_Keys.
+	/// Times past the newest frame hold the newest frame, times before the oldest the oldest.
+	/// @param p_Held Set when p_TimeNs is past the newest frame, so the poses are older than asked for.
+	/// @return The number of elements written, those of the frame nearest to p_TimeNs.
+	size_t Sample(int64_t p_TimeNs, ResampleInterpolation p_Interpolation, double* const* p_Out, uint32_t* p_Keys, bool& p_Held)
+	{
+		std::lock_guard<std::mutex> t_Lock(m_Mutex);
+		p_Held = false;
+		if (m_FrameCount == 0) return 0;
+
+		// Age 0 is the newest frame. Find the newest frame at or before the sample time.
+		size_t t_Before = 0;
+		while (t_Before < m_FrameCount && Frame(t_Before).timeNs > p_TimeNs) t_Before++;
+		if (t_Before == 0 || t_Before == m_FrameCount)
+		{
+			p_Held = t_Before == 0 && p_TimeNs > Frame(0).timeNs;
+			return CopyFrame(t_Before == 0 ? 0 : m_FrameCount - 1, p_Out, p_Keys);
+		}
+		const size_t t_After = t_Before - 1;
+		const FrameInfo& t_A = Frame(t_Before);
+		const FrameInfo& t_B = Frame(t_After);
+		const double t_Dt = (double)(t_B.timeNs - t_A.timeNs) * 1e-9;
+		const double t_U = (double)(p_TimeNs - t_A.timeNs) * 1e-9 / t_Dt;
+		const size_t t_Nearest = t_U < 0.5 ? t_Before : t_After;
+		if (t_Dt > c_MaxGapS) return CopyFrame(t_Nearest, p_Out, p_Keys);
+
+		const size_t t_Count = Frame(t_Nearest).count;
+		const size_t t_Shared = std::min(t_A.count, t_B.count);
+		// Neighbouring frames for the Hermite slopes, when they exist.
+		const bool t_HasPrevious = p_Interpolation == ResampleInterpolation::Hermite && t_Before + 1 < m_FrameCount &&
+			(double)(t_A.timeNs - Frame(t_Before + 1).timeNs) * 1e-9 <= c_MaxGapS;
+		const bool t_HasNext = p_Interpolation == ResampleInterpolation::Hermite && t_After > 0 &&
+			(double)(Frame(t_After - 1).timeNs - t_B.timeNs) * 1e-9 <= c_MaxGapS;
+
+		for (size_t g = 0; g < GroupCount(t_Count); g++)
+		{
+			const size_t t_First = g * m_GroupSize;
+			const size_t t_End = std::min(t_First + m_GroupSize, t_Count);
+			const uint32_t t_Key = Key(t_Before, g);
+			if (t_End > t_Shared || t_Key == c_Absent || t_Key != Key(t_After, g))
+			{
+				p_Keys[g] = Key(t_Nearest, g);
+				CopyElements(t_Nearest, t_First, t_End, p_Out);
+				continue;
+			}
+			p_Keys[g] = t_Key;
+			if (p_Interpolation == ResampleInterpolation::Hermite)
+			{
+				const bool t_Previous = t_HasPrevious && Frame(t_Before + 1).count >= t_End && Key(t_Before + 1, g) == t_Key;
+				const bool t_Next = t_HasNext && Frame(t_After - 1).count >= t_End && Key(t_After - 1, g) == t_Key;
+				HermitePositions(t_Before, t_After, t_Previous, t_Next, t_U, t_First, t_End, p_Out);
+			}
+			else
+			{
+				LinearPositions(t_Before, t_After, t_U, t_First, t_End, p_Out);
+			}
+			SlerpRotations(t_Before, t_After, t_U, t_First, t_End, p_Out);
+		}
+		return t_Count;
+	}
+
+	/// @brief Spherical linear interpolation from p_A to p_B, both x, y, z, w, along the shorter arc.
+	static void Slerp(const double* p_A, const double* p_B, double p_U, double* p_Out)
+	{
+		double t_Dot = p_A[0] * p_B[0] + p_A[1] * p_B[1] + p_A[2] * p_B[2] + p_A[3] * p_B[3];
+		const double t_Sign = t_Dot < 0.0 ? -1.0 : 1.0;
+		t_Dot *= t_Sign;
+		double t_WeightA = 1.0 - p_U;
+		double t_WeightB = p_U * t_Sign;
+		// Nearly equal rotations: the weights tend to the linear ones, renormalized below.
+		if (t_Dot < 0.9995)
+		{
+			const double t_Angle = std::acos(t_Dot);
+			const double t_InvSin = 1.0 / std::sqrt(1.0 - t_Dot * t_Dot);
+			t_WeightA = std::sin((1.0 - p_U) * t_Angle) * t_InvSin;
+			t_WeightB = std::sin(p_U * t_Angle) * t_InvSin * t_Sign;
+		}
+		double t_Norm = 0.0;
+		for (int c = 0; c < 4; c++)
+		{
+			p_Out[c] = t_WeightA * p_A[c] + t_WeightB * p_B[c];
+			t_Norm += p_Out[c] * p_Out[c];
+		}
+		const double t_InvNorm = t_Norm > 0.0 ? 1.0 / std::sqrt(t_Norm) : 0.0;
+		for (int c = 0; c < 4; c++) p_Out[c] *= t_InvNorm;
+	}
+
+private:
+	struct FrameInfo
+	{
+		int64_t timeNs;
+		size_t count;
+	};
+
+	size_t GroupCount(size_t p_Count) const { return (p_Count + m_GroupSize - 1) / m_GroupSize; }
+	size_t Slot(size_t p_Age) const { return (m_Newest + c_MaxFrames - p_Age) % c_MaxFrames; }
+	const FrameInfo& Frame(size_t p_Age) const { return m_Frames[Slot(p_Age)]; }
+	double* Pose(size_t p_Slot, size_t p_Component) { return &m_Poses[(p_Slot * 7 + p_Component) * m_Capacity]; }
+	const double* PoseAt(size_t p_Age, size_t p_Component) { return Pose(Slot(p_Age), p_Component); }
+	uint32_t Key(size_t p_Age, size_t p_Group) const { return m_Keys[Slot(p_Age) * m_GroupCapacity + p_Group]; }
+
+	size_t CopyFrame(size_t p_Age, double* const* p_Out, uint32_t* p_Keys)
+	{
+		const size_t t_Count = Frame(p_Age).count;
+		CopyElements(p_Age, 0, t_Count, p_Out);
+		for (size_t g = 0; g < GroupCount(t_Count); g++) p_Keys[g] = Key(p_Age, g);
+		return t_Count;
+	}
+
+	void CopyElements(size_t p_Age, size_t p_Begin, size_t p_End, double* const* p_Out)
+	{
+		for (size_t c = 0; c < 7; c++)
+		{
+			const double* t_Source = PoseAt(p_Age, c);
+			std::copy(t_Source + p_Begin, t_Source + p_End, p_Out[c] + p_Begin);
+		}
+	}
+
+	void LinearPositions(size_t p_A, size_t p_B, double p_U, size_t p_Begin, size_t p_End, double* const* p_Out)
+	{
+		for (size_t c = 0; c < 3; c++)
+		{
+			const double* t_A = PoseAt(p_A, c);
+			const double* t_B = PoseAt(p_B, c);
+			for (size_t i = p_Begin; i < p_End; i++) p_Out[c][i] = t_A[i] + p_U * (t_B[i] - t_A[i]);
+		}
+	}
+
+	/// @brief Cubic Hermite between frames A and B, with the slope at each taken across its neighbours (Catmull-Rom
+	/// for uneven spacing), or the slope from A to B where a neighbour is missing.
+	void HermitePositions(size_t p_A, size_t p_B, bool p_Previous, bool p_Next, double p_U, size_t p_Begin, size_t p_End, double* const* p_Out)
+	{
+		const int64_t t_TimeA = Frame(p_A).timeNs;
+		const int64_t t_TimeB = Frame(p_B).timeNs;
+		const double t_Dt = (double)(t_TimeB - t_TimeA) * 1e-9;
+		// Both slopes are used scaled by the interval, so they are kept as ratios of it.
+		const double t_ScaleA = p_Previous ? t_Dt / ((double)(t_TimeB - Frame(p_A + 1).timeNs) * 1e-9) : 1.0;
+		const double t_ScaleB = p_Next ? t_Dt / ((double)(Frame(p_B - 1).timeNs - t_TimeA) * 1e-9) : 1.0;
+		const double t_U2 = p_U * p_U, t_U3 = t_U2 * p_U;
+		const double t_H00 = 2.0 * t_U3 - 3.0 * t_U2 + 1.0;
+		const double t_H10 = t_U3 - 2.0 * t_U2 + p_U;
+		const double t_H01 = -2.0 * t_U3 + 3.0 * t_U2;
+		const double t_H11 = t_U3 - t_U2;
+		for (size_t c = 0; c < 3; c++)
+		{
+			const double* t_A = PoseAt(p_A, c);
+			const double* t_B = PoseAt(p_B, c);
+			const double* t_Previous = p_Previous ? PoseAt(p_A + 1, c) : t_A;
+			const double* t_Next = p_Next ? PoseAt(p_B - 1, c) : t_B;
+			for (size_t i = p_Begin; i < p_End; i++)
+			{
+				const double t_SlopeA = (t_B[i] - t_Previous[i]) * t_ScaleA;
+				const double t_SlopeB = (t_Next[i] - t_A[i]) * t_ScaleB;
+				p_Out[c][i] = t_H00 * t_A[i] + t_H10 * t_SlopeA + t_H01 * t_B[i] + t_H11 * t_SlopeB;
+			}
+		}
+	}
+
+	void SlerpRotations(size_t p_A, size_t p_B, double p_U, size_t p_Begin, size_t p_End, double* const* p_Out)
+	{
+		const double* t_A[4] = { PoseAt(p_A, 3), PoseAt(p_A, 4), PoseAt(p_A, 5), PoseAt(p_A, 6) };
+		const double* t_B[4] = { PoseAt(p_B, 3), PoseAt(p_B, 4), PoseAt(p_B, 5), PoseAt(p_B, 6) };
+		for (size_t i = p_Begin; i < p_End; i++)
+		{
+			const double t_QA[4] = { t_A[0][i], t_A[1][i], t_A[2][i], t_A[3][i] };
+			const double t_QB[4] = { t_B[0][i], t_B[1][i], t_B[2][i], t_B[3][i] };
+			double t_Q[4];
+			Slerp(t_QA, t_QB, p_U, t_Q);
+			for (size_t c = 0; c < 4; c++) p_Out[3 + c][i] = t_Q[c];
+		}
+	}
+
+	std::mutex m_Mutex;
+	size_t m_Capacity = 0;
+	size_t m_GroupSize = 1;
+	size_t m_GroupCapacity = 0;
+	// Ring of frames, indexed [(slot * 7 + component) * capacity + element] and [slot * group capacity + group].
+	std::vector<double> m_Poses;
+	std::vector<uint32_t> m_Keys;
+	FrameInfo m_Frames[c_MaxFrames] = {};
+	size_t m_FrameCount = 0;
+	size_t m_Newest = 0;
+};
+
+/// @brief Wakes a thread at a fixed period on the monotonic clock. Deadlines are absolute, so the time spent per tick
+/// does not make the period drift, and ticks that are already over by the time the thread wakes are skipped.
+class PeriodicSchedule
+{
+public:
+	void Start(int64_t p_PeriodNs)
+	{
+		m_PeriodNs = std::max<int64_t>(p_PeriodNs, 1);
+		m_DeadlineNs = MonotonicNowNs() + m_PeriodNs;
+	}
+
+	/// @brief Sleeps until the next deadline.
+	/// @param p_LateNs Set to how late the thread woke past the deadline.
+	/// @return The number of deadlines skipped because the previous tick overran them.
+	uint64_t WaitNext(int64_t& p_LateNs)
+	{
+		timespec t_Deadline;
+		t_Deadline.tv_sec = (time_t)(m_DeadlineNs / 1000000000);
+		t_Deadline.tv_nsec = (long)(m_DeadlineNs % 1000000000);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t_Deadline, nullptr) == EINTR)
+		{
+		}
+		const int64_t t_NowNs = MonotonicNowNs();
+		p_LateNs = t_NowNs - m_DeadlineNs;
+		m_TickNs = m_DeadlineNs;
+		const uint64_t t_Skipped = (uint64_t)(p_LateNs / m_PeriodNs);
+		m_DeadlineNs += (int64_t)(t_Skipped + 1) * m_PeriodNs;
+		return t_Skipped;
+	}
+
+	/// @brief Deadline of the tick WaitNext() last returned for.
+	int64_t TickNs() const { return m_TickNs; }
+
+	static int64_t MonotonicNowNs()
+	{
+		timespec t_Now;
+		clock_gettime(CLOCK_MONOTONIC, &t_Now);
+		return (int64_t)t_Now.tv_sec * 1000000000 + t_Now.tv_nsec;
+	}
+
+private:
+	int64_t m_PeriodNs = 1;
+	int64_t m_DeadlineNs = 0;
+	int64_t m_TickNs = 0;
+};
+
+/// @brief How the resampling thread kept to its schedule. Written by the resampling thread and read by the reporting
+/// timer.
+class ResampleStats
+{
+public:
+	void Record(int64_t p_LateNs, uint64_t p_Skipped, bool p_Held)
+	{
+		m_Late.Record(p_LateNs);
+		m_Skipped.fetch_add(p_Skipped, std::memory_order_relaxed);
+		m_Held.fetch_add(p_Held ? 1 : 0, std::memory_order_relaxed);
+	}
+
+	struct Summary
+	{
+		LatencyHistogram::Summary late; // how late the thread woke past each deadline, one sample per tick
+		uint64_t skipped = 0;           // ticks dropped because an earlier one overran
+		uint64_t held = 0;              // ticks that had no frame past their sample time, so repeated older poses
+	};
+
+	/// @brief Returns the statistics gathered since the last call and starts a new window.
+	Summary TakeWindow()
+	{
+		Summary t_Summary;
+		t_Summary.late = m_Late.TakeWindow();
+		t_Summary.skipped = m_Skipped.exchange(0, std::memory_order_relaxed);
+		t_Summary.held = m_Held.exchange(0, std::memory_order_relaxed);
+		return t_Summary;
+	}
+
+private:
+	LatencyHistogram m_Late;
+	std::atomic<uint64_t> m_Skipped{ 0 };
+	std::atomic<uint64_t> m_Held{ 0 };
+};
@@ -1,9 +1,18 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <thread>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 
+#include <arpa/inet.h>
+#include <sys/stat.h>
+
 #include "SDKMinimalClient.hpp"
+#include "HandSkeletonLayout.hpp"
 #include "ManusSDKTypes.h"
 
 
@@ -11,15 +20,17 @@
 // Manus Hand functionality from here down
 // Initialize the static member variable
 SDKMinimalClient *SDKMinimalClient::s_Instance = nullptr;
+StreamDataSource *SDKMinimalClient::s_DataSource = nullptr;
 
-SDKMinimalClient::SDKMinimalClient(std::shared_ptr<rclcpp::Node> publisher)
-	: m_PublisherNode(publisher)
+SDKMinimalClient::SDKMinimalClient(rclcpp::Node& publisher)
+	: m_PublisherNode(&publisher)
 {
 	s_Instance = this;
 }
 
 SDKMinimalClient::~SDKMinimalClient()
 {
+	StopConnecting();
 	s_Instance = nullptr;
 }
 
@@ -92,6 +103,8 @@ ClientReturnCode SDKMinimalClient::InitializeSDK()
 /// after this is called it is expected to exit the client program. If not it needs to call initialize again.
 ClientReturnCode SDKMinimalClient::ShutDown()
 {
+	StopConnecting();
+
 	const SDKReturnCode t_Result = CoreSdk_ShutDown();
 	if (t_Result != SDKReturnCode::SDKReturnCode_Success)
 	{
@@ -99,6 +112,9 @@ ClientReturnCode SDKMinimalClient::ShutDown()
 		return ClientReturnCode::ClientReturnCode_FailedToShutDownSDK;
 	}
 
+	// The callbacks have stopped, so the recording can be finalized.
+	StopRecording();
+
 	/*if (!PlatformSpecificShutdown())
 	{
 		return ClientReturnCode::ClientReturnCode_FailedPlatformSpecificShutdown;
@@ -113,6 +129,21 @@ ClientReturnCode SDKMinimalClient::ShutDown()
 /// All of these are optional, but depending on what data you require you may or may not need all of them.
 ClientReturnCode SDKMinimalClient::RegisterAllCallbacks()
 {
+	// Register the callbacks for connecting to and disconnecting from a host, which drive the connection thread.
+	const SDKReturnCode t_RegisterConnectCallbackResult = CoreSdk_RegisterCallbackForOnConnect(*OnConnectedCallback);
+	if (t_RegisterConnectCallbackResult != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to register the connect callback");
+		return ClientReturnCode::ClientReturnCode_FailedToInitialize;
+	}
+
+	const SDKReturnCode t_RegisterDisconnectCallbackResult = CoreSdk_RegisterCallbackForOnDisconnect(*OnDisconnectedCallback);
+	if (t_RegisterDisconnectCallbackResult != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to register the disconnect callback");
+		return ClientReturnCode::ClientReturnCode_FailedToInitialize;
+	}
+
 	// Register the callback for when manus core is sending Skeleton data
 	// it is optional, but without it you can not see any resulting skeleton data.
 	// see OnSkeletonStreamCallback for more details.
@@ -144,76 +175,560 @@ ClientReturnCode SDKMinimalClient::RegisterAllCallbacks()
 		return ClientReturnCode::ClientReturnCode_FailedToInitialize;
 	}
 
+	// Raw skeletons cost Core an extra stream, so only ask for them when they are published.
+	if (m_RawSkeletons)
+	{
+		const SDKReturnCode t_RegisterRawSkeletonCallbackResult = CoreSdk_RegisterCallbackForRawSkeletonStream(*OnRawSkeletonStreamCallback);
+		if (t_RegisterRawSkeletonCallbackResult != SDKReturnCode::SDKReturnCode_Success)
+		{
+			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to register the raw skeleton callback");
+			return ClientReturnCode::ClientReturnCode_FailedToInitialize;
+		}
+	}
+
+	const SDKReturnCode t_RegisterGestureCallbackResult = CoreSdk_RegisterCallbackForGestureStream(*OnGestureStreamCallback);
+	if (t_RegisterGestureCallbackResult != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to register the gesture callback");
+		return ClientReturnCode::ClientReturnCode_FailedToInitialize;
+	}
+
 	return ClientReturnCode::ClientReturnCode_Success;
 }
 
-/// @brief This function is called when the SDK has connected to a host.
-/// This function is called when the SDK has connected to a host.  Split out from the original Run function.
-void SDKMinimalClient::ConnectToHost()
+/// @brief Starts the connection thread, see RunConnection().
+void SDKMinimalClient::StartConnecting()
 {
-	// first loop until we get a connection
-	std::cout << "minimal client is connecting to host. (make sure it is running)\n";
 	RCLCPP_INFO(m_PublisherNode->get_logger(), "Manus client is connecting to host. (make sure it is running)");
-	while (Connect() != ClientReturnCode::ClientReturnCode_Success)
+	m_StopConnecting = false;
+	m_ConnectionThread = std::thread([this]() { RunConnection(); });
+}
+
+void SDKMinimalClient::StopConnecting()
+{
+	if (!m_ConnectionThread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> t_Lock(m_ConnectionMutex);
+		m_StopConnecting = true;
+	}
+	m_ConnectionChanged.notify_all();
+	m_ConnectionThread.join();
+}
+
+/// @brief The connection state machine. Connects to a host, uploads the hand skeletons and waits for the first frame,
+/// then sleeps until the SDK reports the connection lost and starts over. Runs on its own thread, so ROS is up while
+/// Core is still being looked for and a lost connection recovers without restarting the node.
+void SDKMinimalClient::RunConnection()
+{
+	std::unique_lock<std::mutex> t_Lock(m_ConnectionMutex);
+	m_RecoverStartNs = FrameSignal::SteadyNowNs();
+	m_AwaitingFirstFrame = true;
+	while (!m_StopConnecting)
+	{
+		if (m_ConnectionLost)
+		{
+			m_ConnectionLost = false;
+			if (m_ConnectionState != ConnectionState::Disconnected)
+			{
+				RCLCPP_WARN(m_PublisherNode->get_logger(), "Manus client lost the connection to host. Reconnecting.");
+				m_ConnectionStatus.disconnectCount++;
+				m_RecoverStartNs = FrameSignal::SteadyNowNs();
+				m_FirstFrameSteadyNs = 0;
+				m_ConnectionStatus.recoverSeconds = 0.0;
+				m_AwaitingFirstFrame = true;
+				SetConnectionState(ConnectionState::Disconnected, t_Lock);
+				continue;
+			}
+		}
+
+		if (m_ConnectionState == ConnectionState::Streaming)
+		{
+			const int64_t t_FirstFrameNs = m_FirstFrameSteadyNs.exchange(0);
+			if (t_FirstFrameNs != 0)
+			{
+				m_ConnectionStatus.recoverSeconds = (double)(t_FirstFrameNs - m_RecoverStartNs) * 1e-9;
+				RCLCPP_INFO(m_PublisherNode->get_logger(), "First skeleton frame %.1f ms after %s",
+					m_ConnectionStatus.recoverSeconds * 1e3, m_ConnectionStatus.disconnectCount == 0 ? "starting to connect" : "losing the connection");
+				SetConnectionState(ConnectionState::Streaming, t_Lock);
+			}
+			// Poll for the first frame, otherwise sleep until the SDK reports a change.
+			m_ConnectionChanged.wait_for(t_Lock, m_AwaitingFirstFrame ? std::chrono::milliseconds(50) : std::chrono::milliseconds(1000),
+				[this]() { return m_StopConnecting || m_ConnectionLost; });
+			continue;
+		}
+
+		SetConnectionState(ConnectionState::Connecting, t_Lock);
+		t_Lock.unlock();
+		const bool t_Connected = Connect() == ClientReturnCode::ClientReturnCode_Success;
+		t_Lock.lock();
+		if (m_StopConnecting) break;
+		if (!t_Connected)
+		{
+			RCLCPP_WARN(m_PublisherNode->get_logger(), "Manus client could not connect. Trying again in %ld ms.", (long)m_ReconnectDelayMs);
+			SetConnectionState(ConnectionState::Disconnected, t_Lock);
+			m_ConnectionChanged.wait_for(t_Lock, std::chrono::milliseconds(m_ReconnectDelayMs), [this]() { return m_StopConnecting; });
+			m_ReconnectDelayMs = std::min(m_ReconnectDelayMs * 2, c_MaxReconnectDelayMs);
+			continue;
+		}
+		m_ReconnectDelayMs = c_MinReconnectDelayMs;
+
+		RCLCPP_INFO(m_PublisherNode->get_logger(), "Manus client connected to host.");
+		SetConnectionState(ConnectionState::LoadingSkeletons, t_Lock);
+		t_Lock.unlock();
+		LoadSkeletonsAfterConnect();
+		t_Lock.lock();
+		// A connection lost while loading is picked up at the top of the loop.
+		if (!m_ConnectionLost)
+		{
+			SetConnectionState(ConnectionState::Streaming, t_Lock);
+		}
+	}
+}
+
+/// @brief Updates the state and hands the status to the listener, without holding the lock while it runs.
+void SDKMinimalClient::SetConnectionState(ConnectionState p_State, std::unique_lock<std::mutex>& p_Lock)
+{
+	m_ConnectionState = p_State;
+	m_ConnectionStatus.state = p_State;
+	if (!m_ConnectionListener) return;
+	const ConnectionStatus t_Status = m_ConnectionStatus;
+	p_Lock.unlock();
+	m_ConnectionListener(t_Status);
+	p_Lock.lock();
+}
+
+/// @brief Uploads the hand skeletons of a new session. Those of the previous session went with it.
+void SDKMinimalClient::LoadSkeletonsAfterConnect()
+{
+	const int64_t t_StartNs = FrameSignal::SteadyNowNs();
+	m_SkeletonsRestored = 0;
+	m_SkeletonsBuilt = 0;
+	if (m_MultiUser)
+	{
+		// Users show up in the landscape shortly after connecting, UpdateUserSkeletons() keeps retrying until then.
+		{
+			std::lock_guard<std::mutex> t_Lock(m_UsersMutex);
+			m_UsersChanged = true;
+			m_LoadedUsers.clear();
+		}
+		UpdateUserSkeletons();
+	}
+	else
+	{
+		// Upload a simple skeleton with a chain. This will just be a pair of hands for the first user index.
+		LoadTestSkeleton();
+	}
+
+	// Users that show up later are loaded by UpdateUserSkeletons() and not counted here.
+	const uint32_t t_Restored = m_SkeletonsRestored;
+	const uint32_t t_Built = m_SkeletonsBuilt;
+	if (t_Restored + t_Built == 0) return;
+	const double t_Seconds = (double)(FrameSignal::SteadyNowNs() - t_StartNs) * 1e-9;
+	RCLCPP_INFO(m_PublisherNode->get_logger(), "Uploaded %u hand skeletons in %.1f ms, %u restored from the cache and %u built",
+		t_Restored + t_Built, t_Seconds * 1e3, t_Restored, t_Built);
+	std::lock_guard<std::mutex> t_Lock(m_ConnectionMutex);
+	m_ConnectionStatus.skeletonLoadSeconds = t_Seconds;
+	m_ConnectionStatus.skeletonsRestored = t_Restored;
+	m_ConnectionStatus.skeletonsBuilt = t_Built;
+}
+
+/// @brief Starts recording the raw SDK streams to p_Path.
+/// Must be called before the stream callbacks start, i.e. before connecting to a host.
+bool SDKMinimalClient::StartRecording(const std::string& p_Path, size_t p_CapacityBytes)
+{
+	std::string t_Error;
+	if (!m_Recorder.Open(p_Path, p_CapacityBytes, t_Error))
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to start recording: %s", t_Error.c_str());
+		return false;
+	}
+	RCLCPP_INFO(m_PublisherNode->get_logger(), "Recording SDK streams to %s (%zu MB preallocated)", p_Path.c_str(), p_CapacityBytes / (1024 * 1024));
+	return true;
+}
+
+/// @brief Gives the user a slot if it has none yet and routes its hand skeletons to it, replacing earlier ones.
+/// Also records them, as a replay needs them to tell the users and hands apart.
+void SDKMinimalClient::AddUserHandSkeletons(uint32_t p_UserID, uint32_t p_RightHandID, uint32_t p_LeftHandID)
+{
+	{
+		std::lock_guard<std::mutex> t_Lock(m_RoutesMutex);
+
+		const uint32_t t_UserCount = m_UserCount.load(std::memory_order_relaxed);
+		uint32_t t_Slot = 0;
+		while (t_Slot < t_UserCount && m_UserIDs[t_Slot].load(std::memory_order_relaxed) != p_UserID) t_Slot++;
+		if (t_Slot == t_UserCount)
+		{
+			if (t_UserCount == c_MaxUsers)
+			{
+				RCLCPP_ERROR(m_PublisherNode->get_logger(), "No slot left for the hand skeletons of user %u", p_UserID);
+				return;
+			}
+			m_UserIDs[t_Slot].store(p_UserID, std::memory_order_relaxed);
+			m_UserCount.store(t_UserCount + 1, std::memory_order_release);
+		}
+
+		m_RoutesMaster.RemoveUser(t_Slot);
+		m_RoutesMaster.Add({ p_RightHandID, p_UserID, t_Slot, true });
+		m_RoutesMaster.Add({ p_LeftHandID, p_UserID, t_Slot, false });
+		PublishRoutes();
+
+		if (t_Slot == 0)
+		{
+			m_GloveIDs[0] = p_RightHandID;
+			m_GloveIDs[1] = p_LeftHandID;
+		}
+	}
+
+	const HandSkeletonsRecordInfo t_HandSkeletons = { p_UserID, p_RightHandID, p_LeftHandID, 0 };
+	const StreamRecorder::Segment t_Segment = { &t_HandSkeletons, sizeof(t_HandSkeletons) };
+	m_Recorder.Append(StreamRecordType::HandSkeletons, FrameSignal::SteadyNowNs(), SystemNowNs(), &t_Segment, 1);
+}
+
+/// @brief Goes through the hand skeleton rather than the dongle, as that is what ties a glove to a user.
+bool SDKMinimalClient::VibrateFingers(uint32_t p_UserSlot, bool p_IsRightHand, const float* p_Powers)
+{
+	if (m_ConnectionState.load(std::memory_order_relaxed) != ConnectionState::Streaming) return false;
+
+	uint32_t t_SkeletonID = 0;
+	{
+		std::lock_guard<std::mutex> t_Lock(m_RoutesMutex);
+		const HandSkeletonRoute* t_Route = std::find_if(m_RoutesMaster.routes.begin(), m_RoutesMaster.routes.end(),
+			[&](const HandSkeletonRoute& p_Route) { return p_Route.userSlot == p_UserSlot && p_Route.isRightHand == p_IsRightHand; });
+		if (t_Route == m_RoutesMaster.routes.end()) return false;
+		t_SkeletonID = t_Route->skeletonID;
+	}
+
+	const SDKReturnCode t_Result = CoreSdk_VibrateFingersForSkeleton(t_SkeletonID, p_IsRightHand ? Side::Side_Right : Side::Side_Left, p_Powers);
+	return t_Result == SDKReturnCode::SDKReturnCode_Success;
+}
+
+/// @brief Stops routing the hand skeletons of a user. Its slot stays reserved for when it comes back.
+void SDKMinimalClient::RemoveUserHandSkeletons(uint32_t p_UserID)
+{
+	std::lock_guard<std::mutex> t_Lock(m_RoutesMutex);
+	const uint32_t t_UserCount = m_UserCount.load(std::memory_order_relaxed);
+	for (uint32_t t_Slot = 0; t_Slot < t_UserCount; t_Slot++)
+	{
+		if (m_UserIDs[t_Slot].load(std::memory_order_relaxed) != p_UserID) continue;
+		m_RoutesMaster.RemoveUser(t_Slot);
+		PublishRoutes();
+		return;
+	}
+}
+
+/// @brief Hands a copy of the routes to the publishing thread. Requires m_RoutesMutex.
+void SDKMinimalClient::PublishRoutes()
+{
+	m_RoutesBuffer.WriteBuffer() = m_RoutesMaster;
+	m_RoutesBuffer.Publish();
+}
+
+void SDKMinimalClient::UpdateUserSkeletons()
+{
+	std::lock_guard<std::mutex> t_Lock(m_UsersMutex);
+	// The connection thread loads them again once reconnected.
+	const ConnectionState t_State = m_ConnectionState.load(std::memory_order_relaxed);
+	if (t_State != ConnectionState::LoadingSkeletons && t_State != ConnectionState::Streaming) return;
+	if (!m_UsersChanged.exchange(false)) return;
+
+	uint32_t t_UserCount = 0;
+	SDKReturnCode t_Res = CoreSdk_GetNumberOfAvailableUsers(&t_UserCount);
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success)
 	{
-		RCLCPP_WARN(m_PublisherNode->get_logger(), "Manus client could not connect. Trying again in a second.");
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to get the number of available users. The error given was %d", (int)t_Res);
+		m_UsersChanged = true;
+		return;
+	}
+	if (t_UserCount == 0)
+	{
+		// Keep asking, Core does not know about the users for a moment after connecting.
+		m_UsersChanged = true;
+		return;
 	}
 
-	RCLCPP_INFO(m_PublisherNode->get_logger(), "Manus client connected to host.");
+	uint32_t t_UserIDs[MAX_NUMBER_OF_USERS];
+	t_UserCount = std::min<uint32_t>(t_UserCount, MAX_NUMBER_OF_USERS);
+	t_Res = CoreSdk_GetIdsOfAvailableUsers(t_UserIDs, t_UserCount);
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to get the IDs of the available users. The error given was %d", (int)t_Res);
+		m_UsersChanged = true;
+		return;
+	}
 
-	// Upload a simple skeleton with a chain. This will just be a left hand for the first user index.
-	LoadTestSkeleton();
+	// Unload the skeletons of users that left.
+	for (size_t i = 0; i < m_LoadedUsers.size();)
+	{
+		const LoadedUser t_User = m_LoadedUsers[i];
+		if (std::find(t_UserIDs, t_UserIDs + t_UserCount, t_User.userID) != t_UserIDs + t_UserCount)
+		{
+			i++;
+			continue;
+		}
+		RemoveUserHandSkeletons(t_User.userID);
+		CoreSdk_UnloadSkeleton(t_User.rightHandID);
+		CoreSdk_UnloadSkeleton(t_User.leftHandID);
+		RCLCPP_INFO(m_PublisherNode->get_logger(), "User %u left, unloaded its hand skeletons", t_User.userID);
+		m_LoadedUsers[i] = m_LoadedUsers[m_LoadedUsers.size() - 1];
+		m_LoadedUsers.resize(m_LoadedUsers.size() - 1);
+	}
+
+	// Load skeletons for the users that arrived.
+	for (uint32_t i = 0; i < t_UserCount; i++)
+	{
+		const uint32_t t_UserID = t_UserIDs[i];
+		const bool t_Loaded = std::any_of(m_LoadedUsers.begin(), m_LoadedUsers.end(),
+			[t_UserID](const LoadedUser& p_User) { return p_User.userID == t_UserID; });
+		if (t_Loaded) continue;
+		if (m_LoadedUsers.size() == m_LoadedUsers.capacity())
+		{
+			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Not loading hand skeletons for user %u, too many users", t_UserID);
+			continue;
+		}
+
+		LoadedUser t_User = { t_UserID, 0, 0 };
+		if (!LoadHandSkeletons(SkeletonTargetType::SkeletonTargetType_UserData, t_UserID, t_User.rightHandID, t_User.leftHandID))
+		{
+			m_UsersChanged = true;
+			continue;
+		}
+		m_LoadedUsers.resize(m_LoadedUsers.size() + 1);
+		m_LoadedUsers[m_LoadedUsers.size() - 1] = t_User;
+		AddUserHandSkeletons(t_UserID, t_User.rightHandID, t_User.leftHandID);
+		RCLCPP_INFO(m_PublisherNode->get_logger(), "User %u arrived, loaded hand skeletons %u (right) and %u (left)", t_UserID, t_User.rightHandID, t_User.leftHandID);
+	}
+}
+
+/// @brief Finalizes the recording, if any. The stream callbacks must have stopped.
+void SDKMinimalClient::StopRecording()
+{
+	if (!m_Recorder.IsOpen()) return;
+
+	const uint64_t t_Bytes = m_Recorder.RecordedBytes();
+	const uint64_t t_Dropped = m_Recorder.DroppedRecords();
+	std::string t_Error;
+	if (!m_Recorder.Close(t_Error))
+	{
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to finalize the recording: %s", t_Error.c_str());
+	}
+	RCLCPP_INFO(m_PublisherNode->get_logger(), "Recorded %lu bytes of SDK streams to %s", (unsigned long)t_Bytes, m_Recorder.Path().c_str());
+	if (t_Dropped > 0)
+	{
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Dropped %lu records because the recording was full", (unsigned long)t_Dropped);
+	}
 }
 
 /// @brief Main loop that receives data from the SDK and processes it.
+/// Takes the newest frame of every stream from the triple buffers. This never waits on the SDK callback threads.
 bool SDKMinimalClient::Run()
 {
-	m_HasNewSkeletonData = false;
-	m_HasNewErognomicsData = false;
-	m_HasNewTrackerData = false;
+	m_LastSwapSteadyNs = FrameSignal::SteadyNowNs();
+
+	m_HasNewSkeletonData = m_SkeletonBuffer.Update();
+	if (m_HasNewSkeletonData)
+	{
+		m_Skeleton = &m_SkeletonBuffer.ReadBuffer();
+	}
+
+	m_HasNewTrackerData = m_TrackerBuffer.Update();
+	if (m_HasNewTrackerData)
+	{
+		m_TrackerData = &m_TrackerBuffer.ReadBuffer();
+	}
+
+	m_HasNewErognomicsData = m_ErgonomicsBuffer.Update();
+	if (m_HasNewErognomicsData)
+	{
+		m_Ergonomics = &m_ErgonomicsBuffer.ReadBuffer();
+	}
+
+	m_HasNewRawSkeletonData = m_RawSkeletonBuffer.Update();
+	if (m_HasNewRawSkeletonData)
+	{
+		m_RawSkeleton = &m_RawSkeletonBuffer.ReadBuffer();
+	}
+
+	m_HasNewGestureData = m_GestureBuffer.Update();
+	if (m_HasNewGestureData)
+	{
+		m_Gestures = &m_GestureBuffer.ReadBuffer();
+	}
+
+	if (m_RoutesBuffer.Update())
+	{
+		m_Routes = &m_RoutesBuffer.ReadBuffer();
+	}
+
+    return m_HasNewSkeletonData || m_HasNewErognomicsData || m_HasNewTrackerData || m_HasNewGestureData || m_HasNewRawSkeletonData;
+}
+
+
+namespace
+{
+	/// @brief A host to connect to directly. IP addresses go in ipAddress, anything else is taken as a host name; the
+	/// SDK uses whichever of the two is set.
+	ManusHost MakeManusHost(const std::string& p_Host)
+	{
+		ManusHost t_Host;
+		std::memset(&t_Host, 0, sizeof(t_Host));
+		unsigned char t_Address[sizeof(struct in6_addr)];
+		const bool t_IsAddress = inet_pton(AF_INET, p_Host.c_str(), t_Address) == 1 || inet_pton(AF_INET6, p_Host.c_str(), t_Address) == 1;
+		if (t_IsAddress)
+		{
+			strncpy(t_Host.ipAddress, p_Host.c_str(), sizeof(t_Host.ipAddress) - 1);
+		}
+		else
+		{
+			strncpy(t_Host.hostName, p_Host.c_str(), sizeof(t_Host.hostName) - 1);
+		}
+		return t_Host;
+	}
 
-	// Check if there is new data, otherwise, we just wait.
-	m_SkeletonMutex.lock();
-	if (m_NextSkeleton != nullptr)
+	const char* HostLabel(const ManusHost& p_Host)
 	{
-		if (m_Skeleton != nullptr)
-			delete m_Skeleton;
-		m_Skeleton = m_NextSkeleton;
-		m_NextSkeleton = nullptr;
-        m_HasNewSkeletonData = true;
+		return p_Host.ipAddress[0] != '\0' ? p_Host.ipAddress : p_Host.hostName;
 	}
-	m_SkeletonMutex.unlock();
 
-	m_TrackerMutex.lock();
-	if (m_NextTrackerData != nullptr)
+	bool SameHost(const ManusHost& p_A, const ManusHost& p_B)
 	{
-		if (m_TrackerData != nullptr)
-			delete m_TrackerData;
-		m_TrackerData = m_NextTrackerData;
-		m_NextTrackerData = nullptr;
-		m_HasNewTrackerData = true;
+		return (p_A.ipAddress[0] != '\0' && std::strcmp(p_A.ipAddress, p_B.ipAddress) == 0) ||
+			(p_A.hostName[0] != '\0' && std::strcmp(p_A.hostName, p_B.hostName) == 0);
+	}
+
+	/// @brief Creates a directory along with any of its parents that are missing, like mkdir -p.
+	bool CreateDirectories(const std::string& p_Dir)
+	{
+		for (size_t t_Slash = p_Dir.find('/', 1); !p_Dir.empty(); t_Slash = p_Dir.find('/', t_Slash + 1))
+		{
+			const std::string t_Dir = p_Dir.substr(0, t_Slash);
+			if (mkdir(t_Dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+			if (t_Slash == std::string::npos) break;
+		}
+		return true;
+	}
+
+	/// @brief Replaces a file in one step, so a crash cannot leave half of it behind. Creates the directory of the file
+	/// first, as the default cache locations under ~/.ros need not exist yet in a fresh container.
+	bool WriteFileAtomically(const std::string& p_Path, const void* p_Data, size_t p_Size)
+	{
+		const size_t t_Slash = p_Path.rfind('/');
+		if (t_Slash != std::string::npos && t_Slash > 0 && !CreateDirectories(p_Path.substr(0, t_Slash))) return false;
+		const std::string t_TempPath = p_Path + ".tmp";
+		{
+			std::ofstream t_File(t_TempPath, std::ios::binary | std::ios::trunc);
+			t_File.write((const char*)p_Data, (std::streamsize)p_Size);
+			if (!t_File.flush()) return false;
+		}
+		return std::rename(t_TempPath.c_str(), p_Path.c_str()) == 0;
+	}
+
+	bool ReadFile(const std::string& p_Path, std::vector<unsigned char>& p_Data)
+	{
+		if (p_Path.empty()) return false;
+		std::ifstream t_File(p_Path, std::ios::binary);
+		if (!t_File) return false;
+		p_Data.assign(std::istreambuf_iterator<char>(t_File), std::istreambuf_iterator<char>());
+		return !p_Data.empty();
+	}
+
+	/// @brief FNV-1a hash of everything the hand skeleton setups are built from.
+	uint64_t HandLayoutHash()
+	{
+		uint64_t t_Hash = 14695981039346656037ull;
+		auto t_Add = [&t_Hash](const void* p_Data, size_t p_Size) {
+			for (size_t i = 0; i < p_Size; i++)
+			{
+				t_Hash = (t_Hash ^ ((const unsigned char*)p_Data)[i]) * 1099511628211ull;
+			}
+		};
+		// Bump when SetupHandNodes() or SetupHandChains() change in a way the layout below does not show.
+		const uint32_t t_SetupVersion = 1;
+		t_Add(&t_SetupVersion, sizeof(t_SetupVersion));
+		t_Add(c_HandBindPositionsRight, sizeof(c_HandBindPositionsRight));
+		t_Add(c_HandBindPositionsLeft, sizeof(c_HandBindPositionsLeft));
+		for (uint32_t t_ID = 0; t_ID < c_HandNodeCount; t_ID++)
+		{
+			const uint32_t t_ParentID = HandNodeParentID(t_ID);
+			t_Add(&t_ParentID, sizeof(t_ParentID));
+			t_Add(c_HandNodeNames[t_ID], std::strlen(c_HandNodeNames[t_ID]));
+		}
+		return t_Hash;
 	}
-	m_TrackerMutex.unlock();
 
-	m_ErgonomicsMutex.lock();
-	if (m_NextErgonomics != nullptr)
+	/// @brief Reads the host cached by SaveCachedHost(): the IP address on the first line, the host name on the second.
+	bool LoadCachedHost(const std::string& p_Path, ManusHost& p_Host)
 	{
-		if (m_Ergonomics != nullptr)
-			delete m_Ergonomics;
-		m_Ergonomics = m_NextErgonomics;
-		m_NextErgonomics = nullptr;
-		m_HasNewErognomicsData = true;
+		if (p_Path.empty()) return false;
+		std::ifstream t_File(p_Path);
+		std::string t_Address;
+		std::string t_Name;
+		if (!std::getline(t_File, t_Address)) return false;
+		std::getline(t_File, t_Name);
+		if (t_Address.empty() && t_Name.empty()) return false;
+		std::memset(&p_Host, 0, sizeof(p_Host));
+		strncpy(p_Host.ipAddress, t_Address.c_str(), sizeof(p_Host.ipAddress) - 1);
+		strncpy(p_Host.hostName, t_Name.c_str(), sizeof(p_Host.hostName) - 1);
+		return true;
 	}
-	m_ErgonomicsMutex.unlock();
 
-    return m_HasNewSkeletonData || m_HasNewErognomicsData || m_HasNewTrackerData;
+	/// @param p_Cached The host read from the cache before connecting, if any. The file is left alone when it already
+	/// holds p_Host.
+	bool SaveCachedHost(const std::string& p_Path, const ManusHost& p_Host, const ManusHost* p_Cached)
+	{
+		if (p_Path.empty()) return true;
+		if (p_Cached != nullptr && std::strcmp(p_Cached->ipAddress, p_Host.ipAddress) == 0 &&
+			std::strcmp(p_Cached->hostName, p_Host.hostName) == 0)
+		{
+			return true;
+		}
+		const std::string t_Contents = std::string(p_Host.ipAddress) + "\n" + p_Host.hostName + "\n";
+		return WriteFileAtomically(p_Path, t_Contents.data(), t_Contents.size());
+	}
 }
 
+/// @brief Connects to a known host without looking for hosts first.
+bool SDKMinimalClient::ConnectDirectly(const ManusHost& p_Host)
+{
+	const SDKReturnCode t_ConnectResult = CoreSdk_ConnectToHost(p_Host);
+	return t_ConnectResult == SDKReturnCode::SDKReturnCode_Success;
+}
 
 /// @brief the client will now try to connect to manus core via the SDK.
+/// Connects directly to the configured host, or to the host of the last session, and only looks for hosts when that
+/// fails, as looking takes a second. The host connected to, however it was found, is cached for the next start.
 ClientReturnCode SDKMinimalClient::Connect()
 {
+	const int64_t t_StartNs = FrameSignal::SteadyNowNs();
+	ManusHost t_CachedHost;
+	const bool t_HasCachedHost = LoadCachedHost(m_HostCachePath, t_CachedHost);
+	ManusHost t_KnownHost;
+	const char* t_KnownSource = nullptr;
+	if (!m_Host.empty())
+	{
+		t_KnownHost = MakeManusHost(m_Host);
+		t_KnownSource = "configured";
+	}
+	else if (t_HasCachedHost)
+	{
+		t_KnownHost = t_CachedHost;
+		t_KnownSource = "cached";
+	}
+
+	if (t_KnownSource != nullptr)
+	{
+		if (ConnectDirectly(t_KnownHost))
+		{
+			RCLCPP_INFO(m_PublisherNode->get_logger(), "Connected directly to the %s host %s in %.1f ms", t_KnownSource,
+				HostLabel(t_KnownHost), (double)(FrameSignal::SteadyNowNs() - t_StartNs) * 1e-6);
+			if (!SaveCachedHost(m_HostCachePath, t_KnownHost, t_HasCachedHost ? &t_CachedHost : nullptr))
+			{
+				RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to cache the host in %s", m_HostCachePath.c_str());
+			}
+			return ClientReturnCode::ClientReturnCode_Success;
+		}
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Could not connect to the %s host %s, looking for hosts", t_KnownSource, HostLabel(t_KnownHost));
+	}
+
 	SDKReturnCode t_StartResult = CoreSdk_LookForHosts(1, false);
 	if (t_StartResult != SDKReturnCode::SDKReturnCode_Success)
 	{
@@ -245,14 +760,32 @@ ClientReturnCode SDKMinimalClient::Connect()
 		return ClientReturnCode::ClientReturnCode_FailedToFindHosts;
 	}
 
-	SDKReturnCode t_ConnectResult = CoreSdk_ConnectToHost(t_AvailableHosts[0]);
+	// Prefer the known host if it was found under another address, otherwise take the first.
+	uint32_t t_HostIndex = 0;
+	for (uint32_t i = 0; t_KnownSource != nullptr && i < t_NumberOfHostsFound; i++)
+	{
+		if (SameHost(t_KnownHost, t_AvailableHosts[i]))
+		{
+			t_HostIndex = i;
+			break;
+		}
+	}
+
+	SDKReturnCode t_ConnectResult = CoreSdk_ConnectToHost(t_AvailableHosts[t_HostIndex]);
 
-	if (t_ConnectResult == SDKReturnCode::SDKReturnCode_NotConnected)
+	if (t_ConnectResult != SDKReturnCode::SDKReturnCode_Success)
 	{
-		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to connect to host");
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to connect to host. Error code: %d", (int)t_ConnectResult);
 		return ClientReturnCode::ClientReturnCode_FailedToConnect;
 	}
 
+	RCLCPP_INFO(m_PublisherNode->get_logger(), "Connected to the host %s found among %u in %.1f ms", HostLabel(t_AvailableHosts[t_HostIndex]),
+		t_NumberOfHostsFound, (double)(FrameSignal::SteadyNowNs() - t_StartNs) * 1e-6);
+	if (!SaveCachedHost(m_HostCachePath, t_AvailableHosts[t_HostIndex], t_HasCachedHost ? &t_CachedHost : nullptr))
+	{
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to cache the host in %s", m_HostCachePath.c_str());
+	}
+
 	return ClientReturnCode::ClientReturnCode_Success;
 }
 
@@ -264,56 +797,181 @@ ClientReturnCode SDKMinimalClient::Connect()
 /// we will not be applying the returned data on anything.
 void SDKMinimalClient::LoadTestSkeleton()
 {
-	for (uint32_t hand = 0; hand < 2; hand++)
-    {
-        uint32_t t_SklIndex = 0;
+	uint32_t t_RightHandID = 0;
+	uint32_t t_LeftHandID = 0;
+	// The user index is the index of the user that the skeleton is attached to. Just take the first index, make sure
+	// this matches in the landscape. The user ID is not known here, slot 0 is reported as user 0.
+	if (!LoadHandSkeletons(SkeletonTargetType::SkeletonTargetType_UserIndexData, 0, t_RightHandID, t_LeftHandID)) return;
+	AddUserHandSkeletons(0, t_RightHandID, t_LeftHandID);
+}
 
-        // Create a skeleton setup for the hand
+/// @brief Loads a right and a left hand skeleton for a user.
+/// @param p_TargetType SkeletonTargetType_UserIndexData or SkeletonTargetType_UserData.
+/// @param p_Target the user index or user ID, depending on p_TargetType.
+bool SDKMinimalClient::LoadHandSkeletons(SkeletonTargetType p_TargetType, uint32_t p_Target, uint32_t& p_RightHandID, uint32_t& p_LeftHandID)
+{
+	if (!LoadHandSkeleton(p_TargetType, p_Target, true, p_RightHandID)) return false;
+	if (!LoadHandSkeleton(p_TargetType, p_Target, false, p_LeftHandID))
+	{
+		CoreSdk_UnloadSkeleton(p_RightHandID);
+		return false;
+	}
+	return true;
+}
 
-        SkeletonSetupInfo t_SKL;
-        SkeletonSetupInfo_Init(&t_SKL);
-        t_SKL.type = SkeletonType::SkeletonType_Hand;
-        t_SKL.settings.scaleToTarget = true;
-        t_SKL.settings.targetType = SkeletonTargetType::SkeletonTargetType_UserIndexData;
+bool SDKMinimalClient::LoadHandSkeleton(SkeletonTargetType p_TargetType, uint32_t p_Target, bool p_IsRightHand, uint32_t& p_SkeletonID)
+{
+	uint32_t t_SklIndex = 0;
 
-        // The user index is the index of the user that the skeleton is attached to.
-        // If the glove does not exist then the added skeleton will not be animated.
-        // Same goes for any other skeleton made for invalid users/gloves.
-        t_SKL.settings.skeletonTargetUserIndexData.userIndex = 0; // Just take the first index. make sure this matches in the landscape.
+	// Create a skeleton setup for the hand
+	SkeletonSetupInfo t_SKL;
+	SkeletonSetupInfo_Init(&t_SKL);
+	t_SKL.type = SkeletonType::SkeletonType_Hand;
+	t_SKL.settings.scaleToTarget = true;
+	t_SKL.settings.targetType = p_TargetType;
 
-		strncpy(t_SKL.name, (hand == 0) ? "RightHand" : "LeftHand", sizeof(t_SKL.name));
+	// If the glove or user does not exist then the added skeleton will not be animated.
+	if (p_TargetType == SkeletonTargetType::SkeletonTargetType_UserData)
+	{
+		t_SKL.settings.skeletonTargetUserData.userID = p_Target;
+	}
+	else
+	{
+		t_SKL.settings.skeletonTargetUserIndexData.userIndex = p_Target;
+	}
+
+	strncpy(t_SKL.name, p_IsRightHand ? "RightHand" : "LeftHand", sizeof(t_SKL.name));
 
-        SDKReturnCode t_Res = CoreSdk_CreateSkeletonSetup(t_SKL, &t_SklIndex);
-        if (t_Res != SDKReturnCode::SDKReturnCode_Success)
-        {
-			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to create skeleton setup");
-            return;
-        }
+	if (!CreateHandSkeletonSetup(t_SKL, t_SklIndex)) return false;
 
-        // setup nodes and chains for the skeleton hand
-        if (!SetupHandNodes(t_SklIndex, (hand == 0)))
-        {
+	// The setup holds the target, so it is cached per target and hand.
+	const std::string t_CacheKey = std::string(p_IsRightHand ? "right" : "left") +
+		(p_TargetType == SkeletonTargetType::SkeletonTargetType_UserData ? "_user_" : "_index_") + std::to_string(p_Target);
+	uint32_t t_SessionID = 0;
+	const bool t_HasSession = CoreSdk_GetSessionId(&t_SessionID) == SDKReturnCode::SDKReturnCode_Success;
+
+	if (t_HasSession && RestoreHandSkeletonSetup(t_SklIndex, t_SessionID, t_CacheKey))
+	{
+		m_SkeletonsRestored++;
+	}
+	else
+	{
+		// setup nodes and chains for the skeleton hand
+		if (!SetupHandNodes(t_SklIndex, p_IsRightHand))
+		{
 			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to setup hand nodes");
-            return;
-        }
-        if (!SetupHandChains(t_SklIndex, (hand == 0)))
-        {
+			return false;
+		}
+		if (!SetupHandChains(t_SklIndex, p_IsRightHand))
+		{
 			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to setup hand chains");
-            return;
-        }
-
-        // load skeleton
-        t_Res = CoreSdk_LoadSkeleton(t_SklIndex, &m_GloveIDs[hand]);
-        if (t_Res != SDKReturnCode::SDKReturnCode_Success)
-        {
-			RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to load skeleton");
-            return;
-        }
-        else
-        {
-			RCLCPP_INFO_STREAM(m_PublisherNode->get_logger(), "Skeleton ID:" << &m_GloveIDs[hand] << " loaded successfully");
-        }
-    }
+			return false;
+		}
+		if (t_HasSession)
+		{
+			CacheHandSkeletonSetup(t_SklIndex, t_SessionID, t_CacheKey);
+		}
+		m_SkeletonsBuilt++;
+	}
+
+	// load skeleton
+	SDKReturnCode t_Res = CoreSdk_LoadSkeleton(t_SklIndex, &p_SkeletonID);
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to load skeleton");
+		return false;
+	}
+	RCLCPP_INFO_STREAM(m_PublisherNode->get_logger(), "Skeleton ID:" << p_SkeletonID << " loaded successfully");
+	return true;
+}
+
+bool SDKMinimalClient::CreateHandSkeletonSetup(const SkeletonSetupInfo& p_Info, uint32_t& p_SklIndex)
+{
+	SDKReturnCode t_Res = CoreSdk_CreateSkeletonSetup(p_Info, &p_SklIndex);
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success)
+	{
+		RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to create skeleton setup");
+		return false;
+	}
+	return true;
+}
+
+/// @brief Cache file of a setup. The name carries a hash of the hand layout, so a changed layout never restores a
+/// setup built for the old one.
+std::string SDKMinimalClient::SkeletonCachePath(const std::string& p_CacheKey) const
+{
+	if (m_SkeletonCacheDir.empty()) return "";
+	char t_Hash[17];
+	snprintf(t_Hash, sizeof(t_Hash), "%016llx", (unsigned long long)HandLayoutHash());
+	return m_SkeletonCacheDir + "/hand_" + p_CacheKey + "_" + t_Hash + ".skl";
+}
+
+/// @brief Fills an empty setup from its cached compressed form: one call to Core to decompress it and one to fetch
+/// it, instead of a call per node and chain.
+bool SDKMinimalClient::RestoreHandSkeletonSetup(uint32_t p_SklIndex, uint32_t p_SessionID, const std::string& p_CacheKey)
+{
+	std::vector<unsigned char> t_Data;
+	{
+		std::lock_guard<std::mutex> t_Lock(m_SkeletonCacheMutex);
+		auto t_Cached = m_SkeletonCache.find(p_CacheKey);
+		if (t_Cached == m_SkeletonCache.end())
+		{
+			std::vector<unsigned char> t_File;
+			if (!ReadFile(SkeletonCachePath(p_CacheKey), t_File)) return false;
+			t_Cached = m_SkeletonCache.emplace(p_CacheKey, std::move(t_File)).first;
+		}
+		t_Data = t_Cached->second;
+	}
+
+	SDKReturnCode t_Res = CoreSdk_GetTemporarySkeletonFromCompressedData(p_SklIndex, p_SessionID, t_Data.data(), (uint32_t)t_Data.size());
+	if (t_Res == SDKReturnCode::SDKReturnCode_Success)
+	{
+		t_Res = CoreSdk_GetTemporarySkeleton(p_SklIndex, p_SessionID);
+	}
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success)
+	{
+		// Stop using it, the setup is built and cached again.
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to restore the cached %s hand skeleton, rebuilding it. The error given was %d",
+			p_CacheKey.c_str(), (int)t_Res);
+		std::lock_guard<std::mutex> t_Lock(m_SkeletonCacheMutex);
+		m_SkeletonCache.erase(p_CacheKey);
+		return false;
+	}
+	return true;
+}
+
+/// @brief Has Core compress a freshly built setup and keeps the result, in memory and in the cache directory.
+/// Failing to cache only costs the next connect the full setup.
+void SDKMinimalClient::CacheHandSkeletonSetup(uint32_t p_SklIndex, uint32_t p_SessionID, const std::string& p_CacheKey)
+{
+	uint32_t t_Size = 0;
+	SDKReturnCode t_Res = CoreSdk_SaveTemporarySkeleton(p_SklIndex, p_SessionID, false);
+	if (t_Res == SDKReturnCode::SDKReturnCode_Success)
+	{
+		t_Res = CoreSdk_CompressTemporarySkeletonAndGetSize(p_SklIndex, p_SessionID, &t_Size);
+	}
+	std::vector<unsigned char> t_Data(t_Size);
+	if (t_Res == SDKReturnCode::SDKReturnCode_Success && t_Size > 0)
+	{
+		t_Res = CoreSdk_GetCompressedTemporarySkeletonData(t_Data.data(), t_Size);
+	}
+	if (t_Res != SDKReturnCode::SDKReturnCode_Success || t_Size == 0)
+	{
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to compress the %s hand skeleton for the cache. The error given was %d",
+			p_CacheKey.c_str(), (int)t_Res);
+		return;
+	}
+
+	const std::string t_Path = SkeletonCachePath(p_CacheKey);
+	if (!t_Path.empty())
+	{
+		if (!WriteFileAtomically(t_Path, t_Data.data(), t_Data.size()))
+		{
+			RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to write the skeleton cache %s", t_Path.c_str());
+		}
+	}
+	std::lock_guard<std::mutex> t_Lock(m_SkeletonCacheMutex);
+	m_SkeletonCache[p_CacheKey] = std::move(t_Data);
 }
 
 /// @brief Skeletons are pretty extensive in their data setup
@@ -363,64 +1021,8 @@ ManusVec3 SDKMinimalClient::CreateManusVec3(float p_X, float p_Y, float p_Z)
 /// this allows us to create the link between Manus Core's data and the data we enter here.
 bool SDKMinimalClient::SetupHandNodes(uint32_t p_SklIndex, bool isRightHand)
 {
-	// Define number of fingers per hand and number of joints per finger
-	const uint32_t t_NumFingers = 5;
-	const uint32_t t_NumJoints = 4;
-
-	// Create an array with the initial position of each hand node.
-	ManusVec3 t_Fingers_Right[t_NumFingers * t_NumJoints] = {
-		CreateManusVec3(0.025320f, 0.024950f, 0.000000f), // Thumb CMC joint
-		CreateManusVec3(0.032742f, 0.000000f, 0.000000f), // Thumb MCP joint
-		CreateManusVec3(0.028739f, 0.000000f, 0.000000f), // Thumb IP joint
-		CreateManusVec3(0.028739f, 0.000000f, 0.000000f), // Thumb Tip joint
-
-		CreateManusVec3(0.052904f, -0.011181f, 0.000000f), // Index MCP joint
-		CreateManusVec3(0.038257f, 0.000000f, 0.000000f),  // Index PIP joint
-		CreateManusVec3(0.020884f, 0.000000f, 0.000000f),  // Index DIP joint
-		CreateManusVec3(0.018759f, 0.000000f, 0.000000f),  // Index Tip joint
-
-		CreateManusVec3(0.051287f, 0.000000f, 0.000000f), // Middle MCP joint
-		CreateManusVec3(0.041861f, 0.000000f, 0.000000f), // Middle PIP joint
-		CreateManusVec3(0.024766f, 0.000000f, 0.000000f), // Middle DIP joint
-		CreateManusVec3(0.019683f, 0.000000f, 0.000000f), // Middle Tip joint
-
-		CreateManusVec3(0.049802f, -0.011274f, 0.000000f), // Ring MCP joint
-		CreateManusVec3(0.039736f, 0.000000f, 0.000000f),  // Ring PIP joint
-		CreateManusVec3(0.023564f, 0.000000f, 0.000000f),  // Ring DIP joint
-		CreateManusVec3(0.019868f, 0.000000f, 0.000000f),  // Ring Tip joint
-
-		CreateManusVec3(0.047309f, -0.020145f, 0.000000f), // Pinky MCP joint
-		CreateManusVec3(0.033175f, 0.000000f, 0.000000f),  // Pinky PIP joint
-		CreateManusVec3(0.018020f, 0.000000f, 0.000000f),  // Pinky DIP joint
-		CreateManusVec3(0.019129f, 0.000000f, 0.000000f)   // Pinky Tip joint
-	};
-
-	ManusVec3 t_Fingers_Left[t_NumFingers * t_NumJoints] = {
-		CreateManusVec3(-0.025320f, 0.024950f, 0.000000f), // Thumb CMC joint
-		CreateManusVec3(-0.032742f, 0.000000f, 0.000000f), // Thumb MCP joint
-		CreateManusVec3(-0.028739f, 0.000000f, 0.000000f), // Thumb IP joint
-		CreateManusVec3(-0.028739f, 0.000000f, 0.000000f), // Thumb Tip joint
-
-		CreateManusVec3(-0.052904f, -0.011181f, 0.000000f), // Index MCP joint
-		CreateManusVec3(-0.038257f, 0.000000f, 0.000000f),	// Index PIP joint
-		CreateManusVec3(-0.020884f, 0.000000f, 0.000000f),	// Index DIP joint
-		CreateManusVec3(-0.018759f, 0.000000f, 0.000000f),	// Index Tip joint
-
-		CreateManusVec3(-0.051287f, 0.000000f, 0.000000f), // Middle MCP joint
-		CreateManusVec3(-0.041861f, 0.000000f, 0.000000f), // Middle PIP joint
-		CreateManusVec3(-0.024766f, 0.000000f, 0.000000f), // Middle DIP joint
-		CreateManusVec3(-0.019683f, 0.000000f, 0.000000f), // Middle Tip joint
-
-		CreateManusVec3(-0.049802f, 0.011274f, 0.000000f), // Ring MCP joint
-		CreateManusVec3(-0.039736f, 0.000000f, 0.000000f), // Ring PIP joint
-		CreateManusVec3(-0.023564f, 0.000000f, 0.000000f), // Ring DIP joint
-		CreateManusVec3(-0.019868f, 0.000000f, 0.000000f), // Ring Tip joint
-
-		CreateManusVec3(-0.047309f, 0.020145f, 0.000000f), // Pinky MCP joint
-		CreateManusVec3(-0.033175f, 0.000000f, 0.000000f), // Pinky PIP joint
-		CreateManusVec3(-0.018020f, 0.000000f, 0.000000f), // Pinky DIP joint
-		CreateManusVec3(-0.019129f, 0.000000f, 0.000000f)  // Pinky Tip joint
-	};
+	// The initial position of each hand node, see HandSkeletonLayout.hpp.
+	const ManusVec3* t_Fingers = isRightHand ? c_HandBindPositionsRight : c_HandBindPositionsLeft;
 
 	// skeleton entry is already done. just the nodes now.
 	// setup a very simple node hierarchy for fingers
@@ -435,26 +1037,20 @@ bool SDKMinimalClient::SetupHandNodes(uint32_t p_SklIndex, bool isRightHand)
 	}
 
 	// then loop for 5 fingers
-	int t_FingerId = 0;
-	for (uint32_t i = 0; i < t_NumFingers; i++)
+	for (uint32_t i = 0; i < c_HandFingerCount; i++)
 	{
-		uint32_t t_ParentID = 0;
 		// then the digits of the finger that are linked to the root of the finger.
-		for (uint32_t j = 0; j < t_NumJoints; j++)
+		for (uint32_t j = 0; j < c_HandJointsPerFinger; j++)
 		{
-			// Setup the handeness of the Manus Glove
-			if (isRightHand) // Right Hand
-				t_Res = CoreSdk_AddNodeToSkeletonSetup(p_SklIndex, CreateNodeSetup(1 + t_FingerId + j, t_ParentID, t_Fingers_Right[i * 4 + j].x, t_Fingers_Right[i * 4 + j].y, t_Fingers_Right[i * 4 + j].z, "fingerdigit"));
-			else // Left Hand
-				t_Res = CoreSdk_AddNodeToSkeletonSetup(p_SklIndex, CreateNodeSetup(1 + t_FingerId + j, t_ParentID, t_Fingers_Left[i * 4 + j].x, t_Fingers_Left[i * 4 + j].y, t_Fingers_Left[i * 4 + j].z, "fingerdigit"));
+			const uint32_t t_NodeID = HandJointNodeID(i, j);
+			const ManusVec3& t_Position = t_Fingers[t_NodeID - 1];
+			t_Res = CoreSdk_AddNodeToSkeletonSetup(p_SklIndex, CreateNodeSetup(t_NodeID, HandNodeParentID(t_NodeID), t_Position.x, t_Position.y, t_Position.z, "fingerdigit"));
 			if (t_Res != SDKReturnCode::SDKReturnCode_Success)
 			{
 				RCLCPP_ERROR(m_PublisherNode->get_logger(), "Failed to Add Node To Skeleton Setup");
 				return false;
 			}
-			t_ParentID = 1 + t_FingerId + j;
 		}
-		t_FingerId += t_NumJoints;
 	}
 	return true;
 }
@@ -551,26 +1147,237 @@ bool SDKMinimalClient::SetupHandChains(uint32_t p_SklIndex, bool isRightHand)
 	return true;
 }
 
+/// @brief Applies the callback thread role to the calling thread, once per thread. The SDK delivers the streams on
+/// threads of its own, which only become known when they call in.
+void SDKMinimalClient::AdoptCallbackThread()
+{
+	thread_local bool t_Adopted = false;
+	if (t_Adopted) return;
+	t_Adopted = true;
+	if (m_CallbackThreadRole.IsDefault()) return;
+
+	std::string t_Error;
+	if (ApplyThreadRole(m_CallbackThreadRole, t_Error))
+	{
+		RCLCPP_INFO(m_PublisherNode->get_logger(), "SDK callback thread moved to CPUs %s, SCHED_FIFO priority %d",
+			FormatCpuList(m_CallbackThreadRole.cpus).c_str(), m_CallbackThreadRole.fifoPriority);
+	}
+	else
+	{
+		RCLCPP_WARN(m_PublisherNode->get_logger(), "SDK callback thread: %s", t_Error.c_str());
+	}
+}
+
+/// @brief This gets called when the client is connected to manus core.
+void SDKMinimalClient::OnConnectedCallback(const ManusHost* const p_Host)
+{
+	if (s_Instance)
+	{
+		{
+			std::lock_guard<std::mutex> t_Lock(s_Instance->m_ConnectionMutex);
+			s_Instance->m_ConnectionStatus.host = p_Host->hostName[0] != '\0' ? p_Host->hostName : p_Host->ipAddress;
+		}
+		s_Instance->m_ConnectionChanged.notify_all();
+	}
+}
+
+/// @brief This gets called when the client loses its connection to manus core.
+void SDKMinimalClient::OnDisconnectedCallback(const ManusHost* const p_Host)
+{
+	(void)p_Host;
+	if (s_Instance)
+	{
+		{
+			std::lock_guard<std::mutex> t_Lock(s_Instance->m_ConnectionMutex);
+			s_Instance->m_ConnectionLost = true;
+		}
+		s_Instance->m_ConnectionChanged.notify_all();
+	}
+}
+
 /// @brief This gets called when the client is connected to manus core
 /// @param p_SkeletonStreamInfo contains the meta data on how much data regarding the skeleton we need to get from the SDK.
 void SDKMinimalClient::OnSkeletonStreamCallback(const SkeletonStreamInfo *const p_SkeletonStreamInfo)
 {
 	if (s_Instance)
 	{
-		ClientSkeletonCollection *t_NxtClientSkeleton = new ClientSkeletonCollection();
-		t_NxtClientSkeleton->skeletons.resize(p_SkeletonStreamInfo->skeletonsCount);
+		const int64_t t_ReceiveSteadyNs = FrameSignal::SteadyNowNs();
+		const int64_t t_ReceiveTimeNs = SystemNowNs();
+		s_Instance->AdoptCallbackThread();
+		// Pairs every raw frame with the first retargeted frame after it.
+		const int64_t t_LastRawNs = s_Instance->m_LastRawSkeletonSteadyNs.exchange(0, std::memory_order_relaxed);
+		if (t_LastRawNs != 0)
+		{
+			s_Instance->m_RawSkeletonArrivalGap.Record(t_ReceiveSteadyNs - t_LastRawNs);
+		}
+		ClientSkeletonCollection *t_NxtClientSkeleton = &s_Instance->m_SkeletonBuffer.WriteBuffer();
+		t_NxtClientSkeleton->publishTime = p_SkeletonStreamInfo->publishTime;
+		t_NxtClientSkeleton->receiveTimeNs = t_ReceiveTimeNs;
+		t_NxtClientSkeleton->receiveSteadyNs = t_ReceiveSteadyNs;
+
+		// The slot storage is preallocated, so receiving a frame does not touch the heap.
+		// Skeletons and nodes beyond the fixed capacity are dropped.
+		const size_t t_SkeletonCount = t_NxtClientSkeleton->skeletons.resize(p_SkeletonStreamInfo->skeletonsCount);
+
+		for (uint32_t i = 0; i < t_SkeletonCount; i++)
+		{
+			ClientSkeleton &t_Skeleton = t_NxtClientSkeleton->skeletons[i];
+			bool t_Success;
+			if (s_DataSource != nullptr)
+			{
+				t_Success = s_DataSource->GetSkeletonInfo(i, &t_Skeleton.info);
+			}
+			else
+			{
+				t_Success = CoreSdk_GetSkeletonInfo(i, &t_Skeleton.info) == SDKReturnCode::SDKReturnCode_Success;
+			}
+			// The data call fails unless asked for every node, so an oversized skeleton (such as a body skeleton
+			// loaded by another client) is left empty rather than keeping the nodes of the slot's previous frame.
+			uint32_t t_NodeCount = (uint32_t)t_Skeleton.nodes.resize(t_Success ? t_Skeleton.info.nodesCount : 0);
+			t_Success = t_Success && t_NodeCount == t_Skeleton.info.nodesCount;
+			if (t_Success && s_DataSource != nullptr)
+			{
+				t_Success = s_DataSource->GetSkeletonData(i, t_Skeleton.nodes.data(), t_NodeCount);
+			}
+			else if (t_Success)
+			{
+				t_Success = CoreSdk_GetSkeletonData(i, t_Skeleton.nodes.data(), t_NodeCount) == SDKReturnCode::SDKReturnCode_Success;
+			}
+			if (!t_Success)
+			{
+				t_NodeCount = (uint32_t)t_Skeleton.nodes.resize(0);
+			}
+			t_Skeleton.info.nodesCount = t_NodeCount;
+		}
+
+		if (s_Instance->m_Recorder.IsOpen())
+		{
+			SkeletonStreamInfo t_StreamInfo = *p_SkeletonStreamInfo;
+			t_StreamInfo.skeletonsCount = (uint32_t)t_SkeletonCount;
+			StreamRecorder::Segment t_Segments[1 + 2 * MAX_NUMBER_OF_SKELETONS];
+			size_t t_SegmentCount = 0;
+			t_Segments[t_SegmentCount++] = { &t_StreamInfo, sizeof(t_StreamInfo) };
+			for (const ClientSkeleton &t_Skeleton : t_NxtClientSkeleton->skeletons)
+			{
+				t_Segments[t_SegmentCount++] = { &t_Skeleton.info, sizeof(SkeletonInfo) };
+				t_Segments[t_SegmentCount++] = { t_Skeleton.nodes.data(), t_Skeleton.nodes.size() * sizeof(SkeletonNode) };
+			}
+			s_Instance->m_Recorder.Append(StreamRecordType::Skeleton, t_ReceiveSteadyNs, t_ReceiveTimeNs, t_Segments, t_SegmentCount);
+		}
+
+		s_Instance->m_SkeletonBuffer.Publish();
+		s_Instance->m_FrameSignal.Notify();
+
+		// Time to recover, picked up by the connection thread.
+		if (s_Instance->m_AwaitingFirstFrame.load(std::memory_order_relaxed) && s_Instance->m_AwaitingFirstFrame.exchange(false))
+		{
+			s_Instance->m_FirstFrameSteadyNs.store(t_ReceiveSteadyNs);
+		}
+	}
+}
+
+/// @brief This gets called when receiving raw skeleton data from Manus Core: the skeletons estimated from the glove
+/// data, before Core retargets them onto the hand skeletons loaded by this client.
+void SDKMinimalClient::OnRawSkeletonStreamCallback(const SkeletonStreamInfo* const p_RawSkeletonStreamInfo)
+{
+	if (s_Instance == nullptr) return;
+	const int64_t t_ReceiveSteadyNs = FrameSignal::SteadyNowNs();
+	const int64_t t_ReceiveTimeNs = SystemNowNs();
+	s_Instance->m_LastRawSkeletonSteadyNs.store(t_ReceiveSteadyNs, std::memory_order_relaxed);
+	s_Instance->AdoptCallbackThread();
+	ClientRawSkeletonCollection* t_NxtClientRawSkeleton = &s_Instance->m_RawSkeletonBuffer.WriteBuffer();
+	t_NxtClientRawSkeleton->publishTime = p_RawSkeletonStreamInfo->publishTime;
+	t_NxtClientRawSkeleton->receiveTimeNs = t_ReceiveTimeNs;
+	t_NxtClientRawSkeleton->receiveSteadyNs = t_ReceiveSteadyNs;
+
+	// Preallocated like the retargeted skeletons, skeletons and nodes beyond the capacity are dropped.
+	const size_t t_SkeletonCount = t_NxtClientRawSkeleton->skeletons.resize(p_RawSkeletonStreamInfo->skeletonsCount);
+	for (uint32_t i = 0; i < t_SkeletonCount; i++)
+	{
+		ClientRawSkeleton& t_Skeleton = t_NxtClientRawSkeleton->skeletons[i];
+		if (CoreSdk_GetRawSkeletonInfo(i, &t_Skeleton.info) != SDKReturnCode::SDKReturnCode_Success)
+		{
+			// Nothing is known about this skeleton, so it is published empty and its glove is not tracked.
+			t_Skeleton.info = {};
+			t_Skeleton.nodes.resize(0);
+			t_Skeleton.side = Side::Side_Invalid;
+			continue;
+		}
+		// The data call fails unless asked for every node, so an oversized skeleton is left empty.
+		uint32_t t_NodeCount = (uint32_t)t_Skeleton.nodes.resize(t_Skeleton.info.nodesCount);
+		if (t_NodeCount != t_Skeleton.info.nodesCount ||
+			CoreSdk_GetRawSkeletonData(i, t_Skeleton.nodes.data(), t_NodeCount) != SDKReturnCode::SDKReturnCode_Success)
+		{
+			t_NodeCount = (uint32_t)t_Skeleton.nodes.resize(0);
+		}
+		t_Skeleton.side = t_Skeleton.info.gloveId == s_Instance->m_FirstLeftGloveID ? Side::Side_Left :
+			t_Skeleton.info.gloveId == s_Instance->m_FirstRightGloveID ? Side::Side_Right : Side::Side_Invalid;
+
+		// Have the layout of gloves not seen before, or whose node count changed, fetched.
+		FixedVector<RawSkeletonNodeCount, MAX_NUMBER_OF_GLOVES>& t_Known = s_Instance->m_RawSkeletonNodeCounts;
+		RawSkeletonNodeCount* t_Glove = std::find_if(t_Known.begin(), t_Known.end(),
+			[&t_Skeleton](const RawSkeletonNodeCount& p_Glove) { return p_Glove.gloveID == t_Skeleton.info.gloveId; });
+		if (t_NodeCount != 0 && (t_Glove == t_Known.end() || t_Glove->nodeCount != t_NodeCount))
+		{
+			if (t_Glove == t_Known.end() && t_Known.size() < t_Known.capacity())
+			{
+				t_Glove = &t_Known[t_Known.size()];
+				t_Known.resize(t_Known.size() + 1);
+			}
+			if (t_Glove != t_Known.end())
+			{
+				*t_Glove = { t_Skeleton.info.gloveId, t_NodeCount };
+				s_Instance->QueueRawSkeletonLayout(t_Skeleton.info.gloveId);
+			}
+		}
+	}
+
+	s_Instance->m_RawSkeletonBuffer.Publish();
+	s_Instance->m_FrameSignal.Notify();
+}
+
+/// @brief Queues the layout of a glove for TakeRawSkeletonLayouts(), unless it already is. Does not allocate, so the
+/// raw skeleton callback can call it.
+void SDKMinimalClient::QueueRawSkeletonLayout(uint32_t p_GloveID)
+{
+	std::lock_guard<std::mutex> t_Lock(m_RawLayoutMutex);
+	FixedVector<uint32_t, MAX_NUMBER_OF_GLOVES>& t_Pending = m_PendingRawLayouts;
+	if (std::find(t_Pending.begin(), t_Pending.end(), p_GloveID) == t_Pending.end() && t_Pending.size() < t_Pending.capacity())
+	{
+		t_Pending.resize(t_Pending.size() + 1);
+		t_Pending[t_Pending.size() - 1] = p_GloveID;
+	}
+}
+
+void SDKMinimalClient::TakeRawSkeletonLayouts(std::vector<RawSkeletonLayout>& p_Layouts)
+{
+	FixedVector<uint32_t, MAX_NUMBER_OF_GLOVES> t_GloveIDs;
+	{
+		std::lock_guard<std::mutex> t_Lock(m_RawLayoutMutex);
+		t_GloveIDs = m_PendingRawLayouts;
+		m_PendingRawLayouts.clear();
+	}
 
-		for (uint32_t i = 0; i < p_SkeletonStreamInfo->skeletonsCount; i++)
+	for (uint32_t t_GloveID : t_GloveIDs)
+	{
+		RawSkeletonLayout t_Layout;
+		t_Layout.gloveID = t_GloveID;
+		uint32_t t_NodeCount = 0;
+		SDKReturnCode t_Result = CoreSdk_GetRawSkeletonNodeCount(t_GloveID, t_NodeCount);
+		if (t_Result == SDKReturnCode::SDKReturnCode_Success)
 		{
-			CoreSdk_GetSkeletonInfo(i, &t_NxtClientSkeleton->skeletons[i].info);
-			t_NxtClientSkeleton->skeletons[i].nodes = new SkeletonNode[t_NxtClientSkeleton->skeletons[i].info.nodesCount];
-			CoreSdk_GetSkeletonData(i, t_NxtClientSkeleton->skeletons[i].nodes, t_NxtClientSkeleton->skeletons[i].info.nodesCount);
+			t_Layout.nodes.resize(t_NodeCount);
+			t_Result = CoreSdk_GetRawSkeletonNodeInfo(t_GloveID, t_Layout.nodes.data());
 		}
-		s_Instance->m_SkeletonMutex.lock();
-		if (s_Instance->m_NextSkeleton != nullptr)
-			delete s_Instance->m_NextSkeleton;
-		s_Instance->m_NextSkeleton = t_NxtClientSkeleton;
-		s_Instance->m_SkeletonMutex.unlock();
+		if (t_Result != SDKReturnCode::SDKReturnCode_Success)
+		{
+			// Tried again on the next call.
+			RCLCPP_WARN(m_PublisherNode->get_logger(), "Failed to get the raw skeleton layout of glove %u. The error given was %d",
+				t_GloveID, (int)t_Result);
+			QueueRawSkeletonLayout(t_GloveID);
+			continue;
+		}
+		p_Layouts.push_back(std::move(t_Layout));
 	}
 }
 
@@ -579,15 +1386,43 @@ void SDKMinimalClient::OnSkeletonStreamCallback(const SkeletonStreamInfo *const
 void SDKMinimalClient::OnLandscapeCallback(const Landscape* const p_Landscape)
 {
 	if (s_Instance == nullptr)return;
+	s_Instance->AdoptCallbackThread();
+
+	if (s_Instance->m_Recorder.IsOpen())
+	{
+		const StreamRecorder::Segment t_Segment = { p_Landscape, sizeof(Landscape) };
+		s_Instance->m_Recorder.Append(StreamRecordType::Landscape, FrameSignal::SteadyNowNs(), SystemNowNs(), &t_Segment, 1);
+	}
 
 	Landscape* t_Landscape = new Landscape(*p_Landscape);
 	s_Instance->m_LandscapeMutex.lock();
 	if (s_Instance->m_NewLandscape != nullptr) delete s_Instance->m_NewLandscape;
 	s_Instance->m_NewLandscape = t_Landscape;
 	s_Instance->m_NewGestureLandscapeData.resize(t_Landscape->gestureCount);
-	CoreSdk_GetGestureLandscapeData(s_Instance->m_NewGestureLandscapeData.data(), (uint32_t)s_Instance->m_NewGestureLandscapeData.size());
+	if (s_DataSource == nullptr) // gesture descriptions are not part of a recording
+	{
+		CoreSdk_GetGestureLandscapeData(s_Instance->m_NewGestureLandscapeData.data(), (uint32_t)s_Instance->m_NewGestureLandscapeData.size());
+	}
+	// Every landscape lists the gestures, they rarely change.
+	const std::vector<GestureLandscapeData>& t_New = s_Instance->m_NewGestureLandscapeData;
+	const std::vector<GestureLandscapeData>& t_Old = s_Instance->m_GestureLandscapeData;
+	s_Instance->m_GestureLandscapeChanged = t_New.size() != t_Old.size() ||
+		!std::equal(t_New.begin(), t_New.end(), t_Old.begin(), [](const GestureLandscapeData& p_A, const GestureLandscapeData& p_B) {
+			return p_A.id == p_B.id && strncmp(p_A.name, p_B.name, sizeof(p_A.name)) == 0;
+		});
 	s_Instance->m_LandscapeMutex.unlock();
 
+	// Tell UpdateUserSkeletons() when users came or went.
+	const uint32_t t_UserCount = std::min<uint32_t>(t_Landscape->users.userCount, MAX_USERS);
+	bool t_UsersChanged = t_UserCount != s_Instance->m_LandscapeUserCount;
+	for (uint32_t i = 0; i < t_UserCount; i++)
+	{
+		t_UsersChanged = t_UsersChanged || t_Landscape->users.users[i].id != s_Instance->m_LandscapeUserIDs[i];
+		s_Instance->m_LandscapeUserIDs[i] = t_Landscape->users.users[i].id;
+	}
+	s_Instance->m_LandscapeUserCount = t_UserCount;
+	if (t_UsersChanged) s_Instance->m_UsersChanged = true;
+
 	// Update glove IDs according to landscape data
 	for (size_t i = 0; i < t_Landscape->gloveDevices.gloveCount; i++)
 	{
@@ -604,51 +1439,124 @@ void SDKMinimalClient::OnLandscapeCallback(const Landscape* const p_Landscape)
 	}
 }
 
+bool SDKMinimalClient::TakeGestureLandscapeChange(std::vector<GestureLandscapeData>& p_Gestures)
+{
+	std::lock_guard<std::mutex> t_Lock(m_LandscapeMutex);
+	if (!m_GestureLandscapeChanged) return false;
+	m_GestureLandscapeData = m_NewGestureLandscapeData;
+	m_GestureLandscapeChanged = false;
+	p_Gestures = m_GestureLandscapeData;
+	return true;
+}
+
+/// @brief This gets called when receiving gesture data from Manus Core.
+/// The probabilities of a glove come in chunks of MAX_GESTURE_DATA_CHUNK_SIZE; only the m_GestureTopK most probable
+/// gestures are kept, so the frame is handed off without allocating whatever the number of gestures.
+/// Gesture data is only sent for the gloves whose data changed since the last frame.
+void SDKMinimalClient::OnGestureStreamCallback(const GestureStreamInfo* const p_GestureStreamInfo)
+{
+	if (s_Instance == nullptr) return;
+	const uint32_t t_TopK = s_Instance->m_GestureTopK.load(std::memory_order_relaxed);
+	if (t_TopK == 0) return;
+
+	const int64_t t_ReceiveSteadyNs = FrameSignal::SteadyNowNs();
+	const int64_t t_ReceiveTimeNs = SystemNowNs();
+	s_Instance->AdoptCallbackThread();
+	ClientGestureCollection* t_NxtClientGestures = &s_Instance->m_GestureBuffer.WriteBuffer();
+	t_NxtClientGestures->publishTime = p_GestureStreamInfo->publishTime;
+	t_NxtClientGestures->receiveTimeNs = t_ReceiveTimeNs;
+	t_NxtClientGestures->receiveSteadyNs = t_ReceiveSteadyNs;
+	t_NxtClientGestures->gloves.clear();
+
+	GestureProbabilities t_Probs;
+	for (uint32_t i = 0; i < p_GestureStreamInfo->gestureProbabilitiesCount; i++)
+	{
+		if (CoreSdk_GetGestureStreamData(i, 0, &t_Probs) != SDKReturnCode::SDKReturnCode_Success) continue;
+		if (t_Probs.isUserID) continue;
+		if (t_NxtClientGestures->gloves.size() == t_NxtClientGestures->gloves.capacity()) break;
+
+		const size_t t_Index = t_NxtClientGestures->gloves.size();
+		t_NxtClientGestures->gloves.resize(t_Index + 1);
+		GloveGestures& t_Glove = t_NxtClientGestures->gloves[t_Index];
+		t_Glove.gloveID = t_Probs.id;
+		t_Glove.side = t_Probs.id == s_Instance->m_FirstLeftGloveID ? Side::Side_Left :
+			t_Probs.id == s_Instance->m_FirstRightGloveID ? Side::Side_Right : Side::Side_Invalid;
+		t_Glove.totalGestureCount = t_Probs.totalGestureCount;
+		t_Glove.top.clear();
+
+		// Insert every probability of every chunk into the sorted top list.
+		uint32_t t_Received = 0;
+		while (true)
+		{
+			const uint32_t t_ChunkCount = std::min<uint32_t>(t_Probs.gestureCount, MAX_GESTURE_DATA_CHUNK_SIZE);
+			for (uint32_t j = 0; j < t_ChunkCount; j++)
+			{
+				const GestureProbability& t_Gesture = t_Probs.gestureData[j];
+				size_t t_Slot = t_Glove.top.size();
+				if (t_Slot == t_TopK)
+				{
+					if (t_Gesture.percent <= t_Glove.top[t_Slot - 1].percent) continue;
+					t_Slot--;
+				}
+				else
+				{
+					t_Glove.top.resize(t_Slot + 1);
+				}
+				for (; t_Slot > 0 && t_Glove.top[t_Slot - 1].percent < t_Gesture.percent; t_Slot--)
+				{
+					t_Glove.top[t_Slot] = t_Glove.top[t_Slot - 1];
+				}
+				t_Glove.top[t_Slot] = t_Gesture;
+			}
+			t_Received += t_ChunkCount;
+			if (t_ChunkCount == 0 || t_Received >= t_Probs.totalGestureCount) break;
+			if (CoreSdk_GetGestureStreamData(i, t_Received, &t_Probs) != SDKReturnCode::SDKReturnCode_Success) break;
+		}
+	}
+
+	s_Instance->m_GestureBuffer.Publish();
+	s_Instance->m_FrameSignal.Notify();
+}
+
 /// @brief This gets called when the client receives ergonomics data from manus core
 /// @param p_ErgonomicsStream contains the data received from the core
 void SDKMinimalClient::OnErgonomicsStreamCallback(const ErgonomicsStream *const p_Ergonomics)
 {
 	if (s_Instance)
 	{
-		ClientErgonomics *t_NxtClientErgonomics = new ClientErgonomics();
-		t_NxtClientErgonomics->data_left = new ErgonomicsData;
-		t_NxtClientErgonomics->data_right = new ErgonomicsData;
-		bool updated_left = false;
-		bool updated_right = false;
+		const int64_t t_ReceiveSteadyNs = FrameSignal::SteadyNowNs();
+		const int64_t t_ReceiveTimeNs = SystemNowNs();
+		s_Instance->AdoptCallbackThread();
+		if (s_Instance->m_Recorder.IsOpen())
+		{
+			const uint32_t t_DataCount = p_Ergonomics->dataCount < MAX_NUMBER_OF_ERGONOMICS_DATA ? p_Ergonomics->dataCount : MAX_NUMBER_OF_ERGONOMICS_DATA;
+			const ErgonomicsRecordInfo t_RecordInfo = { p_Ergonomics->publishTime, t_DataCount, 0 };
+			const StreamRecorder::Segment t_Segments[2] = {
+				{ &t_RecordInfo, sizeof(t_RecordInfo) },
+				{ p_Ergonomics->data, t_DataCount * sizeof(ErgonomicsData) }
+			};
+			s_Instance->m_Recorder.Append(StreamRecordType::Ergonomics, t_ReceiveSteadyNs, t_ReceiveTimeNs, t_Segments, 2);
+		}
+
 		for (uint32_t i = 0; i < p_Ergonomics->dataCount; i++) {
 			if (p_Ergonomics->data[i].isUserID) continue;
-			for (uint32_t j = 0; j < ErgonomicsDataType_MAX_SIZE; j++) {
-				if (p_Ergonomics->data[i].id == s_Instance->m_FirstLeftGloveID) {
-					t_NxtClientErgonomics->data_left->data[j] = p_Ergonomics->data[i].data[j];
-					updated_left = true;
-				}
-				if (p_Ergonomics->data[i].id == s_Instance->m_FirstRightGloveID) {
-					t_NxtClientErgonomics->data_right->data[j] = p_Ergonomics->data[i].data[j];
-					updated_right = true;
-				}
+			if (p_Ergonomics->data[i].id == s_Instance->m_FirstLeftGloveID) {
+				s_Instance->m_LastErgonomicsLeft = p_Ergonomics->data[i];
 			}
-		}
-		if (!updated_left) {
-			// Copy the data for right hand from old data
-			if (s_Instance->m_Ergonomics != nullptr) {
-				for (uint32_t j = 0; j < ErgonomicsDataType_MAX_SIZE; j++) {
-					t_NxtClientErgonomics->data_left->data[j] = s_Instance->m_Ergonomics->data_left->data[j];
-				}
+			if (p_Ergonomics->data[i].id == s_Instance->m_FirstRightGloveID) {
+				s_Instance->m_LastErgonomicsRight = p_Ergonomics->data[i];
 			}
 		}
-		if (!updated_right) {
-			// Copy the data for left hand from old data
-			if (s_Instance->m_Ergonomics != nullptr) {
-				for (uint32_t j = 0; j < ErgonomicsDataType_MAX_SIZE; j++) {
-					t_NxtClientErgonomics->data_right->data[j] = s_Instance->m_Ergonomics->data_right->data[j];
-				}
-			}
-		}
-		s_Instance->m_ErgonomicsMutex.lock();
-		if (s_Instance->m_NextErgonomics != nullptr)
-			delete s_Instance->m_NextErgonomics;
-		s_Instance->m_NextErgonomics = t_NxtClientErgonomics;
-		s_Instance->m_ErgonomicsMutex.unlock();
+
+		// A hand that is missing from this frame keeps the data it had in the previous one.
+		ClientErgonomics *t_NxtClientErgonomics = &s_Instance->m_ErgonomicsBuffer.WriteBuffer();
+		t_NxtClientErgonomics->data_left = s_Instance->m_LastErgonomicsLeft;
+		t_NxtClientErgonomics->data_right = s_Instance->m_LastErgonomicsRight;
+		t_NxtClientErgonomics->publishTime = p_Ergonomics->publishTime;
+		t_NxtClientErgonomics->receiveTimeNs = t_ReceiveTimeNs;
+		t_NxtClientErgonomics->receiveSteadyNs = t_ReceiveSteadyNs;
+		s_Instance->m_ErgonomicsBuffer.Publish();
+		s_Instance->m_FrameSignal.Notify();
 	}
 }
 
@@ -658,17 +1566,40 @@ void SDKMinimalClient::OnTrackerStreamCallback(const TrackerStreamInfo* const p_
 {
 	if (s_Instance)
 	{
-		TrackerDataCollection* t_TrackerData = new TrackerDataCollection();
+		const int64_t t_ReceiveSteadyNs = FrameSignal::SteadyNowNs();
+		const int64_t t_ReceiveTimeNs = SystemNowNs();
+		s_Instance->AdoptCallbackThread();
+		TrackerDataCollection* t_TrackerData = &s_Instance->m_TrackerBuffer.WriteBuffer();
+		t_TrackerData->publishTime = p_TrackerStreamInfo->publishTime;
+		t_TrackerData->receiveTimeNs = t_ReceiveTimeNs;
+		t_TrackerData->receiveSteadyNs = t_ReceiveSteadyNs;
+
+		const size_t t_TrackerCount = t_TrackerData->trackerData.resize(p_TrackerStreamInfo->trackerCount);
 
-		t_TrackerData->trackerData.resize(p_TrackerStreamInfo->trackerCount);
+		for (uint32_t i = 0; i < t_TrackerCount; i++)
+		{
+			if (s_DataSource != nullptr)
+			{
+				s_DataSource->GetTrackerData(i, &t_TrackerData->trackerData[i]);
+			}
+			else
+			{
+				CoreSdk_GetTrackerData(i, &t_TrackerData->trackerData[i]);
+			}
+		}
 
-		for (uint32_t i = 0; i < p_TrackerStreamInfo->trackerCount; i++)
+		if (s_Instance->m_Recorder.IsOpen())
 		{
-			CoreSdk_GetTrackerData(i, &t_TrackerData->trackerData[i]);
+			TrackerStreamInfo t_StreamInfo = *p_TrackerStreamInfo;
+			t_StreamInfo.trackerCount = (uint32_t)t_TrackerCount;
+			const StreamRecorder::Segment t_Segments[2] = {
+				{ &t_StreamInfo, sizeof(t_StreamInfo) },
+				{ t_TrackerData->trackerData.data(), t_TrackerCount * sizeof(TrackerData) }
+			};
+			s_Instance->m_Recorder.Append(StreamRecordType::Tracker, t_ReceiveSteadyNs, t_ReceiveTimeNs, t_Segments, 2);
 		}
-		s_Instance->m_TrackerMutex.lock();
-		if (s_Instance->m_NextTrackerData != nullptr) delete s_Instance->m_NextTrackerData;
-		s_Instance->m_NextTrackerData = t_TrackerData;
-		s_Instance->m_TrackerMutex.unlock();
+
+		s_Instance->m_TrackerBuffer.Publish();
+		s_Instance->m_FrameSignal.Notify();
 	}
 }
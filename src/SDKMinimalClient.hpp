@@ -1,159 +1,530 @@
-/// @file SDK
-/// @brief This file contains the SDKMinimalClient class, which is based on the SDKMinimalClient_Linux demo provided
-/// by Manus with some modifications to support two gloves, and to make it easier for our ROS 2 node to interface.
-/// This class is used to connect to the Manus Core and receive the animated skeleton data from it.
-/// @note This class was originally taken from the 2.3.0.1 SDK release, and should be compared against subsequent
-/// releases to ensure that it is up to date.
-
-
-#pragma once
-
-#include "rclcpp/rclcpp.hpp"
-#include "ManusSDK.h"
-#include <mutex>
-#include <vector>
-
-/// @brief Values that can be returned by this application.
-enum class ClientReturnCode : int
-{
-	ClientReturnCode_Success = 0,
-	ClientReturnCode_FailedPlatformSpecificInitialization,
-	ClientReturnCode_FailedToResizeWindow,
-	ClientReturnCode_FailedToInitialize,
-	ClientReturnCode_FailedToFindHosts,
-	ClientReturnCode_FailedToConnect,
-	ClientReturnCode_UnrecognizedStateEncountered,
-	ClientReturnCode_FailedToShutDownSDK,
-	ClientReturnCode_FailedPlatformSpecificShutdown,
-	ClientReturnCode_FailedToRestart,
-	ClientReturnCode_FailedWrongTimeToGetData,
-
-	ClientReturnCode_MAX_CLIENT_RETURN_CODE_SIZE
-};
-
-/// @brief Used to store the information about the final animated skeletons.
-class ClientSkeleton
-{
-public:
-	SkeletonInfo info;
-	SkeletonNode* nodes = nullptr;
-
-	~ClientSkeleton()
-	{
-		if (nodes != nullptr)delete[] nodes;
-	}
-};
-
-/// @brief Used to store all the final animated skeletons received from Core.
-class ClientSkeletonCollection
-{
-public:
-	std::vector<ClientSkeleton> skeletons;
-};
-
-/// @brief Used to store ergonomics information received from Core.
-class ClientErgonomics
-{
-public:
-	ErgonomicsData* data_left = nullptr;
-	ErgonomicsData* data_right = nullptr;
-
-	~ClientErgonomics()
-	{
-		if (data_left != nullptr)delete data_left;
-		if (data_right != nullptr)delete data_right;
-	}
-};
-
-/// @brief Used to store all the tracker data coming from Core.
-class TrackerDataCollection
-{
-public:
-	std::vector<TrackerData> trackerData;
-};
-
-
-class SDKMinimalClient 
-{
-public:
-	SDKMinimalClient(std::shared_ptr<rclcpp::Node> publisherNode);
-	~SDKMinimalClient();
-	ClientReturnCode Initialize();
-	ClientReturnCode InitializeSDK();
-	void ConnectToHost();
-	ClientReturnCode ShutDown();
-	ClientReturnCode RegisterAllCallbacks();
-    ClientReturnCode Update();
-    bool Run();
-
-    static void OnConnectedCallback(const ManusHost* const p_Host);
-
-	static void OnSkeletonStreamCallback(const SkeletonStreamInfo* const p_SkeletonStreamInfo);
-
-	static void OnTrackerStreamCallback(const TrackerStreamInfo* const p_TrackerStreamInfo);
-
-	bool HasNewSkeletonData() { return m_HasNewSkeletonData; }
-	ClientSkeletonCollection* CurrentSkeletons() { return m_Skeleton; }
-
-	static void OnLandscapeCallback(const Landscape* const p_Landscape);
-
-	static void OnErgonomicsStreamCallback(const ErgonomicsStream* const p_ErgonomicsStream);
-
-	bool HasNewErgonomicsData() { return m_HasNewErognomicsData; }
-	ClientErgonomics* CurrentErgonomics() { return m_Ergonomics; }
-
-	uint32_t GetRightHandID() { return m_GloveIDs[0]; }
-	uint32_t GetLeftHandID() { return m_GloveIDs[1]; }
-
-	bool HasNewTrackerData() { return m_HasNewTrackerData; }
-	TrackerDataCollection* CurrentTrackerData() { return m_TrackerData; }
-
-	static SDKMinimalClient* GetInstance() { return s_Instance; }
-
-protected:
-
-	ClientReturnCode Connect();
-	bool SetupHandNodes(uint32_t p_SklIndex, bool isRightHand);
-	bool SetupHandNodesLeft(uint32_t p_SklIndex);
-	bool SetupHandNodesRight(uint32_t p_SklIndex);
-	bool SetupHandChains(uint32_t p_SklIndex, bool isRightHand);
-	void LoadTestSkeleton();
-	NodeSetup CreateNodeSetup(uint32_t p_Id, uint32_t p_ParentId, float p_PosX, float p_PosY, float p_PosZ, std::string p_Name);
-	static ManusVec3 CreateManusVec3(float p_X, float p_Y, float p_Z);
-
-	static SDKMinimalClient* s_Instance;
-
-	std::mutex m_SkeletonMutex;
-
-	bool m_HasNewSkeletonData = false;
-	ClientSkeletonCollection* m_NextSkeleton = nullptr;
-	ClientSkeletonCollection* m_Skeleton = nullptr;
-
-	std::mutex m_ErgonomicsMutex;
-
-	bool m_HasNewErognomicsData = false;
-	ClientErgonomics* m_NextErgonomics = nullptr;
-	ClientErgonomics* m_Ergonomics = nullptr;
-	
-	std::mutex m_TrackerMutex;
-
-	bool m_HasNewTrackerData = false;
-	TrackerDataCollection* m_NextTrackerData = nullptr;
-	TrackerDataCollection* m_TrackerData = nullptr;
-
-	std::mutex m_LandscapeMutex;
-	Landscape* m_NewLandscape = nullptr;
-	Landscape* m_Landscape = nullptr;
-	std::vector<GestureLandscapeData> m_NewGestureLandscapeData;
-	std::vector<GestureLandscapeData> m_GestureLandscapeData;
-
-	uint32_t m_GloveIDs[2] = { 0, 0 }; // ID's for Right ()
-
-	// Notice that m_First[Left|Reight]GloveID are different from m_GloveIDs above: they are read from landscape data and are needed for mapping ergonomics data to the correct glove.
-	uint32_t m_FirstLeftGloveID = 0;
-	uint32_t m_FirstRightGloveID = 0;
-
-	uint32_t m_FrameCounter = 0;
-
-	std::shared_ptr<rclcpp::Node> m_PublisherNode;
-};
+/// @file SDK
+/// @brief This file contains the SDKMinimalClient class, which is based on the SDKMinimalClient_Linux demo provided
+/// by Manus with some modifications to support two gloves, and to make it easier for our ROS 2 node to interface.
+/// This class is used to connect to the Manus Core and receive the animated skeleton data from it.
+/// @note This class was originally taken from the 2.3.0.1 SDK release, and should be compared against subsequent
+/// releases to ensure that it is up to date.
+
+
+#pragma once
+
+#include "rclcpp/rclcpp.hpp"
+#include "ManusSDK.h"
+#include "FixedVector.hpp"
+#include "FrameSignal.hpp"
+#include "LatencyStats.hpp"
+#include "ManusClock.hpp"
+#include "StreamRecorder.hpp"
+#include "ThreadConfig.hpp"
+#include "TripleBuffer.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Values that can be returned by this application.
+enum class ClientReturnCode : int
+{
+	ClientReturnCode_Success = 0,
+	ClientReturnCode_FailedPlatformSpecificInitialization,
+	ClientReturnCode_FailedToResizeWindow,
+	ClientReturnCode_FailedToInitialize,
+	ClientReturnCode_FailedToFindHosts,
+	ClientReturnCode_FailedToConnect,
+	ClientReturnCode_UnrecognizedStateEncountered,
+	ClientReturnCode_FailedToShutDownSDK,
+	ClientReturnCode_FailedPlatformSpecificShutdown,
+	ClientReturnCode_FailedToRestart,
+	ClientReturnCode_FailedWrongTimeToGetData,
+
+	ClientReturnCode_MAX_CLIENT_RETURN_CODE_SIZE
+};
+
+/// @brief Used to store the information about the final animated skeletons.
+/// Storage is inline and sized for the largest skeleton Core can send, so frames can be received without allocating.
+class ClientSkeleton
+{
+public:
+	SkeletonInfo info;
+	FixedVector<SkeletonNode, MAX_NUMBER_OF_NODES_PER_ESTIMATION_SKELETON> nodes;
+};
+
+/// @brief Used to store all the final animated skeletons received from Core.
+class ClientSkeletonCollection
+{
+public:
+	FixedVector<ClientSkeleton, MAX_NUMBER_OF_SKELETONS> skeletons;
+	ManusTimestamp publishTime = {};
+	int64_t receiveTimeNs = 0; // local wall clock time the callback was entered, see SystemNowNs()
+	int64_t receiveSteadyNs = 0; // steady clock time the callback was entered, for latency measurements
+};
+
+/// @brief A raw estimation skeleton of a glove, as estimated by Core before retargeting.
+class ClientRawSkeleton
+{
+public:
+	RawSkeletonInfo info;
+	Side side = Side::Side_Invalid; // of the first left and right glove in the landscape, invalid for others
+	FixedVector<SkeletonNode, MAX_NUMBER_OF_NODES_PER_ESTIMATION_SKELETON> nodes;
+};
+
+/// @brief The raw skeletons of all gloves received in one raw skeleton stream frame.
+class ClientRawSkeletonCollection
+{
+public:
+	FixedVector<ClientRawSkeleton, MAX_NUMBER_OF_GLOVES> skeletons;
+	ManusTimestamp publishTime = {};
+	int64_t receiveTimeNs = 0;
+	int64_t receiveSteadyNs = 0;
+};
+
+/// @brief The node layout of the raw skeleton of a glove, indexed like its nodes.
+class RawSkeletonLayout
+{
+public:
+	uint32_t gloveID = 0;
+	std::vector<NodeInfo> nodes;
+};
+
+/// @brief Used to store ergonomics information received from Core.
+class ClientErgonomics
+{
+public:
+	ErgonomicsData data_left = {};
+	ErgonomicsData data_right = {};
+	ManusTimestamp publishTime = {};
+	int64_t receiveTimeNs = 0;
+	int64_t receiveSteadyNs = 0;
+};
+
+/// @brief Used to store all the tracker data coming from Core.
+class TrackerDataCollection
+{
+public:
+	FixedVector<TrackerData, MAX_NUMBER_OF_TRACKERS> trackerData;
+	ManusTimestamp publishTime = {};
+	int64_t receiveTimeNs = 0;
+	int64_t receiveSteadyNs = 0;
+};
+
+/// @brief Most gestures kept per glove, see SDKMinimalClient::SetGestureTopK().
+static constexpr uint32_t c_MaxGestureTopK = 8;
+
+/// @brief The most probable gestures of a glove, highest probability first.
+class GloveGestures
+{
+public:
+	uint32_t gloveID = 0;
+	Side side = Side::Side_Invalid; // of the first left and right glove in the landscape, invalid for others
+	uint32_t totalGestureCount = 0; // gestures Core classified, of which the top ones are kept
+	FixedVector<GestureProbability, c_MaxGestureTopK> top;
+};
+
+/// @brief The gloves of a gesture stream frame. Core only sends the gloves whose data changed since the last frame.
+class ClientGestureCollection
+{
+public:
+	FixedVector<GloveGestures, MAX_NUMBER_OF_GLOVES> gloves;
+	ManusTimestamp publishTime = {};
+	int64_t receiveTimeNs = 0;
+	int64_t receiveSteadyNs = 0;
+};
+
+/// @brief Which user and hand a hand skeleton loaded by this client belongs to.
+struct HandSkeletonRoute
+{
+	uint32_t skeletonID = 0;
+	uint32_t userID = 0;
+	uint32_t userSlot = 0; // Dense index of the user, assigned on first sight and kept for the lifetime of the client.
+	bool isRightHand = false;
+};
+
+/// @brief The routes of all loaded hand skeletons, sorted by skeleton ID so a lookup is a binary search.
+class HandSkeletonRoutes
+{
+public:
+	const HandSkeletonRoute* Find(uint32_t p_SkeletonID) const
+	{
+		const HandSkeletonRoute* t_Route = std::lower_bound(routes.begin(), routes.end(), p_SkeletonID,
+			[](const HandSkeletonRoute& p_Route, uint32_t p_ID) { return p_Route.skeletonID < p_ID; });
+		return (t_Route != routes.end() && t_Route->skeletonID == p_SkeletonID) ? t_Route : nullptr;
+	}
+
+	/// @brief Adds a route, replacing any route for the same skeleton.
+	void Add(const HandSkeletonRoute& p_Route)
+	{
+		RemoveIf([&p_Route](const HandSkeletonRoute& p_Existing) { return p_Existing.skeletonID == p_Route.skeletonID; });
+		if (routes.size() == routes.capacity()) return;
+		size_t t_Index = routes.size();
+		routes.resize(t_Index + 1);
+		for (; t_Index > 0 && routes[t_Index - 1].skeletonID > p_Route.skeletonID; t_Index--)
+		{
+			routes[t_Index] = routes[t_Index - 1];
+		}
+		routes[t_Index] = p_Route;
+	}
+
+	void RemoveUser(uint32_t p_UserSlot)
+	{
+		RemoveIf([p_UserSlot](const HandSkeletonRoute& p_Existing) { return p_Existing.userSlot == p_UserSlot; });
+	}
+
+	FixedVector<HandSkeletonRoute, MAX_NUMBER_OF_SKELETONS> routes;
+
+private:
+	template <typename PredicateT>
+	void RemoveIf(PredicateT p_Predicate)
+	{
+		routes.resize((size_t)(std::remove_if(routes.begin(), routes.end(), p_Predicate) - routes.begin()));
+	}
+};
+
+/// @brief Where the client is in connecting to Manus Core.
+enum class ConnectionState : uint8_t
+{
+	Disconnected = 0, // not connected, waiting to retry
+	Connecting,       // looking for a host and connecting to it
+	LoadingSkeletons, // connected, uploading the hand skeletons
+	Streaming,        // skeletons loaded, frames are expected
+};
+
+inline const char* ConnectionStateName(ConnectionState p_State)
+{
+	switch (p_State)
+	{
+	case ConnectionState::Disconnected: return "disconnected";
+	case ConnectionState::Connecting: return "connecting";
+	case ConnectionState::LoadingSkeletons: return "loading skeletons";
+	case ConnectionState::Streaming: return "streaming";
+	default: return "unknown";
+	}
+}
+
+/// @brief The connection as handed to the connection listener on every change.
+struct ConnectionStatus
+{
+	ConnectionState state = ConnectionState::Disconnected;
+	std::string host;
+	// Connections lost since the client started.
+	uint32_t disconnectCount = 0;
+	// From losing the connection (or starting to connect, for the first connection) to the first skeleton frame after
+	// it, in seconds. 0 until the first frame arrived.
+	double recoverSeconds = 0.0;
+	// Time the hand skeletons of the session took to upload, in seconds, and how many of them were restored from the
+	// skeleton cache rather than built node by node.
+	double skeletonLoadSeconds = 0.0;
+	uint32_t skeletonsRestored = 0;
+	uint32_t skeletonsBuilt = 0;
+};
+
+/// @brief Supplies the per-index skeleton and tracker data the stream callbacks fetch, in place of the SDK.
+/// Lets the callbacks be driven from a recording, see StreamReplay.
+class StreamDataSource
+{
+public:
+	virtual ~StreamDataSource() = default;
+	virtual bool GetSkeletonInfo(uint32_t p_Index, SkeletonInfo* p_Info) = 0;
+	virtual bool GetSkeletonData(uint32_t p_Index, SkeletonNode* p_Nodes, uint32_t p_NodeCount) = 0;
+	virtual bool GetTrackerData(uint32_t p_Index, TrackerData* p_Data) = 0;
+};
+
+
+class SDKMinimalClient 
+{
+public:
+	/// @brief The client only logs through the node, which must outlive it.
+	SDKMinimalClient(rclcpp::Node& publisherNode);
+	~SDKMinimalClient();
+	ClientReturnCode Initialize();
+	ClientReturnCode InitializeSDK();
+	/// @brief Connects to Manus Core from a background thread and returns right away. The thread uploads the hand
+	/// skeletons once connected, and reconnects and uploads them again whenever the connection drops.
+	void StartConnecting();
+	/// @brief Stops the connection thread. Called by ShutDown().
+	void StopConnecting();
+	ClientReturnCode ShutDown();
+	ClientReturnCode RegisterAllCallbacks();
+    ClientReturnCode Update();
+    bool Run();
+
+    static void OnConnectedCallback(const ManusHost* const p_Host);
+	static void OnDisconnectedCallback(const ManusHost* const p_Host);
+
+	static void OnSkeletonStreamCallback(const SkeletonStreamInfo* const p_SkeletonStreamInfo);
+
+	static void OnTrackerStreamCallback(const TrackerStreamInfo* const p_TrackerStreamInfo);
+
+	bool HasNewSkeletonData() { return m_HasNewSkeletonData; }
+	ClientSkeletonCollection* CurrentSkeletons() { return m_Skeleton; }
+
+	static void OnLandscapeCallback(const Landscape* const p_Landscape);
+
+	static void OnErgonomicsStreamCallback(const ErgonomicsStream* const p_ErgonomicsStream);
+
+	bool HasNewErgonomicsData() { return m_HasNewErognomicsData; }
+	ClientErgonomics* CurrentErgonomics() { return m_Ergonomics; }
+
+	uint32_t GetRightHandID() { return m_GloveIDs[0]; }
+	uint32_t GetLeftHandID() { return m_GloveIDs[1]; }
+
+	bool HasNewTrackerData() { return m_HasNewTrackerData; }
+	TrackerDataCollection* CurrentTrackerData() { return m_TrackerData; }
+
+	static void OnGestureStreamCallback(const GestureStreamInfo* const p_GestureStreamInfo);
+
+	static void OnRawSkeletonStreamCallback(const SkeletonStreamInfo* const p_RawSkeletonStreamInfo);
+
+	bool HasNewRawSkeletonData() { return m_HasNewRawSkeletonData; }
+	ClientRawSkeletonCollection* CurrentRawSkeletons() { return m_RawSkeleton; }
+
+	/// @brief Also receive the raw estimation skeletons of the gloves, before Core retargets them onto the hand
+	/// skeletons. Must be set before Initialize().
+	void SetRawSkeletons(bool p_RawSkeletons) { m_RawSkeletons = p_RawSkeletons; }
+
+	/// @brief Fetches the node layouts of the gloves that started streaming raw skeletons, or changed their node
+	/// count, since the last call. Every glove is only fetched once. Blocks on Core, call it from a housekeeping thread.
+	void TakeRawSkeletonLayouts(std::vector<RawSkeletonLayout>& p_Layouts);
+
+	/// @brief Time from each raw skeleton frame to the first retargeted skeleton frame after it, both taken at the
+	/// callback entry. The streams are not in lockstep, so this includes their phase and is not the retargeting time.
+	LatencyHistogram& GetRawSkeletonArrivalGap() { return m_RawSkeletonArrivalGap; }
+
+	bool HasNewGestureData() { return m_HasNewGestureData; }
+	ClientGestureCollection* CurrentGestures() { return m_Gestures; }
+
+	/// @brief Keep the p_TopK most probable gestures of every glove, 0 ignores the gesture stream. At most
+	/// c_MaxGestureTopK.
+	void SetGestureTopK(uint32_t p_TopK) { m_GestureTopK = std::min(p_TopK, c_MaxGestureTopK); }
+
+	/// @brief Copies the gesture IDs and names of the landscape, if they changed since the last call.
+	bool TakeGestureLandscapeChange(std::vector<GestureLandscapeData>& p_Gestures);
+
+	/// @brief Steady clock time of the last buffer swap in Run(), for latency measurements.
+	int64_t GetLastSwapSteadyNs() { return m_LastSwapSteadyNs; }
+
+	/// @brief Signalled by the stream callbacks whenever a new frame has been handed off.
+	FrameSignal& GetFrameSignal() { return m_FrameSignal; }
+
+	/// @brief Records the raw SDK streams to a preallocated log file from now on, see StreamRecorder.
+	bool StartRecording(const std::string& p_Path, size_t p_CapacityBytes);
+	void StopRecording();
+
+	/// @brief Makes the stream callbacks fetch their data from p_Source instead of the SDK, nullptr to go back.
+	/// Only valid while no live SDK session is delivering callbacks.
+	static void SetStreamDataSource(StreamDataSource* p_Source) { s_DataSource = p_Source; }
+
+	/// @brief Every user gets two hand skeletons, so this is as many users as there can be skeletons for.
+	static constexpr uint32_t c_MaxUsers = MAX_NUMBER_OF_SKELETONS / 2;
+
+	/// @brief Load hand skeletons for every user in the landscape instead of only for the first user index.
+	/// Must be set before StartConnecting().
+	void SetMultiUser(bool p_MultiUser) { m_MultiUser = p_MultiUser; }
+
+	/// @brief Loads hand skeletons for users that appeared and unloads those of users that left since the last call.
+	/// Only does SDK calls when the landscape reported a change in users. Blocks on Core, so call it from a
+	/// housekeeping thread, never from the stream callbacks or the publishing thread.
+	void UpdateUserSkeletons();
+
+	/// @brief Routes the hand skeletons of a user, as loaded from Core or read from a recording.
+	void AddUserHandSkeletons(uint32_t p_UserID, uint32_t p_RightHandID, uint32_t p_LeftHandID);
+
+	/// @brief Number of user slots assigned so far. Slots stay assigned when users leave.
+	uint32_t GetUserCount() { return m_UserCount.load(std::memory_order_acquire); }
+	uint32_t GetUserID(uint32_t p_UserSlot) { return m_UserIDs[p_UserSlot].load(std::memory_order_relaxed); }
+
+	/// @brief Route of a skeleton in the current frame, as of the last Run(). nullptr for skeletons this client did
+	/// not load. Publishing thread only.
+	const HandSkeletonRoute* FindHandSkeleton(uint32_t p_SkeletonID) const
+	{
+		return m_Routes != nullptr ? m_Routes->Find(p_SkeletonID) : nullptr;
+	}
+
+	/// @brief Vibrates the fingers of a user's glove, Thumb to Pinky with powers from 0 to 1. Fails while no hand
+	/// skeleton of the user is loaded. Blocks on Core, so call it from a thread of its own, see HapticsCommander.
+	bool VibrateFingers(uint32_t p_UserSlot, bool p_IsRightHand, const float* p_Powers);
+
+	static SDKMinimalClient* GetInstance() { return s_Instance; }
+
+	/// @brief Host name or IP address of the Manus Core host to connect to directly, before looking for hosts. Empty
+	/// connects to the cached host of the last session, if any, or looks for hosts right away. Must be set before
+	/// StartConnecting().
+	void SetHost(const std::string& p_Host) { m_Host = p_Host; }
+
+	/// @brief File the host of the last successful connection is kept in, so the next start can connect to it
+	/// directly. Empty disables the cache. Must be set before StartConnecting().
+	void SetHostCachePath(const std::string& p_Path) { m_HostCachePath = p_Path; }
+
+	/// @brief Directory the compressed hand skeleton setups are cached in, so later connects restore them in a few
+	/// calls instead of rebuilding them node by node. Empty keeps them in memory only. Must be set before
+	/// StartConnecting().
+	void SetSkeletonCacheDir(const std::string& p_Dir) { m_SkeletonCacheDir = p_Dir; }
+
+	/// @brief Called from the connection thread whenever the connection state changes, and once the first skeleton
+	/// frame after (re)connecting arrived. Must be set before StartConnecting().
+	void SetConnectionListener(std::function<void(const ConnectionStatus&)> p_Listener) { m_ConnectionListener = std::move(p_Listener); }
+
+	ConnectionState GetConnectionState() { return m_ConnectionState.load(std::memory_order_relaxed); }
+
+	/// @brief Scheduling the SDK's callback threads take on when they first deliver a callback, so they stay off the
+	/// cores of the publishing threads. Must be set before StartConnecting() or a replay starts.
+	void SetCallbackThreadRole(const ThreadRoleConfig& p_Role) { m_CallbackThreadRole = p_Role; }
+
+protected:
+
+	ClientReturnCode Connect();
+	bool ConnectDirectly(const ManusHost& p_Host);
+	void RunConnection();
+	void SetConnectionState(ConnectionState p_State, std::unique_lock<std::mutex>& p_Lock);
+	void LoadSkeletonsAfterConnect();
+	bool SetupHandNodes(uint32_t p_SklIndex, bool isRightHand);
+	bool SetupHandNodesLeft(uint32_t p_SklIndex);
+	bool SetupHandNodesRight(uint32_t p_SklIndex);
+	bool SetupHandChains(uint32_t p_SklIndex, bool isRightHand);
+	void LoadTestSkeleton();
+	bool LoadHandSkeletons(SkeletonTargetType p_TargetType, uint32_t p_Target, uint32_t& p_RightHandID, uint32_t& p_LeftHandID);
+	bool LoadHandSkeleton(SkeletonTargetType p_TargetType, uint32_t p_Target, bool p_IsRightHand, uint32_t& p_SkeletonID);
+	bool CreateHandSkeletonSetup(const SkeletonSetupInfo& p_Info, uint32_t& p_SklIndex);
+	bool RestoreHandSkeletonSetup(uint32_t p_SklIndex, uint32_t p_SessionID, const std::string& p_CacheKey);
+	void CacheHandSkeletonSetup(uint32_t p_SklIndex, uint32_t p_SessionID, const std::string& p_CacheKey);
+	std::string SkeletonCachePath(const std::string& p_CacheKey) const;
+	void RemoveUserHandSkeletons(uint32_t p_UserID);
+	void PublishRoutes();
+	NodeSetup CreateNodeSetup(uint32_t p_Id, uint32_t p_ParentId, float p_PosX, float p_PosY, float p_PosZ, std::string p_Name);
+	static ManusVec3 CreateManusVec3(float p_X, float p_Y, float p_Z);
+	void AdoptCallbackThread();
+	void QueueRawSkeletonLayout(uint32_t p_GloveID);
+
+	static SDKMinimalClient* s_Instance;
+	static StreamDataSource* s_DataSource;
+
+	// Frames are handed from the SDK callback threads to the publishing thread through wait-free triple buffers.
+	// The callbacks fill the write slot in place, Run() swaps in the newest frame and points the Current* accessors at it.
+	TripleBuffer<ClientSkeletonCollection> m_SkeletonBuffer;
+
+	bool m_HasNewSkeletonData = false;
+	ClientSkeletonCollection* m_Skeleton = nullptr;
+
+	TripleBuffer<ClientErgonomics> m_ErgonomicsBuffer;
+
+	bool m_HasNewErognomicsData = false;
+	ClientErgonomics* m_Ergonomics = nullptr;
+
+	// Latest ergonomics per hand, only touched by the ergonomics callback so a hand missing from a frame keeps its last value.
+	ErgonomicsData m_LastErgonomicsLeft = {};
+	ErgonomicsData m_LastErgonomicsRight = {};
+
+	TripleBuffer<TrackerDataCollection> m_TrackerBuffer;
+
+	bool m_HasNewTrackerData = false;
+	TrackerDataCollection* m_TrackerData = nullptr;
+
+	TripleBuffer<ClientGestureCollection> m_GestureBuffer;
+
+	bool m_HasNewGestureData = false;
+	ClientGestureCollection* m_Gestures = nullptr;
+	std::atomic<uint32_t> m_GestureTopK{ 0 };
+
+	TripleBuffer<ClientRawSkeletonCollection> m_RawSkeletonBuffer;
+
+	bool m_HasNewRawSkeletonData = false;
+	ClientRawSkeletonCollection* m_RawSkeleton = nullptr;
+	bool m_RawSkeletons = false;
+	std::atomic<int64_t> m_LastRawSkeletonSteadyNs{ 0 };
+	LatencyHistogram m_RawSkeletonArrivalGap;
+	// Node count of every glove the raw skeleton callback has seen, owned by the callback. Gloves that are new or
+	// changed are queued in m_PendingRawLayouts for TakeRawSkeletonLayouts() to fetch, once each, so the queue never
+	// outgrows its inline storage and queuing never allocates.
+	struct RawSkeletonNodeCount
+	{
+		uint32_t gloveID;
+		uint32_t nodeCount;
+	};
+	FixedVector<RawSkeletonNodeCount, MAX_NUMBER_OF_GLOVES> m_RawSkeletonNodeCounts;
+	std::mutex m_RawLayoutMutex;
+	FixedVector<uint32_t, MAX_NUMBER_OF_GLOVES> m_PendingRawLayouts;
+
+	std::mutex m_LandscapeMutex;
+	Landscape* m_NewLandscape = nullptr;
+	Landscape* m_Landscape = nullptr;
+	std::vector<GestureLandscapeData> m_NewGestureLandscapeData;
+	// The gestures last handed out by TakeGestureLandscapeChange().
+	std::vector<GestureLandscapeData> m_GestureLandscapeData;
+	bool m_GestureLandscapeChanged = false;
+
+	uint32_t m_GloveIDs[2] = { 0, 0 }; // ID's for Right ()
+
+	// Notice that m_First[Left|Reight]GloveID are different from m_GloveIDs above: they are read from landscape data and are needed for mapping ergonomics data to the correct glove.
+	uint32_t m_FirstLeftGloveID = 0;
+	uint32_t m_FirstRightGloveID = 0;
+
+	uint32_t m_FrameCounter = 0;
+
+	// Skeleton routes are written under m_RoutesMutex by whoever loads skeletons, and handed to the publishing thread
+	// through a triple buffer like the frames.
+	std::mutex m_RoutesMutex;
+	HandSkeletonRoutes m_RoutesMaster;
+	TripleBuffer<HandSkeletonRoutes> m_RoutesBuffer;
+	const HandSkeletonRoutes* m_Routes = nullptr;
+	std::array<std::atomic<uint32_t>, c_MaxUsers> m_UserIDs{};
+	std::atomic<uint32_t> m_UserCount{ 0 };
+
+	// Multi-user mode. The landscape callback flags user changes, UpdateUserSkeletons() acts on them.
+	struct LoadedUser
+	{
+		uint32_t userID;
+		uint32_t rightHandID;
+		uint32_t leftHandID;
+	};
+	bool m_MultiUser = false;
+	std::atomic<bool> m_UsersChanged{ true };
+	FixedVector<LoadedUser, c_MaxUsers> m_LoadedUsers;
+	uint32_t m_LandscapeUserIDs[MAX_USERS] = {};
+	uint32_t m_LandscapeUserCount = 0;
+
+	// Serializes loading and unloading user skeletons between the connection thread and UpdateUserSkeletons().
+	std::mutex m_UsersMutex;
+
+	// Compressed hand skeleton setups by target and side, filled from m_SkeletonCacheDir on first use.
+	std::mutex m_SkeletonCacheMutex;
+	std::string m_SkeletonCacheDir;
+	std::map<std::string, std::vector<unsigned char>> m_SkeletonCache;
+	std::atomic<uint32_t> m_SkeletonsRestored{ 0 };
+	std::atomic<uint32_t> m_SkeletonsBuilt{ 0 };
+
+	// Connection state machine. The SDK's connect and disconnect callbacks flag events under m_ConnectionMutex, the
+	// connection thread acts on them.
+	std::thread m_ConnectionThread;
+	std::mutex m_ConnectionMutex;
+	std::condition_variable m_ConnectionChanged;
+	std::atomic<ConnectionState> m_ConnectionState{ ConnectionState::Disconnected };
+	ConnectionStatus m_ConnectionStatus;
+	std::function<void(const ConnectionStatus&)> m_ConnectionListener;
+	std::string m_Host;
+	std::string m_HostCachePath;
+	// Backoff between connection attempts, doubled after every failed attempt up to c_MaxReconnectDelayMs.
+	static constexpr int64_t c_MinReconnectDelayMs = 100;
+	static constexpr int64_t c_MaxReconnectDelayMs = 800;
+	int64_t m_ReconnectDelayMs = c_MinReconnectDelayMs;
+	bool m_StopConnecting = false;
+	bool m_ConnectionLost = false;
+	// Steady clock time the connection was lost or connecting started, and of the first skeleton frame after it. The
+	// skeleton callback only sets the latter while m_AwaitingFirstFrame is set.
+	int64_t m_RecoverStartNs = 0;
+	std::atomic<bool> m_AwaitingFirstFrame{ false };
+	std::atomic<int64_t> m_FirstFrameSteadyNs{ 0 };
+
+	FrameSignal m_FrameSignal;
+	int64_t m_LastSwapSteadyNs = 0;
+
+	StreamRecorder m_Recorder;
+
+	ThreadRoleConfig m_CallbackThreadRole;
+
+	rclcpp::Node* m_PublisherNode;
+};
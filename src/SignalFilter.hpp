@@ -0,0 +1,299 @@
+/// @file SignalFilter.hpp
+/// @brief Low-latency smoothing of the streamed values before they are published: One Euro, critically damped and
+/// median outlier-rejection filters over a bank of channels, with the filter state stored as structure of arrays so
+/// one pass over contiguous memory covers every joint of every skeleton.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+
+
+enum class SignalFilterType : int
+{
+	None = 0,
+	OneEuro,          // adaptive low pass, little smoothing while moving fast and a lot while (nearly) still
+	CriticallyDamped, // second order spring without overshoot, smooths evenly at every speed
+	Median            // median of the last few samples, replacing samples that stray too far from it
+};
+
+/// @brief Parses the filter names used by the node parameters: none, one_euro, critically_damped and median.
+inline bool ParseSignalFilterType(const std::string& p_Name, SignalFilterType& p_Type)
+{
+	if (p_Name == "none") p_Type = SignalFilterType::None;
+	else if (p_Name == "one_euro") p_Type = SignalFilterType::OneEuro;
+	else if (p_Name == "critically_damped") p_Type = SignalFilterType::CriticallyDamped;
+	else if (p_Name == "median") p_Type = SignalFilterType::Median;
+	else return false;
+	return true;
+}
+
+struct SignalFilterConfig
+{
+	SignalFilterType type = SignalFilterType::None;
+
+	// One Euro (Casiez et al. 2012): cutoff = minCutoffHz + beta * |smoothed rate of change|.
+	double minCutoffHz = 1.0;
+	double beta = 0.0;
+	double derivativeCutoffHz = 1.0;
+
+	// Critically damped: time the output takes to settle on a step, roughly.
+	double timeConstantS = 0.02;
+
+	// Median: window of 3 or 5 samples. Samples within outlierThreshold of the median pass through unchanged, the rest
+	// are replaced by the median; 0 always outputs the median.
+	uint32_t medianWindow = 5;
+	double outlierThreshold = 0.0;
+};
+
+/// @brief Filters a fixed set of channels that are sampled together, such as every joint of a frame.
+/// Values are passed as one array per component (x, y, z, ...) with one entry per element, and all state is kept in
+/// the same layout, so every filter is one branch-free pass over contiguous arrays. The passes work on blocks of
+/// c_Lanes elements as fixed-size Eigen arrays, which map onto SIMD registers without depending on the optimizer's
+/// loop vectorization. Optionally four of the components are a quaternion, which is kept in the hemisphere of the
+/// previous output before filtering and renormalized after. Not thread safe: use it from the publishing thread only.
+class SignalFilterBank
+{
+public:
+	static constexpr size_t c_Lanes = 4;
+	static constexpr double c_MaxGapS = 0.25;
+	static constexpr double c_MinDtS = 1e-4;
+
+	/// @brief Sets the filter and allocates the state for p_Capacity elements of p_Components components each.
+	/// @param p_QuaternionComponent First of four components holding a quaternion, or -1 if there is none.
+	void Configure(const SignalFilterConfig& p_Config, size_t p_Components, size_t p_Capacity, int p_QuaternionComponent = -1)
+	{
+		m_Config = p_Config;
+		if (m_Config.medianWindow != 3 && m_Config.medianWindow != 5) m_Config.medianWindow = 5;
+		m_Components = p_Components;
+		m_Capacity = (p_Capacity + c_Lanes - 1) / c_Lanes * c_Lanes;
+		m_QuaternionComponent = p_QuaternionComponent;
+
+		const size_t t_Channels = m_Components * m_Capacity;
+		m_Value.assign(t_Channels, 0.0);
+		m_Rate.assign(t_Channels, 0.0);
+		m_History.assign(m_Config.type == SignalFilterType::Median ? t_Channels * m_Config.medianWindow : 0, 0.0);
+		m_HistoryHead = 0;
+		m_Seed.assign(m_Capacity, 1);
+		m_LastTimeNs = 0;
+	}
+
+	bool IsEnabled() const { return m_Config.type != SignalFilterType::None; }
+
+	/// @brief Restarts the filters of elements [p_Begin, p_End), for instance when a different skeleton took their
+	/// place. Their next sample passes through unfiltered and becomes the state.
+	void Reset(size_t p_Begin, size_t p_End)
+	{
+		std::fill(m_Seed.begin() + std::min(p_Begin, m_Capacity), m_Seed.begin() + std::min(p_End, m_Capacity), 1);
+	}
+
+	/// @brief Filters elements [0, p_Count) in place.
+	/// @param p_Values One array per component. Each must hold p_Count rounded up to a multiple of c_Lanes elements;
+	/// the elements past p_Count are filtered along and should be ignored.
+	/// @param p_TimeNs Sample time of the frame. Frames further than c_MaxGapS apart restart every filter.
+	void Process(double* const* p_Values, size_t p_Count, int64_t p_TimeNs)
+	{
+		if (!IsEnabled() || p_Count == 0) return;
+		p_Count = std::min((p_Count + c_Lanes - 1) / c_Lanes * c_Lanes, m_Capacity);
+
+		double t_Dt = (double)(p_TimeNs - m_LastTimeNs) * 1e-9;
+		if (m_LastTimeNs == 0 || t_Dt > c_MaxGapS || t_Dt < 0.0)
+		{
+			Reset(0, m_Capacity);
+		}
+		// Frames stamped alike (coarse timestamps) still count as a step forward.
+		t_Dt = std::min(std::max(t_Dt, c_MinDtS), c_MaxGapS);
+		m_LastTimeNs = p_TimeNs;
+
+		SeedElements(p_Values, p_Count);
+		if (m_QuaternionComponent >= 0) AlignQuaternions(p_Values, p_Count);
+
+		for (size_t c = 0; c < m_Components; c++)
+		{
+			double* t_Values = p_Values[c];
+			double* t_Value = &m_Value[c * m_Capacity];
+			double* t_Rate = &m_Rate[c * m_Capacity];
+			switch (m_Config.type)
+			{
+			case SignalFilterType::OneEuro: OneEuroPass(t_Values, t_Value, t_Rate, p_Count, t_Dt); break;
+			case SignalFilterType::CriticallyDamped: CriticallyDampedPass(t_Values, t_Value, t_Rate, p_Count, t_Dt); break;
+			case SignalFilterType::Median: MedianPass(t_Values, c, p_Count); break;
+			default: break;
+			}
+		}
+		if (m_Config.type == SignalFilterType::Median) m_HistoryHead = (m_HistoryHead + 1) % m_Config.medianWindow;
+
+		if (m_QuaternionComponent >= 0)
+		{
+			NormalizeQuaternions(p_Values, p_Count);
+			// The median keeps no output of its own, but the next alignment needs one.
+			if (m_Config.type == SignalFilterType::Median)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					const double* t_Q = p_Values[m_QuaternionComponent + c];
+					std::copy(t_Q, t_Q + p_Count, &m_Value[(m_QuaternionComponent + c) * m_Capacity]);
+				}
+			}
+		}
+	}
+
+private:
+	using Block = Eigen::Array<double, c_Lanes, 1>;
+	using BlockMap = Eigen::Map<Block>;
+	using ConstBlockMap = Eigen::Map<const Block>;
+
+	void OneEuroPass(double* p_Values, double* p_Value, double* p_Rate, size_t p_Count, double p_Dt) const
+	{
+		// Exponential smoothing factor of a first order low pass: 1 / (1 + tau / dt) with tau = 1 / (2 pi fc), which
+		// is k / (k + 1) with k = 2 pi fc dt.
+		const double t_TwoPiDt = 2.0 * M_PI * p_Dt;
+		const double t_RateK = t_TwoPiDt * m_Config.derivativeCutoffHz;
+		const double t_RateAlpha = t_RateK / (t_RateK + 1.0);
+		const double t_InvDt = 1.0 / p_Dt;
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			BlockMap t_Values(p_Values + i);
+			BlockMap t_Value(p_Value + i);
+			BlockMap t_Rate(p_Rate + i);
+			t_Rate += t_RateAlpha * ((t_Values - t_Value) * t_InvDt - t_Rate);
+			const Block t_K = t_TwoPiDt * (m_Config.minCutoffHz + m_Config.beta * t_Rate.abs());
+			t_Value += t_K / (t_K + 1.0) * (t_Values - t_Value);
+			t_Values = t_Value;
+		}
+	}
+
+	void CriticallyDampedPass(double* p_Values, double* p_Value, double* p_Rate, size_t p_Count, double p_Dt) const
+	{
+		// One step of a critically damped spring pulled towards the sample, with its exponential decay approximated by
+		// a polynomial (Game Programming Gems 4, 1.10) that keeps it stable for any dt.
+		const double t_Omega = 2.0 / std::max(m_Config.timeConstantS, 1e-6);
+		const double t_X = t_Omega * p_Dt;
+		const double t_Decay = 1.0 / (1.0 + t_X + 0.48 * t_X * t_X + 0.235 * t_X * t_X * t_X);
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			BlockMap t_Values(p_Values + i);
+			BlockMap t_Value(p_Value + i);
+			BlockMap t_Rate(p_Rate + i);
+			const Block t_Offset = t_Value - t_Values;
+			const Block t_Step = (t_Rate + t_Omega * t_Offset) * p_Dt;
+			t_Rate = (t_Rate - t_Omega * t_Step) * t_Decay;
+			t_Value = t_Values + (t_Offset + t_Step) * t_Decay;
+			t_Values = t_Value;
+		}
+	}
+
+	void MedianPass(double* p_Values, size_t p_Component, size_t p_Count)
+	{
+		const size_t t_Stride = m_Components * m_Capacity;
+		const size_t t_Base = p_Component * m_Capacity;
+		std::copy(p_Values, p_Values + p_Count, &m_History[m_HistoryHead * t_Stride + t_Base]);
+
+		const double* t_History[5] = {};
+		for (uint32_t h = 0; h < m_Config.medianWindow; h++) t_History[h] = &m_History[h * t_Stride + t_Base];
+		const double t_Threshold = m_Config.outlierThreshold;
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			BlockMap t_Values(p_Values + i);
+			const ConstBlockMap h0(t_History[0] + i), h1(t_History[1] + i), h2(t_History[2] + i);
+			Block t_Median;
+			if (m_Config.medianWindow == 3)
+			{
+				t_Median = Median3(h0, h1, h2);
+			}
+			else
+			{
+				// Median of five as the median of the fifth and the middle two of the sorted pairs.
+				const ConstBlockMap h3(t_History[3] + i), h4(t_History[4] + i);
+				t_Median = Median3(h4, h0.min(h1).max(h2.min(h3)), h0.max(h1).min(h2.max(h3)));
+			}
+			if (t_Threshold > 0.0)
+			{
+				t_Values = ((t_Values - t_Median).abs() <= t_Threshold).select(t_Values, t_Median);
+			}
+			else
+			{
+				t_Values = t_Median;
+			}
+		}
+	}
+
+	static Block Median3(const Block& p_A, const Block& p_B, const Block& p_C)
+	{
+		return p_A.min(p_B).max(p_A.max(p_B).min(p_C));
+	}
+
+	/// @brief Starts the elements flagged by Reset() at their current sample, at rest.
+	void SeedElements(double* const* p_Values, size_t p_Count)
+	{
+		const uint32_t t_HistoryLength = m_Config.type == SignalFilterType::Median ? m_Config.medianWindow : 0;
+		for (size_t i = 0; i < p_Count; i++)
+		{
+			if (!m_Seed[i]) continue;
+			m_Seed[i] = 0;
+			for (size_t c = 0; c < m_Components; c++)
+			{
+				m_Value[c * m_Capacity + i] = p_Values[c][i];
+				m_Rate[c * m_Capacity + i] = 0.0;
+				for (uint32_t h = 0; h < t_HistoryLength; h++)
+				{
+					m_History[(h * m_Components + c) * m_Capacity + i] = p_Values[c][i];
+				}
+			}
+		}
+	}
+
+	/// @brief Flips sample quaternions that lie in the opposite hemisphere of the previous output, so the component
+	/// wise filters do not average q with -q.
+	void AlignQuaternions(double* const* p_Values, size_t p_Count) const
+	{
+		double* const* t_Q = p_Values + m_QuaternionComponent;
+		const double* t_Last = &m_Value[m_QuaternionComponent * m_Capacity];
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			BlockMap q0(t_Q[0] + i), q1(t_Q[1] + i), q2(t_Q[2] + i), q3(t_Q[3] + i);
+			const Block t_Dot = q0 * ConstBlockMap(t_Last + i) + q1 * ConstBlockMap(t_Last + m_Capacity + i)
+				+ q2 * ConstBlockMap(t_Last + 2 * m_Capacity + i) + q3 * ConstBlockMap(t_Last + 3 * m_Capacity + i);
+			const Block t_Sign = (t_Dot < 0.0).select(Block::Constant(-1.0), Block::Constant(1.0));
+			q0 *= t_Sign;
+			q1 *= t_Sign;
+			q2 *= t_Sign;
+			q3 *= t_Sign;
+		}
+	}
+
+	void NormalizeQuaternions(double* const* p_Values, size_t p_Count) const
+	{
+		double* const* t_Q = p_Values + m_QuaternionComponent;
+		for (size_t i = 0; i < p_Count; i += c_Lanes)
+		{
+			BlockMap q0(t_Q[0] + i), q1(t_Q[1] + i), q2(t_Q[2] + i), q3(t_Q[3] + i);
+			const Block t_Norm = (q0.square() + q1.square() + q2.square() + q3.square()).sqrt();
+			const Block t_Scale = (t_Norm > 0.0).select(t_Norm.inverse(), Block::Constant(1.0));
+			q0 *= t_Scale;
+			q1 *= t_Scale;
+			q2 *= t_Scale;
+			q3 *= t_Scale;
+		}
+	}
+
+	SignalFilterConfig m_Config;
+	size_t m_Components = 0;
+	size_t m_Capacity = 0; // rounded up to whole blocks
+	int m_QuaternionComponent = -1;
+
+	// Indexed [component * capacity + element]: the last output and, per filter, its rate of change.
+	std::vector<double> m_Value;
+	std::vector<double> m_Rate;
+	// Median only, indexed [(sample * components + component) * capacity + element], a ring of the last samples.
+	std::vector<double> m_History;
+	uint32_t m_HistoryHead = 0;
+	std::vector<uint8_t> m_Seed;
+	int64_t m_LastTimeNs = 0;
+};
@@ -0,0 +1,124 @@
+/// @file StreamLog.hpp
+/// @brief On-disk layout of the binary stream logs written by StreamRecorder.
+/// A log is a StreamLogHeader followed by records, each a StreamRecordHeader followed by its payload. All structs are
+/// written as the raw SDK structs of the build that recorded them, so the header stores their sizes and a reader
+/// rejects logs recorded with an incompatible SDK.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "ManusSDKTypes.h"
+
+
+/// @brief Types of the records in a stream log.
+/// Payloads, all fields in the SDK layout:
+///  - Skeleton:   SkeletonStreamInfo, then per skeleton a SkeletonInfo followed by SkeletonInfo::nodesCount SkeletonNodes.
+///  - Ergonomics: ErgonomicsRecordInfo, then ErgonomicsRecordInfo::dataCount ErgonomicsData.
+///  - Tracker:    TrackerStreamInfo, then TrackerStreamInfo::trackerCount TrackerData.
+///  - Landscape:  Landscape.
+///  - HandSkeletons: HandSkeletonsRecordInfo, written whenever the hand skeletons of a user have been loaded.
+enum class StreamRecordType : uint32_t
+{
+	Invalid = 0,
+	Skeleton,
+	Ergonomics,
+	Tracker,
+	Landscape,
+	HandSkeletons,
+};
+
+/// @brief Head of an ergonomics record. Only the used slots of an ErgonomicsStream are recorded.
+struct ErgonomicsRecordInfo
+{
+	ManusTimestamp publishTime;
+	uint32_t dataCount;
+	uint32_t reserved;
+};
+
+/// @brief IDs Core assigned to the hand skeletons the client loaded for a user, needed to tell the users and hands
+/// apart on replay.
+struct HandSkeletonsRecordInfo
+{
+	uint32_t userId;
+	uint32_t rightHandId;
+	uint32_t leftHandId;
+	uint32_t reserved;
+};
+
+struct StreamRecordHeader
+{
+	uint32_t size; // Total size of the record including this header and padding. Written last, 0 means not committed.
+	uint32_t type; // StreamRecordType
+	int64_t receiveSteadyNs; // Steady clock time the SDK callback was entered.
+	int64_t receiveTimeNs; // Wall clock time the SDK callback was entered, nanoseconds since the Unix epoch.
+};
+
+struct StreamLogHeader
+{
+	static constexpr char c_Magic[8] = { 'M', 'A', 'N', 'U', 'S', 'L', 'O', 'G' };
+	static constexpr uint32_t c_Version = 2;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+
+	// Sizes of the SDK structs in the payloads, to detect logs recorded against a different SDK.
+	uint32_t skeletonStreamInfoSize;
+	uint32_t skeletonInfoSize;
+	uint32_t skeletonNodeSize;
+	uint32_t ergonomicsDataSize;
+	uint32_t trackerStreamInfoSize;
+	uint32_t trackerDataSize;
+	uint32_t landscapeSize;
+	uint32_t reserved;
+
+	int64_t startTimeNs; // Wall clock time recording started.
+	int64_t startSteadyNs; // Steady clock time recording started.
+
+	/// @brief A header describing the SDK structs of this build.
+	static StreamLogHeader Create(int64_t p_StartTimeNs, int64_t p_StartSteadyNs)
+	{
+		StreamLogHeader t_Header = {};
+		memcpy(t_Header.magic, c_Magic, sizeof(c_Magic));
+		t_Header.version = c_Version;
+		t_Header.headerSize = sizeof(StreamLogHeader);
+		t_Header.skeletonStreamInfoSize = sizeof(SkeletonStreamInfo);
+		t_Header.skeletonInfoSize = sizeof(SkeletonInfo);
+		t_Header.skeletonNodeSize = sizeof(SkeletonNode);
+		t_Header.ergonomicsDataSize = sizeof(ErgonomicsData);
+		t_Header.trackerStreamInfoSize = sizeof(TrackerStreamInfo);
+		t_Header.trackerDataSize = sizeof(TrackerData);
+		t_Header.landscapeSize = sizeof(Landscape);
+		t_Header.startTimeNs = p_StartTimeNs;
+		t_Header.startSteadyNs = p_StartSteadyNs;
+		return t_Header;
+	}
+
+	/// @brief Whether a log with this header can be read by this build.
+	bool IsCompatible() const
+	{
+		const StreamLogHeader t_Expected = Create(0, 0);
+		return memcmp(magic, c_Magic, sizeof(c_Magic)) == 0
+			&& version == c_Version
+			&& headerSize == t_Expected.headerSize
+			&& skeletonStreamInfoSize == t_Expected.skeletonStreamInfoSize
+			&& skeletonInfoSize == t_Expected.skeletonInfoSize
+			&& skeletonNodeSize == t_Expected.skeletonNodeSize
+			&& ergonomicsDataSize == t_Expected.ergonomicsDataSize
+			&& trackerStreamInfoSize == t_Expected.trackerStreamInfoSize
+			&& trackerDataSize == t_Expected.trackerDataSize
+			&& landscapeSize == t_Expected.landscapeSize;
+	}
+};
+
+/// @brief Records are padded so every header stays 8 byte aligned.
+constexpr size_t c_StreamRecordAlignment = 8;
+
+inline size_t StreamRecordSize(size_t p_PayloadSize)
+{
+	const size_t t_Size = sizeof(StreamRecordHeader) + p_PayloadSize;
+	return (t_Size + c_StreamRecordAlignment - 1) & ~(c_StreamRecordAlignment - 1);
+}
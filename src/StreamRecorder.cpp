@@ -0,0 +1,203 @@
+#include "StreamRecorder.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FrameSignal.hpp"
+#include "ManusClock.hpp"
+
+
+StreamRecorder::~StreamRecorder()
+{
+	std::string t_Error;
+	Close(t_Error);
+}
+
+bool StreamRecorder::Open(const std::string& p_Path, size_t p_CapacityBytes, std::string& p_Error)
+{
+	if (m_Fd >= 0)
+	{
+		p_Error = "already recording to " + m_Path;
+		return false;
+	}
+
+	m_PageSize = (size_t)sysconf(_SC_PAGESIZE);
+	m_Capacity = (p_CapacityBytes + m_PageSize - 1) / m_PageSize * m_PageSize;
+	if (m_Capacity < sizeof(StreamLogHeader) + m_PageSize)
+	{
+		p_Error = "capacity is too small";
+		return false;
+	}
+
+	m_Fd = open(p_Path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (m_Fd < 0)
+	{
+		p_Error = "cannot create " + p_Path + ": " + strerror(errno);
+		return false;
+	}
+
+	// Reserve the blocks up front so the writers can never hit ENOSPC through the mapping.
+	const int t_AllocateResult = posix_fallocate(m_Fd, 0, (off_t)m_Capacity);
+	if (t_AllocateResult != 0)
+	{
+		p_Error = "cannot preallocate " + p_Path + ": " + strerror(t_AllocateResult);
+		close(m_Fd);
+		m_Fd = -1;
+		return false;
+	}
+
+	void* t_Mapping = mmap(nullptr, m_Capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_Fd, 0);
+	if (t_Mapping == MAP_FAILED)
+	{
+		p_Error = "cannot map " + p_Path + ": " + strerror(errno);
+		close(m_Fd);
+		m_Fd = -1;
+		return false;
+	}
+	m_Base = static_cast<uint8_t*>(t_Mapping);
+	madvise(m_Base, m_Capacity, MADV_SEQUENTIAL);
+
+	const StreamLogHeader t_Header = StreamLogHeader::Create(SystemNowNs(), FrameSignal::SteadyNowNs());
+	memcpy(m_Base, &t_Header, sizeof(t_Header));
+
+	m_Path = p_Path;
+	m_Reserved.store(sizeof(StreamLogHeader), std::memory_order_relaxed);
+	m_Limit.store(sizeof(StreamLogHeader), std::memory_order_relaxed);
+	m_Dropped.store(0, std::memory_order_relaxed);
+	m_Committed = sizeof(StreamLogHeader);
+	m_WrittenBack = 0;
+	PrefaultAhead();
+
+	m_StopFlush = false;
+	m_FlushThread = std::thread(&StreamRecorder::FlushLoop, this);
+	m_Open.store(true, std::memory_order_release);
+	return true;
+}
+
+bool StreamRecorder::Close(std::string& p_Error)
+{
+	if (m_Fd < 0) return true;
+
+	m_Open.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> t_Lock(m_FlushMutex);
+		m_StopFlush = true;
+	}
+	m_FlushCondition.notify_one();
+	if (m_FlushThread.joinable()) m_FlushThread.join();
+
+	// Anything reserved but not committed by now was cut off mid-write, leave it out of the file.
+	const size_t t_Committed = ScanCommitted();
+	msync(m_Base, t_Committed, MS_SYNC);
+	munmap(m_Base, m_Capacity);
+	m_Base = nullptr;
+	bool t_Truncated = true;
+	if (ftruncate(m_Fd, (off_t)t_Committed) != 0)
+	{
+		p_Error = "cannot truncate " + m_Path + ": " + strerror(errno);
+		t_Truncated = false;
+	}
+	close(m_Fd);
+	m_Fd = -1;
+	return t_Truncated;
+}
+
+bool StreamRecorder::Append(StreamRecordType p_Type, int64_t p_ReceiveSteadyNs, int64_t p_ReceiveTimeNs, const Segment* p_Segments, size_t p_SegmentCount)
+{
+	if (!m_Open.load(std::memory_order_acquire)) return false;
+
+	size_t t_PayloadSize = 0;
+	for (size_t i = 0; i < p_SegmentCount; i++)
+	{
+		t_PayloadSize += p_Segments[i].size;
+	}
+	const size_t t_RecordSize = StreamRecordSize(t_PayloadSize);
+
+	uint64_t t_Offset = m_Reserved.load(std::memory_order_relaxed);
+	do
+	{
+		if (t_Offset + t_RecordSize > m_Limit.load(std::memory_order_acquire))
+		{
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	} while (!m_Reserved.compare_exchange_weak(t_Offset, t_Offset + t_RecordSize, std::memory_order_relaxed));
+
+	uint8_t* t_Record = m_Base + t_Offset;
+	StreamRecordHeader* t_Header = reinterpret_cast<StreamRecordHeader*>(t_Record);
+	t_Header->type = (uint32_t)p_Type;
+	t_Header->receiveSteadyNs = p_ReceiveSteadyNs;
+	t_Header->receiveTimeNs = p_ReceiveTimeNs;
+
+	uint8_t* t_Payload = t_Record + sizeof(StreamRecordHeader);
+	for (size_t i = 0; i < p_SegmentCount; i++)
+	{
+		memcpy(t_Payload, p_Segments[i].data, p_Segments[i].size);
+		t_Payload += p_Segments[i].size;
+	}
+
+	// Publishing the size commits the record to the flush thread and to readers.
+	__atomic_store_n(&t_Header->size, (uint32_t)t_RecordSize, __ATOMIC_RELEASE);
+	return true;
+}
+
+/// @brief Advances m_Committed over the records whose size has been written.
+/// Stops at the first record still being written, so the committed range is always a prefix of whole records.
+size_t StreamRecorder::ScanCommitted()
+{
+	const uint64_t t_Reserved = m_Reserved.load(std::memory_order_acquire);
+	while (m_Committed + sizeof(StreamRecordHeader) <= t_Reserved)
+	{
+		const StreamRecordHeader* t_Header = reinterpret_cast<const StreamRecordHeader*>(m_Base + m_Committed);
+		const uint32_t t_Size = __atomic_load_n(&t_Header->size, __ATOMIC_ACQUIRE);
+		if (t_Size == 0) break;
+		m_Committed += t_Size;
+	}
+	return m_Committed;
+}
+
+/// @brief Dirties the pages past m_Limit so the writers find them mapped and writable, then raises m_Limit.
+/// Writers never touch memory past m_Limit, so writing to it here cannot race with them.
+void StreamRecorder::PrefaultAhead()
+{
+	const uint64_t t_Target = m_Reserved.load(std::memory_order_relaxed) + c_PrefaultWindowBytes;
+	uint64_t t_Limit = m_Limit.load(std::memory_order_relaxed);
+	if (t_Limit >= t_Target || t_Limit >= m_Capacity) return;
+
+	const uint64_t t_NewLimit = t_Target < m_Capacity ? t_Target : m_Capacity;
+	for (uint64_t t_Page = (t_Limit + m_PageSize - 1) / m_PageSize * m_PageSize; t_Page < t_NewLimit; t_Page += m_PageSize)
+	{
+		// The file is zero filled, so this only faults the page in for writing.
+		*reinterpret_cast<volatile uint8_t*>(m_Base + t_Page) = 0;
+	}
+	m_Limit.store(t_NewLimit, std::memory_order_release);
+}
+
+void StreamRecorder::FlushLoop()
+{
+	std::unique_lock<std::mutex> t_Lock(m_FlushMutex);
+	while (!m_StopFlush)
+	{
+		m_FlushCondition.wait_for(t_Lock, std::chrono::milliseconds(10));
+		t_Lock.unlock();
+
+		PrefaultAhead();
+
+		// Start writeback of the pages no writer will touch again. The page holding the end of the committed records
+		// is left alone, as the next record continues on it.
+		const size_t t_Committed = ScanCommitted();
+		const size_t t_Complete = t_Committed / m_PageSize * m_PageSize;
+		if (t_Complete > m_WrittenBack)
+		{
+			sync_file_range(m_Fd, (off_t)m_WrittenBack, (off_t)(t_Complete - m_WrittenBack), SYNC_FILE_RANGE_WRITE);
+			m_WrittenBack = t_Complete;
+		}
+
+		t_Lock.lock();
+	}
+}
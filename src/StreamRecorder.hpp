@@ -0,0 +1,91 @@
+/// @file StreamRecorder.hpp
+/// @brief Records the raw SDK streams from inside the stream callbacks to a memory mapped, preallocated log file.
+/// See StreamLog.hpp for the file layout.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "StreamLog.hpp"
+
+
+/// @brief Append-only writer for stream logs.
+/// Append() is lock-free and safe to call from several SDK callback threads at once: it reserves space with a compare
+/// and swap, copies the payload straight into the mapping and commits the record by writing its size last. It never
+/// makes a system call or touches a page for the first time, so recording costs the callbacks little more than a
+/// memcpy.
+/// A flush thread does everything else: it dirties the pages ahead of the writers so they never page fault, and starts
+/// writeback of the committed pages behind them. Records that do not fit in the preallocated file are dropped and
+/// counted.
+class StreamRecorder
+{
+public:
+	/// @brief A piece of a record payload.
+	struct Segment
+	{
+		const void* data;
+		size_t size;
+	};
+
+	StreamRecorder() = default;
+	~StreamRecorder();
+
+	StreamRecorder(const StreamRecorder&) = delete;
+	StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+	/// @brief Creates the log file, preallocates p_CapacityBytes for it and starts the flush thread.
+	/// @return false with a description in p_Error if the file could not be created or mapped.
+	bool Open(const std::string& p_Path, size_t p_CapacityBytes, std::string& p_Error);
+
+	/// @brief Stops the flush thread and truncates the file to the committed records.
+	/// The stream callbacks must no longer call Append() when this is called.
+	/// @return false with a description in p_Error if the file could not be truncated. The records are kept, followed
+	/// by the zeroed preallocated tail, which readers take as the end of the log.
+	bool Close(std::string& p_Error);
+
+	bool IsOpen() const { return m_Open.load(std::memory_order_relaxed); }
+
+	/// @brief Appends one record made of the given payload segments.
+	/// @return false if the record was dropped because the log is closed or full.
+	bool Append(StreamRecordType p_Type, int64_t p_ReceiveSteadyNs, int64_t p_ReceiveTimeNs, const Segment* p_Segments, size_t p_SegmentCount);
+
+	uint64_t RecordedBytes() const { return m_Reserved.load(std::memory_order_relaxed); }
+	uint64_t DroppedRecords() const { return m_Dropped.load(std::memory_order_relaxed); }
+	const std::string& Path() const { return m_Path; }
+
+private:
+	void FlushLoop();
+	size_t ScanCommitted();
+	void PrefaultAhead();
+
+	// Small enough that the writers reach prefaulted pages well before the kernel writes them back and write protects
+	// them again (30 s by default), at the few hundred kB/s the streams produce.
+	static constexpr size_t c_PrefaultWindowBytes = 4 * 1024 * 1024;
+
+	std::string m_Path;
+	int m_Fd = -1;
+	uint8_t* m_Base = nullptr;
+	size_t m_Capacity = 0;
+	size_t m_PageSize = 4096;
+
+	std::atomic<bool> m_Open{ false };
+	// Writers reserve [m_Reserved, m_Reserved + size) and never go past m_Limit, the end of the prefaulted pages.
+	alignas(64) std::atomic<uint64_t> m_Reserved{ 0 };
+	alignas(64) std::atomic<uint64_t> m_Limit{ 0 };
+	std::atomic<uint64_t> m_Dropped{ 0 };
+
+	// Owned by the flush thread.
+	size_t m_Committed = 0;
+	size_t m_WrittenBack = 0;
+
+	std::thread m_FlushThread;
+	std::mutex m_FlushMutex;
+	std::condition_variable m_FlushCondition;
+	bool m_StopFlush = false;
+};
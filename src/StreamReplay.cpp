@@ -0,0 +1,252 @@
+#include "StreamReplay.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "FrameSignal.hpp"
+
+
+StreamReplay::StreamReplay()
+	: m_Ergonomics(new ErgonomicsStream()), m_Landscape(new Landscape())
+{
+}
+
+StreamReplay::~StreamReplay()
+{
+	Close();
+}
+
+bool StreamReplay::Open(const std::string& p_Path, std::string& p_Error)
+{
+	Close();
+
+	m_Fd = open(p_Path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_Fd < 0)
+	{
+		p_Error = "cannot open " + p_Path + ": " + strerror(errno);
+		return false;
+	}
+
+	struct stat t_Stat;
+	if (fstat(m_Fd, &t_Stat) != 0 || (size_t)t_Stat.st_size < sizeof(StreamLogHeader))
+	{
+		p_Error = p_Path + " is not a stream log";
+		Close();
+		return false;
+	}
+	m_Size = (size_t)t_Stat.st_size;
+
+	void* t_Mapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_Fd, 0);
+	if (t_Mapping == MAP_FAILED)
+	{
+		p_Error = "cannot map " + p_Path + ": " + strerror(errno);
+		m_Size = 0;
+		Close();
+		return false;
+	}
+	m_Base = static_cast<const uint8_t*>(t_Mapping);
+	madvise(const_cast<uint8_t*>(m_Base), m_Size, MADV_SEQUENTIAL);
+
+	StreamLogHeader t_Header;
+	memcpy(&t_Header, m_Base, sizeof(t_Header));
+	if (!t_Header.IsCompatible())
+	{
+		p_Error = p_Path + " was not recorded by this version of manus_ros2 and the Manus SDK";
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void StreamReplay::Close()
+{
+	if (m_Base != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(m_Base), m_Size);
+		m_Base = nullptr;
+	}
+	m_Size = 0;
+	if (m_Fd >= 0)
+	{
+		close(m_Fd);
+		m_Fd = -1;
+	}
+}
+
+StreamReplay::Summary StreamReplay::Run(SDKMinimalClient& p_Client, double p_Speed, const std::function<bool()>& p_KeepRunning)
+{
+	Summary t_Summary;
+	if (m_Base == nullptr) return t_Summary;
+
+	SDKMinimalClient::SetStreamDataSource(this);
+
+	const bool t_Paced = p_Speed > 0.0;
+	const int64_t t_StartNs = FrameSignal::SteadyNowNs();
+	int64_t t_FirstRecordNs = 0;
+	int64_t t_LastRecordNs = 0;
+
+	size_t t_Offset = sizeof(StreamLogHeader);
+	while (t_Offset + sizeof(StreamRecordHeader) <= m_Size && p_KeepRunning())
+	{
+		StreamRecordHeader t_Header;
+		memcpy(&t_Header, m_Base + t_Offset, sizeof(t_Header));
+		// A zero size marks the end of the committed records, e.g. a log cut short by a crash.
+		if (t_Header.size < sizeof(StreamRecordHeader) || t_Offset + t_Header.size > m_Size) break;
+
+		const uint8_t* t_Payload = m_Base + t_Offset + sizeof(StreamRecordHeader);
+		const size_t t_PayloadSize = t_Header.size - sizeof(StreamRecordHeader);
+		t_Offset += t_Header.size;
+
+		if (t_FirstRecordNs == 0) t_FirstRecordNs = t_Header.receiveSteadyNs;
+		t_LastRecordNs = std::max(t_LastRecordNs, t_Header.receiveSteadyNs);
+
+		if (t_Paced)
+		{
+			// Wait in slices so a long gap in the recording does not hold up shutdown.
+			const int64_t t_DueNs = t_StartNs + (int64_t)((double)(t_Header.receiveSteadyNs - t_FirstRecordNs) / p_Speed);
+			int64_t t_NowNs = FrameSignal::SteadyNowNs();
+			while (t_NowNs < t_DueNs && p_KeepRunning())
+			{
+				std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<int64_t>(t_DueNs - t_NowNs, 100000000)));
+				t_NowNs = FrameSignal::SteadyNowNs();
+			}
+			t_Summary.maxLateUs = std::max(t_Summary.maxLateUs, (double)(t_NowNs - t_DueNs) / 1000.0);
+		}
+
+		bool t_Valid = true;
+		switch ((StreamRecordType)t_Header.type)
+		{
+		case StreamRecordType::Skeleton:
+			t_Valid = DeliverSkeletons(t_Payload, t_PayloadSize);
+			t_Summary.skeletonFrames += t_Valid ? 1 : 0;
+			break;
+		case StreamRecordType::Ergonomics:
+			t_Valid = DeliverErgonomics(t_Payload, t_PayloadSize);
+			t_Summary.ergonomicsFrames += t_Valid ? 1 : 0;
+			break;
+		case StreamRecordType::Tracker:
+			t_Valid = DeliverTrackers(t_Payload, t_PayloadSize);
+			t_Summary.trackerFrames += t_Valid ? 1 : 0;
+			break;
+		case StreamRecordType::Landscape:
+			t_Valid = DeliverLandscape(t_Payload, t_PayloadSize);
+			t_Summary.landscapes += t_Valid ? 1 : 0;
+			break;
+		case StreamRecordType::HandSkeletons:
+			if (t_PayloadSize >= sizeof(HandSkeletonsRecordInfo))
+			{
+				HandSkeletonsRecordInfo t_HandSkeletons;
+				memcpy(&t_HandSkeletons, t_Payload, sizeof(t_HandSkeletons));
+				p_Client.AddUserHandSkeletons(t_HandSkeletons.userId, t_HandSkeletons.rightHandId, t_HandSkeletons.leftHandId);
+			}
+			break;
+		default:
+			t_Valid = false;
+			break;
+		}
+		t_Summary.invalidRecords += t_Valid ? 0 : 1;
+	}
+
+	SDKMinimalClient::SetStreamDataSource(nullptr);
+
+	t_Summary.recordedSeconds = (double)(t_LastRecordNs - t_FirstRecordNs) * 1e-9;
+	t_Summary.wallSeconds = (double)(FrameSignal::SteadyNowNs() - t_StartNs) * 1e-9;
+	return t_Summary;
+}
+
+bool StreamReplay::DeliverSkeletons(const uint8_t* p_Payload, size_t p_Size)
+{
+	if (p_Size < sizeof(SkeletonStreamInfo)) return false;
+	SkeletonStreamInfo t_StreamInfo;
+	memcpy(&t_StreamInfo, p_Payload, sizeof(t_StreamInfo));
+	if (t_StreamInfo.skeletonsCount > MAX_NUMBER_OF_SKELETONS) return false;
+
+	size_t t_Offset = sizeof(SkeletonStreamInfo);
+	for (uint32_t i = 0; i < t_StreamInfo.skeletonsCount; i++)
+	{
+		if (t_Offset + sizeof(SkeletonInfo) > p_Size) return false;
+		SkeletonInfo t_Info;
+		memcpy(&t_Info, p_Payload + t_Offset, sizeof(t_Info));
+		m_SkeletonInfos[i] = p_Payload + t_Offset;
+		t_Offset += sizeof(SkeletonInfo);
+
+		const size_t t_NodesSize = (size_t)t_Info.nodesCount * sizeof(SkeletonNode);
+		if (t_Offset + t_NodesSize > p_Size) return false;
+		m_SkeletonNodes[i] = p_Payload + t_Offset;
+		t_Offset += t_NodesSize;
+	}
+	m_SkeletonCount = t_StreamInfo.skeletonsCount;
+
+	SDKMinimalClient::OnSkeletonStreamCallback(&t_StreamInfo);
+	return true;
+}
+
+bool StreamReplay::DeliverErgonomics(const uint8_t* p_Payload, size_t p_Size)
+{
+	if (p_Size < sizeof(ErgonomicsRecordInfo)) return false;
+	ErgonomicsRecordInfo t_RecordInfo;
+	memcpy(&t_RecordInfo, p_Payload, sizeof(t_RecordInfo));
+	if (t_RecordInfo.dataCount > MAX_NUMBER_OF_ERGONOMICS_DATA) return false;
+	if (sizeof(ErgonomicsRecordInfo) + (size_t)t_RecordInfo.dataCount * sizeof(ErgonomicsData) > p_Size) return false;
+
+	m_Ergonomics->publishTime = t_RecordInfo.publishTime;
+	m_Ergonomics->dataCount = t_RecordInfo.dataCount;
+	memcpy(m_Ergonomics->data, p_Payload + sizeof(ErgonomicsRecordInfo), (size_t)t_RecordInfo.dataCount * sizeof(ErgonomicsData));
+
+	SDKMinimalClient::OnErgonomicsStreamCallback(m_Ergonomics.get());
+	return true;
+}
+
+bool StreamReplay::DeliverTrackers(const uint8_t* p_Payload, size_t p_Size)
+{
+	if (p_Size < sizeof(TrackerStreamInfo)) return false;
+	TrackerStreamInfo t_StreamInfo;
+	memcpy(&t_StreamInfo, p_Payload, sizeof(t_StreamInfo));
+	if (sizeof(TrackerStreamInfo) + (size_t)t_StreamInfo.trackerCount * sizeof(TrackerData) > p_Size) return false;
+
+	m_Trackers = p_Payload + sizeof(TrackerStreamInfo);
+	m_TrackerCount = t_StreamInfo.trackerCount;
+
+	SDKMinimalClient::OnTrackerStreamCallback(&t_StreamInfo);
+	return true;
+}
+
+bool StreamReplay::DeliverLandscape(const uint8_t* p_Payload, size_t p_Size)
+{
+	if (p_Size < sizeof(Landscape)) return false;
+	memcpy(m_Landscape.get(), p_Payload, sizeof(Landscape));
+
+	SDKMinimalClient::OnLandscapeCallback(m_Landscape.get());
+	return true;
+}
+
+bool StreamReplay::GetSkeletonInfo(uint32_t p_Index, SkeletonInfo* p_Info)
+{
+	if (p_Index >= m_SkeletonCount) return false;
+	memcpy(p_Info, m_SkeletonInfos[p_Index], sizeof(SkeletonInfo));
+	return true;
+}
+
+bool StreamReplay::GetSkeletonData(uint32_t p_Index, SkeletonNode* p_Nodes, uint32_t p_NodeCount)
+{
+	if (p_Index >= m_SkeletonCount) return false;
+	SkeletonInfo t_Info;
+	memcpy(&t_Info, m_SkeletonInfos[p_Index], sizeof(t_Info));
+	const uint32_t t_NodeCount = std::min(p_NodeCount, t_Info.nodesCount);
+	memcpy(p_Nodes, m_SkeletonNodes[p_Index], (size_t)t_NodeCount * sizeof(SkeletonNode));
+	return true;
+}
+
+bool StreamReplay::GetTrackerData(uint32_t p_Index, TrackerData* p_Data)
+{
+	if (p_Index >= m_TrackerCount) return false;
+	memcpy(p_Data, m_Trackers + (size_t)p_Index * sizeof(TrackerData), sizeof(TrackerData));
+	return true;
+}
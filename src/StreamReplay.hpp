@@ -0,0 +1,78 @@
+/// @file StreamReplay.hpp
+/// @brief Replays a stream log written by StreamRecorder through the static SDKMinimalClient callbacks, so the node
+/// can run without Manus Core and gloves.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "SDKMinimalClient.hpp"
+#include "StreamLog.hpp"
+
+
+/// @brief Drives SDKMinimalClient::On*Callback from a recording, at the recorded pace, sped up, or as fast as possible.
+/// While running it is installed as the client's StreamDataSource, so the skeleton and tracker callbacks fetch the
+/// recorded data instead of asking the SDK.
+class StreamReplay : public StreamDataSource
+{
+public:
+	/// @brief What a replay pass delivered.
+	struct Summary
+	{
+		uint64_t skeletonFrames = 0;
+		uint64_t ergonomicsFrames = 0;
+		uint64_t trackerFrames = 0;
+		uint64_t landscapes = 0;
+		uint64_t invalidRecords = 0;
+		double recordedSeconds = 0.0; // Span of the recording replayed.
+		double wallSeconds = 0.0; // Time the replay took.
+		double maxLateUs = 0.0; // Furthest a callback fell behind its schedule, 0 when replaying as fast as possible.
+	};
+
+	StreamReplay();
+	~StreamReplay() override;
+
+	StreamReplay(const StreamReplay&) = delete;
+	StreamReplay& operator=(const StreamReplay&) = delete;
+
+	/// @brief Maps the log and checks it was recorded with a compatible SDK.
+	/// @return false with a description in p_Error otherwise.
+	bool Open(const std::string& p_Path, std::string& p_Error);
+	void Close();
+
+	/// @brief Replays the whole log once on the calling thread.
+	/// @param p_Speed 1 for the recorded timing, N for N times faster, 0 or less for as fast as possible.
+	/// @param p_KeepRunning Polled between records and while waiting for the next one, replay stops when it returns false.
+	Summary Run(SDKMinimalClient& p_Client, double p_Speed, const std::function<bool()>& p_KeepRunning);
+
+	bool GetSkeletonInfo(uint32_t p_Index, SkeletonInfo* p_Info) override;
+	bool GetSkeletonData(uint32_t p_Index, SkeletonNode* p_Nodes, uint32_t p_NodeCount) override;
+	bool GetTrackerData(uint32_t p_Index, TrackerData* p_Data) override;
+
+private:
+	bool DeliverSkeletons(const uint8_t* p_Payload, size_t p_Size);
+	bool DeliverErgonomics(const uint8_t* p_Payload, size_t p_Size);
+	bool DeliverTrackers(const uint8_t* p_Payload, size_t p_Size);
+	bool DeliverLandscape(const uint8_t* p_Payload, size_t p_Size);
+
+	int m_Fd = -1;
+	const uint8_t* m_Base = nullptr;
+	size_t m_Size = 0;
+
+	// Offsets of the current skeleton frame's per-skeleton infos and nodes, for the StreamDataSource getters.
+	// Payload fields are not necessarily aligned, so the getters copy them out.
+	size_t m_SkeletonCount = 0;
+	const uint8_t* m_SkeletonInfos[MAX_NUMBER_OF_SKELETONS] = {};
+	const uint8_t* m_SkeletonNodes[MAX_NUMBER_OF_SKELETONS] = {};
+
+	const uint8_t* m_Trackers = nullptr;
+	size_t m_TrackerCount = 0;
+
+	// Rebuilt for every record, the SDK structs are too large for the stack.
+	std::unique_ptr<ErgonomicsStream> m_Ergonomics;
+	std::unique_ptr<Landscape> m_Landscape;
+};
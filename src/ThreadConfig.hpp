@@ -0,0 +1,130 @@
+/// @file ThreadConfig.hpp
+/// @brief Scheduling of the node's threads by role: the CPUs each role may run on and an optional SCHED_FIFO priority,
+/// so the publish path does not share cores or priority with the SDK's threads and the rest of the machine.
+
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+/// @brief The threads the node schedules separately.
+enum class ThreadRole : int
+{
+	Publish = 0, // swaps in the SDK frames, converts and publishes them
+	Resample,    // publishes the resampled poses on a fixed schedule
+	Sdk,         // the SDK's callback threads, taken over the first time they enter a stream callback
+	Haptics,     // sends the haptics commands to the gloves
+	Executor,    // spins the ROS executor for timers and parameter changes
+
+	Count
+};
+
+inline const char* ThreadRoleName(ThreadRole p_Role)
+{
+	switch (p_Role)
+	{
+	case ThreadRole::Publish: return "publish";
+	case ThreadRole::Resample: return "resample";
+	case ThreadRole::Sdk: return "sdk";
+	case ThreadRole::Haptics: return "haptics";
+	case ThreadRole::Executor: return "executor";
+	default: return "unknown";
+	}
+}
+
+struct ThreadRoleConfig
+{
+	// CPUs the threads of the role may run on, all of them when empty.
+	std::vector<int> cpus;
+	// SCHED_FIFO priority from 1 to 99, 0 keeps the default time sharing scheduler.
+	int fifoPriority = 0;
+
+	bool IsDefault() const { return cpus.empty() && fifoPriority == 0; }
+};
+
+/// @brief Parses a CPU list like the kernel prints them, such as "2,3" or "0-1,4". An empty list is valid, an
+/// invalid one leaves p_Cpus empty.
+inline bool ParseCpuList(const std::string& p_List, std::vector<int>& p_Cpus, std::string& p_Error)
+{
+	p_Cpus.clear();
+	size_t t_Start = 0;
+	while (t_Start < p_List.size())
+	{
+		size_t t_End = p_List.find(',', t_Start);
+		if (t_End == std::string::npos) t_End = p_List.size();
+		const std::string t_Range = p_List.substr(t_Start, t_End - t_Start);
+		t_Start = t_End + 1;
+		if (t_Range.empty()) continue;
+
+		char* t_Rest = nullptr;
+		const long t_First = std::strtol(t_Range.c_str(), &t_Rest, 10);
+		long t_Last = t_First;
+		if (*t_Rest == '-')
+		{
+			t_Last = std::strtol(t_Rest + 1, &t_Rest, 10);
+		}
+		if (t_Rest == t_Range.c_str() || *t_Rest != '\0' || t_First < 0 || t_Last < t_First || t_Last >= CPU_SETSIZE)
+		{
+			p_Error = "invalid CPU range '" + t_Range + "'";
+			p_Cpus.clear();
+			return false;
+		}
+		for (long t_Cpu = t_First; t_Cpu <= t_Last; t_Cpu++) p_Cpus.push_back((int)t_Cpu);
+	}
+	return true;
+}
+
+/// @brief Formats a CPU list for logging, "all" when empty.
+inline std::string FormatCpuList(const std::vector<int>& p_Cpus)
+{
+	if (p_Cpus.empty()) return "all";
+	std::string t_List;
+	for (size_t i = 0; i < p_Cpus.size(); i++)
+	{
+		if (i > 0) t_List += ",";
+		t_List += std::to_string(p_Cpus[i]);
+	}
+	return t_List;
+}
+
+/// @brief Applies a role to the calling thread.
+/// SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit (see /etc/security/limits.conf); without, the affinity is still
+/// applied and the error says so.
+inline bool ApplyThreadRole(const ThreadRoleConfig& p_Config, std::string& p_Error)
+{
+	bool t_Success = true;
+	if (!p_Config.cpus.empty())
+	{
+		cpu_set_t t_Set;
+		CPU_ZERO(&t_Set);
+		for (int t_Cpu : p_Config.cpus) CPU_SET(t_Cpu, &t_Set);
+		const int t_Result = pthread_setaffinity_np(pthread_self(), sizeof(t_Set), &t_Set);
+		if (t_Result != 0)
+		{
+			p_Error = std::string("setting the CPU affinity failed: ") + std::strerror(t_Result);
+			t_Success = false;
+		}
+	}
+	if (p_Config.fifoPriority > 0)
+	{
+		sched_param t_Param;
+		std::memset(&t_Param, 0, sizeof(t_Param));
+		t_Param.sched_priority = p_Config.fifoPriority;
+		const int t_Result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &t_Param);
+		if (t_Result != 0)
+		{
+			p_Error += std::string(t_Success ? "" : ", ") + "setting SCHED_FIFO priority " + std::to_string(p_Config.fifoPriority) +
+				" failed: " + std::strerror(t_Result) + (t_Result == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "");
+			t_Success = false;
+		}
+	}
+	return t_Success;
+}
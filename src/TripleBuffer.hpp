@@ -0,0 +1,64 @@
+/// @file TripleBuffer.hpp
+/// @brief Wait-free single producer / single consumer triple buffer used to hand frames from the SDK callback threads
+/// to the publishing thread without locking.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+/// @brief Three slots of T shared between one writer and one reader.
+/// The writer fills WriteBuffer() in place and calls Publish(), which swaps its slot with the shared middle slot.
+/// The reader calls Update(), which swaps the middle slot into ReadBuffer() if a newer frame was published.
+/// Neither side ever waits for the other: the writer always has a free slot, and the reader always sees the newest
+/// complete frame. Frames published while the reader is busy are overwritten, which is what we want for pose data.
+/// @note Slots are reused, so the writer must overwrite every field it relies on (slots hold frames from two
+/// publishes ago).
+template <typename T>
+class TripleBuffer
+{
+public:
+	/// @brief Slot owned by the writer. Only valid until the next Publish().
+	T& WriteBuffer() { return m_Slots[m_WriteIndex].value; }
+
+	/// @brief Makes the current write slot the newest frame. Called by the writer only.
+	void Publish()
+	{
+		const uint8_t t_Previous = m_Middle.exchange(m_WriteIndex | c_NewFrameFlag, std::memory_order_acq_rel);
+		m_WriteIndex = t_Previous & c_IndexMask;
+	}
+
+	/// @brief Takes the newest published frame, if there is one. Called by the reader only.
+	/// @return true if ReadBuffer() now holds a frame the reader has not seen before.
+	bool Update()
+	{
+		if ((m_Middle.load(std::memory_order_relaxed) & c_NewFrameFlag) == 0)
+		{
+			return false;
+		}
+		const uint8_t t_Previous = m_Middle.exchange(m_ReadIndex, std::memory_order_acq_rel);
+		m_ReadIndex = t_Previous & c_IndexMask;
+		return true;
+	}
+
+	/// @brief Slot owned by the reader. Stays valid until the next Update().
+	T& ReadBuffer() { return m_Slots[m_ReadIndex].value; }
+	const T& ReadBuffer() const { return m_Slots[m_ReadIndex].value; }
+
+private:
+	static constexpr uint8_t c_IndexMask = 0x3;
+	static constexpr uint8_t c_NewFrameFlag = 0x4;
+
+	// Keep slots and indices on separate cache lines so the two threads do not false share.
+	struct alignas(64) Slot
+	{
+		T value;
+	};
+
+	std::array<Slot, 3> m_Slots;
+	alignas(64) uint8_t m_WriteIndex = 0;
+	alignas(64) std::atomic<uint8_t> m_Middle{ 1 };
+	alignas(64) uint8_t m_ReadIndex = 2;
+};
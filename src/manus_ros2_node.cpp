@@ -0,0 +1,382 @@
+#include "manus_ros2_node.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+
+ManusROS2Node::ManusROS2Node(const rclcpp::NodeOptions& options)
+	: ManusROS2Publisher(options)
+{
+	event_driven_ = this->declare_parameter<bool>("event_driven", true);
+	timer_period_ms_ = this->declare_parameter<int64_t>("timer_period_ms", 20);
+	const int64_t report_period_s = this->declare_parameter<int64_t>("latency_report_period_s", 10);
+	// Record the raw SDK streams to this file when set, see StreamRecorder.
+	const std::string record_path = this->declare_parameter<std::string>("record_path", "");
+	const int64_t record_size_mb = this->declare_parameter<int64_t>("record_size_mb", 256);
+	// Replay a recording through the SDK callbacks instead of connecting to Manus Core, see StreamReplay.
+	const std::string replay_path = this->declare_parameter<std::string>("replay_path", "");
+	// 1 replays at the recorded pace, N at N times the pace, 0 as fast as possible.
+	replay_speed_ = this->declare_parameter<double>("replay_speed", 1.0);
+	replay_loop_ = this->declare_parameter<bool>("replay_loop", false);
+	// Shut ROS down once the replay has finished. Turn off in a container shared with other nodes.
+	replay_shutdown_ = this->declare_parameter<bool>("replay_shutdown", true);
+	// Connect to this Manus Core host or IP address directly, looking for hosts only when that fails. The host of the
+	// last successful connect is cached in core_host_cache_path and, without core_host, tried first. Empty disables the
+	// cache.
+	const std::string core_host = this->declare_parameter<std::string>("core_host", "");
+	const char* ros_home = std::getenv("ROS_HOME");
+	const char* home = std::getenv("HOME");
+	const std::string default_cache_path = ros_home != nullptr ? std::string(ros_home) + "/manus_ros2_core_host" :
+		home != nullptr ? std::string(home) + "/.ros/manus_ros2_core_host" : "";
+	const std::string core_host_cache_path = this->declare_parameter<std::string>("core_host_cache_path", default_cache_path);
+	// The compressed hand skeleton setups are kept in this directory and restored on later connects, empty keeps them
+	// in memory only, for the reconnects of this run.
+	const std::string default_skeleton_cache_dir = ros_home != nullptr ? std::string(ros_home) + "/manus_ros2_skeletons" :
+		home != nullptr ? std::string(home) + "/.ros/manus_ros2_skeletons" : "";
+	const std::string skeleton_cache_dir = this->declare_parameter<std::string>("skeleton_cache_dir", default_skeleton_cache_dir);
+	haptics_max_rate_hz_ = std::max(this->declare_parameter<double>("haptics_max_rate_hz", 50.0), 0.0);
+
+	// CPUs and SCHED_FIFO priority of each thread role, <role>_thread_cpus and <role>_thread_priority. See ThreadConfig.hpp.
+	for (int role = 0; role < (int)ThreadRole::Count; role++) {
+		const std::string name = ThreadRoleName((ThreadRole)role);
+		ThreadRoleConfig& config = thread_roles_[role];
+		std::string error;
+		if (!ParseCpuList(this->declare_parameter<std::string>(name + "_thread_cpus", ""), config.cpus, error)) {
+			RCLCPP_WARN(this->get_logger(), "Ignoring %s_thread_cpus: %s", name.c_str(), error.c_str());
+		}
+		config.fifoPriority = (int)std::min<int64_t>(std::max<int64_t>(this->declare_parameter<int64_t>(name + "_thread_priority", 0), 0), 99);
+	}
+
+	RCLCPP_INFO(this->get_logger(), "Starting manus_ros2 node%s", intra_process() ?
+		" with intra-process communication: every topic but TF is handed to subscribers in this process without copying" : "");
+	client_.reset(new SDKMinimalClient(*this));
+	client_->SetMultiUser(multi_user());
+	client_->SetGestureTopK(gesture_top_k());
+	client_->SetRawSkeletons(raw_skeletons());
+	client_->SetCallbackThreadRole(thread_roles_[(size_t)ThreadRole::Sdk]);
+	replaying_ = !replay_path.empty();
+	set_sdk_timestamps(!replaying_);
+
+	if (replaying_) {
+		std::string error;
+		if (!replay_.Open(replay_path, error)) {
+			throw std::runtime_error("Failed to open the replay: " + error);
+		}
+	} else {
+		ClientReturnCode status = client_->Initialize();
+
+		if (status != ClientReturnCode::ClientReturnCode_Success)
+		{
+			throw std::runtime_error("Failed to initialize the Manus SDK. Error code: " + std::to_string((int)status));
+		}
+	}
+
+	if (!record_path.empty() && !client_->StartRecording(record_path, (size_t)record_size_mb * 1024 * 1024)) {
+		if (!replaying_) {
+			client_->ShutDown();
+		}
+		throw std::runtime_error("Failed to start recording to " + record_path);
+	}
+
+	if (!replaying_) {
+		// Latched, so late subscribers see whether Core is connected right away.
+		manus_connection_publisher_ = this->create_publisher<manus_ros2::msg::ConnectionStatus>("manus_connection", rclcpp::QoS(1).transient_local());
+		client_->SetHost(core_host);
+		client_->SetHostCachePath(core_host_cache_path);
+		client_->SetSkeletonCacheDir(skeleton_cache_dir);
+		client_->SetConnectionListener([this](const ConnectionStatus& status) { publish_connection_status(status); });
+		RCLCPP_INFO(this->get_logger(), "Connecting to Manus SDK");
+		client_->StartConnecting();
+
+		// Vibrate the gloves from the manus_<side>_haptics topics, sent from a thread of their own.
+		if (haptics_max_rate_hz_ > 0.0) {
+			haptics_.reset(new HapticsCommander(SDKMinimalClient::c_MaxUsers));
+			if (!multi_user()) {
+				add_haptics_user(0, 0);
+			}
+		}
+	}
+
+	// Periodically report how long frames waited between the SDK callback and being published, and the jitter of the
+	// publishing threads.
+	if (report_period_s > 0) {
+		report_timer_ = this->create_wall_timer(std::chrono::seconds(report_period_s), [this]() { report_latency(); });
+	}
+
+	// Load skeletons for users as they come and go, and give each its own topics. Kept off the publishing thread as
+	// loading skeletons blocks on Core.
+	if (multi_user()) {
+		users_timer_ = this->create_wall_timer(std::chrono::seconds(1), [this]() { update_users(); });
+	}
+
+	// The gesture names, published whenever the landscape lists other gestures.
+	if (gesture_top_k() > 0 && !replaying_) {
+		gesture_names_timer_ = this->create_wall_timer(std::chrono::seconds(1), [this]() { update_gesture_names(); });
+	}
+
+	// The raw skeleton layouts of gloves as they start streaming.
+	if (raw_skeletons() && !replaying_) {
+		raw_layout_timer_ = this->create_wall_timer(std::chrono::seconds(1), [this]() { update_raw_skeleton_layouts(); });
+	}
+
+	// The threads come last: the constructor must not throw once they run, as the destructor would not join them.
+	start_publish_thread();
+
+	if (haptics_) {
+		haptics_->Start(
+			[this](uint32_t slot, bool is_right_hand, const float* powers) { return client_->VibrateFingers(slot, is_right_hand, powers); },
+			haptics_max_rate_hz_, [this]() { apply_thread_role(ThreadRole::Haptics); });
+	}
+
+	// Publish the resampled poses on a schedule of their own, decoupled from when frames arrive.
+	if (resample_rate_hz() > 0.0) {
+		resample_thread_ = std::thread([this]() {
+			apply_thread_role(ThreadRole::Resample);
+			run_resampler([this]() { return running_.load() && rclcpp::ok(); });
+		});
+	}
+
+	if (replaying_) {
+		RCLCPP_INFO(this->get_logger(), "Replaying %s at %s", replay_path.c_str(),
+			replay_speed_ > 0.0 ? (std::to_string(replay_speed_) + "x speed").c_str() : "full speed");
+		start_replay_thread();
+	}
+}
+
+ManusROS2Node::~ManusROS2Node()
+{
+	running_.store(false);
+	if (report_timer_) {
+		report_timer_->cancel();
+	}
+	if (users_timer_) {
+		users_timer_->cancel();
+	}
+	if (gesture_names_timer_) {
+		gesture_names_timer_->cancel();
+	}
+	if (raw_layout_timer_) {
+		raw_layout_timer_->cancel();
+	}
+
+	if (replay_thread_.joinable()) {
+		replay_thread_.join();
+	}
+
+	// Stop the publishing thread before tearing down the client it reads from
+	if (publish_thread_.joinable()) {
+		client_->GetFrameSignal().Interrupt();
+		publish_thread_.join();
+	}
+	// Wakes within a period.
+	if (resample_thread_.joinable()) {
+		resample_thread_.join();
+	}
+
+	// Turns off the motors it left running, so still needs the client.
+	if (haptics_) {
+		haptics_->Stop();
+	}
+
+	// Shutdown the Manus client
+	if (replaying_) {
+		client_->StopRecording();
+	} else {
+		client_->ShutDown();
+	}
+}
+
+void ManusROS2Node::apply_thread_role(ThreadRole role)
+{
+	const ThreadRoleConfig& config = thread_roles_[(size_t)role];
+	if (config.IsDefault()) {
+		return;
+	}
+	std::string error;
+	if (ApplyThreadRole(config, error)) {
+		RCLCPP_INFO(this->get_logger(), "%s thread on CPUs %s, SCHED_FIFO priority %d", ThreadRoleName(role),
+			FormatCpuList(config.cpus).c_str(), config.fifoPriority);
+	} else {
+		RCLCPP_WARN(this->get_logger(), "%s thread: %s", ThreadRoleName(role), error.c_str());
+	}
+}
+
+void ManusROS2Node::start_publish_thread()
+{
+	// The publish path runs on its own thread in both modes, so it can be scheduled apart from the executor.
+	if (event_driven_) {
+		// Wake up as soon as a stream callback hands off a frame, falling back to polling if nothing arrives.
+		RCLCPP_INFO(this->get_logger(), "Publishing event driven from the SDK stream callbacks");
+		publish_thread_ = std::thread([this]() {
+			apply_thread_role(ThreadRole::Publish);
+			const auto wait_timeout = timer_period_ms_ > 0 ? std::chrono::milliseconds(timer_period_ms_) : std::chrono::milliseconds(100);
+			while (running_.load() && rclcpp::ok()) {
+				const bool signalled = client_->GetFrameSignal().WaitFor(wait_timeout);
+				if (signalled || timer_period_ms_ > 0) {
+					publishPendingFrames(*client_, *this, handoff_stats_);
+				}
+			}
+		});
+	} else {
+		// Publish the poses at a fixed rate (50hz by default)
+		RCLCPP_INFO_STREAM(this->get_logger(), "Publishing every " << timer_period_ms_ << " ms");
+		publish_thread_ = std::thread([this]() {
+			apply_thread_role(ThreadRole::Publish);
+			PeriodicSchedule schedule;
+			schedule.Start(std::max<int64_t>(timer_period_ms_, 1) * 1000000);
+			while (running_.load() && rclcpp::ok()) {
+				int64_t late_ns = 0;
+				schedule.WaitNext(late_ns);
+				poll_late_.Record(late_ns);
+				publishPendingFrames(*client_, *this, handoff_stats_);
+			}
+		});
+	}
+}
+
+void ManusROS2Node::start_replay_thread()
+{
+	// Feed the recording through the SDK callbacks, then stop unless looping.
+	replay_thread_ = std::thread([this]() {
+		do {
+			const StreamReplay::Summary summary = replay_.Run(*client_, replay_speed_, [this]() { return running_.load() && rclcpp::ok(); });
+			const uint64_t frames = summary.skeletonFrames + summary.ergonomicsFrames + summary.trackerFrames;
+			RCLCPP_INFO(this->get_logger(),
+				"Replayed %lu skeleton, %lu ergonomics and %lu tracker frames (%.1f s recorded) in %.3f s: %.0f frames/s, max %.1f us behind schedule",
+				(unsigned long)summary.skeletonFrames, (unsigned long)summary.ergonomicsFrames, (unsigned long)summary.trackerFrames,
+				summary.recordedSeconds, summary.wallSeconds, summary.wallSeconds > 0.0 ? (double)frames / summary.wallSeconds : 0.0,
+				summary.maxLateUs);
+			if (summary.invalidRecords > 0) {
+				RCLCPP_WARN(this->get_logger(), "Skipped %lu invalid records", (unsigned long)summary.invalidRecords);
+			}
+		} while (replay_loop_ && running_.load() && rclcpp::ok());
+		if (replay_shutdown_ && running_.load()) {
+			rclcpp::shutdown();
+		}
+	});
+}
+
+void ManusROS2Node::report_latency()
+{
+	if (resample_rate_hz() > 0.0) {
+		const ResampleStats::Summary resample = resample_stats().TakeWindow();
+		RCLCPP_INFO(this->get_logger(),
+			"Resample thread over %lu ticks: woke late by p50 %.1f us, p99 %.1f us, max %.1f us; %lu ticks skipped, %lu held older poses",
+			(unsigned long)resample.late.count, resample.late.p50Us, resample.late.p99Us, resample.late.maxUs,
+			(unsigned long)resample.skipped, (unsigned long)resample.held);
+	}
+	if (!event_driven_) {
+		const LatencyHistogram::Summary late = poll_late_.TakeWindow();
+		if (late.count > 0) {
+			RCLCPP_INFO(this->get_logger(),
+				"Publish thread over %lu ticks: woke late by p50 %.1f us, p99 %.1f us, max %.1f us",
+				(unsigned long)late.count, late.p50Us, late.p99Us, late.maxUs);
+		}
+	}
+	if (haptics_) {
+		const HapticsCommander::Summary haptics = haptics_->TakeWindow();
+		if (haptics.commands > 0) {
+			RCLCPP_INFO(this->get_logger(),
+				"Haptics over %lu commands: %lu coalesced, %lu failed; command to SDK p50 %.1f us, p99 %.1f us, max %.1f us; SDK call p50 %.1f us, p99 %.1f us, max %.1f us",
+				(unsigned long)haptics.commands, (unsigned long)haptics.coalesced, (unsigned long)haptics.failed,
+				haptics.commandToSdk.p50Us, haptics.commandToSdk.p99Us, haptics.commandToSdk.maxUs,
+				haptics.sdkCall.p50Us, haptics.sdkCall.p99Us, haptics.sdkCall.maxUs);
+		}
+	}
+	if (raw_skeletons()) {
+		// Mixes the phase between the streams with their delivery, it does not measure the time retargeting takes.
+		const LatencyHistogram::Summary gap = client_->GetRawSkeletonArrivalGap().TakeWindow();
+		if (gap.count > 0) {
+			RCLCPP_INFO(this->get_logger(),
+				"Raw to next retargeted skeleton arrival gap over %lu frames: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us",
+				(unsigned long)gap.count, gap.meanUs, gap.p50Us, gap.p99Us, gap.maxUs);
+		}
+	}
+	const LatencyHistogram::Summary wait = handoff_stats_.TakeWindow();
+	if (wait.count == 0) {
+		return;
+	}
+	if (event_driven_ && timer_period_ms_ > 0) {
+		// A frame arriving at a random point of a polling period waits half a period on average.
+		const double polled_mean_us = (double)timer_period_ms_ * 1000.0 / 2.0;
+		RCLCPP_INFO(this->get_logger(),
+			"Frame handoff wait over %lu frames: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us (saves ~%.1f us per frame vs %ld ms polling)",
+			(unsigned long)wait.count, wait.meanUs, wait.p50Us, wait.p99Us, wait.maxUs, polled_mean_us - wait.meanUs,
+			(long)timer_period_ms_);
+	} else if (event_driven_) {
+		RCLCPP_INFO(this->get_logger(),
+			"Frame handoff wait over %lu frames: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us",
+			(unsigned long)wait.count, wait.meanUs, wait.p50Us, wait.p99Us, wait.maxUs);
+	} else {
+		RCLCPP_INFO(this->get_logger(),
+			"Frame handoff wait over %lu frames: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us (%ld ms period)",
+			(unsigned long)wait.count, wait.meanUs, wait.p50Us, wait.p99Us, wait.maxUs, (long)timer_period_ms_);
+	}
+}
+
+void ManusROS2Node::update_users()
+{
+	if (!replaying_) {
+		client_->UpdateUserSkeletons();
+	}
+	for (uint32_t slot = 0; slot < client_->GetUserCount(); slot++) {
+		add_user(slot, client_->GetUserID(slot));
+		add_haptics_user(slot, client_->GetUserID(slot));
+	}
+}
+
+void ManusROS2Node::update_gesture_names()
+{
+	std::vector<GestureLandscapeData> gestures;
+	if (client_->TakeGestureLandscapeChange(gestures)) {
+		RCLCPP_INFO(this->get_logger(), "Publishing the names of %zu gestures", gestures.size());
+		publish_gesture_names(gestures);
+	}
+}
+
+void ManusROS2Node::update_raw_skeleton_layouts()
+{
+	std::vector<RawSkeletonLayout> layouts;
+	client_->TakeRawSkeletonLayouts(layouts);
+	for (const RawSkeletonLayout& layout : layouts) {
+		RCLCPP_INFO(this->get_logger(), "Publishing the layout of the %zu node raw skeleton of glove %u", layout.nodes.size(), layout.gloveID);
+		publish_raw_skeleton_layout(layout);
+	}
+}
+
+void ManusROS2Node::add_haptics_user(uint32_t slot, uint32_t user_id)
+{
+	if (!haptics_ || slot >= haptics_users_.size() || haptics_users_[slot]) {
+		return;
+	}
+	haptics_users_[slot] = true;
+	const std::string prefix = multi_user() ? "user_" + std::to_string(user_id) + "/" : "";
+	for (bool is_right_hand : { false, true }) {
+		// Only the newest command matters, older ones are dropped rather than queued.
+		haptics_subscriptions_.push_back(this->create_subscription<manus_ros2::msg::ManusHaptics>(
+			prefix + (is_right_hand ? "manus_right_haptics" : "manus_left_haptics"), rclcpp::QoS(1),
+			[this, slot, is_right_hand](const manus_ros2::msg::ManusHaptics::ConstSharedPtr message) {
+				haptics_->Command(slot, is_right_hand, message->finger_powers.data());
+			}));
+	}
+}
+
+void ManusROS2Node::publish_connection_status(const ConnectionStatus& status)
+{
+	manus_ros2::msg::ConnectionStatus message;
+	message.stamp = this->now();
+	message.state = (uint8_t)status.state;
+	message.host = status.host;
+	message.disconnect_count = status.disconnectCount;
+	message.recover_time = status.recoverSeconds;
+	message.skeleton_load_time = status.skeletonLoadSeconds;
+	message.skeletons_restored = status.skeletonsRestored;
+	message.skeletons_built = status.skeletonsBuilt;
+	manus_connection_publisher_->publish(message);
+}
+
+RCLCPP_COMPONENTS_REGISTER_NODE(ManusROS2Node)
@@ -0,0 +1,82 @@
+/// @file manus_ros2_node.hpp
+/// @brief The manus_ros2 node as an rclcpp component: the publisher together with the SDK client, the threads that
+/// feed it and the timers that report on them, so it can be loaded into a component container next to the
+/// controllers consuming its topics, or run on its own by the manus_ros2 executable.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "manus_ros2/msg/connection_status.hpp"
+#include "manus_ros2/msg/manus_haptics.hpp"
+#include "HapticsCommander.hpp"
+#include "manus_ros2_publisher.hpp"
+#include "SDKMinimalClient.hpp"
+#include "StreamReplay.hpp"
+#include "ThreadConfig.hpp"
+
+
+/// @brief The complete manus_ros2 node. Starts connecting to Manus Core (or starts a replay) and starts its threads on
+/// construction, and stops them and disconnects on destruction.
+/// The SDK client is a process wide singleton, so a process holds at most one instance.
+class ManusROS2Node : public ManusROS2Publisher
+{
+public:
+	/// @throws std::runtime_error when the SDK, the replay or the recording cannot be set up.
+	explicit ManusROS2Node(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
+	~ManusROS2Node() override;
+
+	/// @brief Applies the scheduling configured for a thread role to the calling thread, logging the outcome. The
+	/// executor role is applied by whoever spins the node, the container's executor is not ours to schedule.
+	void apply_thread_role(ThreadRole role);
+
+private:
+	void start_publish_thread();
+	void start_replay_thread();
+	void report_latency();
+	void update_users();
+	void add_haptics_user(uint32_t slot, uint32_t user_id);
+	void update_gesture_names();
+	void update_raw_skeleton_layouts();
+	void publish_connection_status(const ConnectionStatus& status);
+
+	// Publish from the SDK callbacks as frames arrive, or poll on a fixed period.
+	bool event_driven_ = true;
+	// Poll period in polling mode. In event driven mode this is the fallback poll period, 0 disables the fallback.
+	int64_t timer_period_ms_ = 20;
+	bool replaying_ = false;
+	double replay_speed_ = 1.0;
+	bool replay_loop_ = false;
+	bool replay_shutdown_ = true;
+	std::array<ThreadRoleConfig, (size_t)ThreadRole::Count> thread_roles_;
+	// Highest rate commands are sent to each glove at, 0 disables the haptics topics.
+	double haptics_max_rate_hz_ = 50.0;
+
+	std::unique_ptr<SDKMinimalClient> client_;
+	StreamReplay replay_;
+	FrameHandoffStats handoff_stats_;
+	// How late the polling publish thread wakes past its deadlines.
+	LatencyHistogram poll_late_;
+
+	// Cleared on destruction, so the threads stop even while ROS keeps running other nodes of the process.
+	std::atomic<bool> running_{true};
+	std::thread publish_thread_;
+	std::thread resample_thread_;
+	std::thread replay_thread_;
+	rclcpp::TimerBase::SharedPtr report_timer_;
+	rclcpp::TimerBase::SharedPtr users_timer_;
+	rclcpp::TimerBase::SharedPtr gesture_names_timer_;
+	rclcpp::TimerBase::SharedPtr raw_layout_timer_;
+	rclcpp::Publisher<manus_ros2::msg::ConnectionStatus>::SharedPtr manus_connection_publisher_;
+	// Declared after the commander, so the subscriptions feeding it go first.
+	std::unique_ptr<HapticsCommander> haptics_;
+	std::array<bool, SDKMinimalClient::c_MaxUsers> haptics_users_{};
+	std::vector<rclcpp::Subscription<manus_ros2::msg::ManusHaptics>::SharedPtr> haptics_subscriptions_;
+};
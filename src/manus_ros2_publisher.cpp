@@ -0,0 +1,145 @@
+#include "manus_ros2_publisher.hpp"
+
+
+void convertSkeletonDataToROS(ManusROS2Publisher& publisher)
+{
+	SDKMinimalClient* client = SDKMinimalClient::GetInstance();
+	ClientSkeletonCollection* csc = client->CurrentSkeletons();
+	if (csc != nullptr) {
+		publisher.begin_frame();
+		publisher.observe_core_time(csc->publishTime, csc->receiveTimeNs);
+		publisher.filter_skeletons(*csc, *client);
+	}
+	if (csc != nullptr && csc->skeletons.size() != 0) {
+    	for (size_t i=0; i < csc->skeletons.size(); ++i) {
+			// Which user and hand is this? Skeletons loaded by other clients are not ours to publish, and a user that
+			// just arrived has no topics until the node creates them.
+			const HandSkeletonRoute* route = client->FindHandSkeleton(csc->skeletons[i].info.id);
+			if (route == nullptr) {
+				continue;
+			}
+			UserHandPublishers* hands = publisher.user_publishers(route->userSlot);
+			if (hands == nullptr) {
+				continue;
+			}
+			const bool is_right_hand = route->isRightHand;
+
+			const ManusTimestamp &publish_time = csc->skeletons[i].info.publishTime.time != 0 ? csc->skeletons[i].info.publishTime : csc->publishTime;
+			const builtin_interfaces::msg::Time stamp = publisher.acquisition_stamp(publish_time, csc->receiveTimeNs);
+
+			if (publisher.fixed_size_messages()) {
+				publisher.publish_hand_fixed(*hands, csc->skeletons[i], is_right_hand, stamp);
+			}
+			if (publisher.compact_messages()) {
+				publisher.publish_hand_compact(*hands, csc->skeletons[i], is_right_hand, stamp);
+			}
+			if (publisher.legacy_messages()) {
+				publisher.publish_hand(*hands, csc->skeletons[i], is_right_hand, stamp);
+			}
+			if (publisher.publish_tf()) {
+				publisher.add_hand_tf(*hands, csc->skeletons[i], is_right_hand, stamp);
+			}
+		}
+	}
+	if (csc != nullptr) {
+		if (publisher.publish_tf()) {
+			publisher.send_tf();
+		}
+		publisher.end_frame(LatencyStream::Skeleton, csc->receiveSteadyNs, client->GetLastSwapSteadyNs());
+	}
+}
+
+void convertErgonomicsDataToROS(ManusROS2Publisher& publisher)
+{
+	ClientErgonomics* ce = SDKMinimalClient::GetInstance()->CurrentErgonomics();
+	if (ce != nullptr) {
+		publisher.begin_frame();
+		publisher.observe_core_time(ce->publishTime, ce->receiveTimeNs);
+		publisher.filter_ergonomics(*ce);
+		const builtin_interfaces::msg::Time stamp = publisher.acquisition_stamp(ce->publishTime, ce->receiveTimeNs);
+
+		if (publisher.fixed_size_messages()) {
+			publisher.publish_ergonomics_fixed(*ce, stamp);
+		}
+		if (publisher.compact_messages()) {
+			publisher.publish_ergonomics_compact(*ce, stamp);
+		}
+		if (publisher.legacy_messages()) {
+			publisher.publish_ergonomics(*ce, stamp);
+		}
+		publisher.end_frame(LatencyStream::Ergonomics, ce->receiveSteadyNs, SDKMinimalClient::GetInstance()->GetLastSwapSteadyNs());
+	}
+}
+
+
+void convertTrackerDataToROS(ManusROS2Publisher& publisher)
+{
+	TrackerDataCollection* tdc = SDKMinimalClient::GetInstance()->CurrentTrackerData();
+	if (tdc != nullptr) {
+		publisher.begin_frame();
+		// Tracker poses carry no header, but their publish times still refine the clock estimate.
+		publisher.observe_core_time(tdc->publishTime, tdc->receiveTimeNs);
+	}
+	if (tdc != nullptr && tdc->trackerData.size() != 0){
+		publisher.publish_trackers(*tdc);
+	}
+	if (tdc != nullptr) {
+		publisher.end_frame(LatencyStream::Tracker, tdc->receiveSteadyNs, SDKMinimalClient::GetInstance()->GetLastSwapSteadyNs());
+	}
+}
+
+void convertGestureDataToROS(ManusROS2Publisher& publisher)
+{
+	ClientGestureCollection* cgc = SDKMinimalClient::GetInstance()->CurrentGestures();
+	if (cgc != nullptr) {
+		publisher.begin_frame();
+		publisher.observe_core_time(cgc->publishTime, cgc->receiveTimeNs);
+		const builtin_interfaces::msg::Time stamp = publisher.acquisition_stamp(cgc->publishTime, cgc->receiveTimeNs);
+		for (size_t i = 0; i < cgc->gloves.size(); ++i) {
+			publisher.publish_gestures(cgc->gloves[i], stamp);
+		}
+		publisher.end_frame(LatencyStream::Gesture, cgc->receiveSteadyNs, SDKMinimalClient::GetInstance()->GetLastSwapSteadyNs());
+	}
+}
+
+void convertRawSkeletonDataToROS(ManusROS2Publisher& publisher)
+{
+	ClientRawSkeletonCollection* crsc = SDKMinimalClient::GetInstance()->CurrentRawSkeletons();
+	if (crsc != nullptr) {
+		publisher.begin_frame();
+		publisher.observe_core_time(crsc->publishTime, crsc->receiveTimeNs);
+		for (size_t i = 0; i < crsc->skeletons.size(); ++i) {
+			const ClientRawSkeleton& skeleton = crsc->skeletons[i];
+			const ManusTimestamp &publish_time = skeleton.info.publishTime.time != 0 ? skeleton.info.publishTime : crsc->publishTime;
+			publisher.publish_raw_skeleton(skeleton, publisher.acquisition_stamp(publish_time, crsc->receiveTimeNs));
+		}
+		publisher.end_frame(LatencyStream::RawSkeleton, crsc->receiveSteadyNs, SDKMinimalClient::GetInstance()->GetLastSwapSteadyNs());
+	}
+}
+
+void publishPendingFrames(SDKMinimalClient& client, ManusROS2Publisher& publisher, FrameHandoffStats& stats)
+{
+	const int64_t t_ArrivalNs = client.GetFrameSignal().TakeOldestArrivalNs();
+	if (client.Run()) {
+		if (t_ArrivalNs != 0) {
+			stats.Record(FrameSignal::SteadyNowNs() - t_ArrivalNs);
+		}
+		// Only republish the streams that delivered a new frame since the last swap. The raw skeletons go first, as
+		// they are the freshest.
+		if (client.HasNewRawSkeletonData()) {
+			convertRawSkeletonDataToROS(publisher);
+		}
+		if (client.HasNewSkeletonData()) {
+			convertSkeletonDataToROS(publisher);
+		}
+		if (client.HasNewErgonomicsData()) {
+			convertErgonomicsDataToROS(publisher);
+		}
+		if (client.HasNewTrackerData()) {
+			convertTrackerDataToROS(publisher);
+		}
+		if (client.HasNewGestureData()) {
+			convertGestureDataToROS(publisher);
+		}
+	}
+}
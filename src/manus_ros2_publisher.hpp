@@ -0,0 +1,1194 @@
+/// @file manus_ros2_publisher.hpp
+/// @brief The manus_ros2 node, and the functions converting the frames received by SDKMinimalClient into the ROS 2
+/// messages it publishes.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "geometry_msgs/msg/pose_array.hpp"
+#include "geometry_msgs/msg/transform_stamped.hpp"
+#include "tf2_ros/static_transform_broadcaster.h"
+#include "tf2_ros/transform_broadcaster.h"
+#include "manus_ros2/msg/manus_hand.hpp"
+#include "manus_ros2/msg/manus_hand_state.hpp"
+#include "manus_ros2/msg/manus_ergonomics.hpp"
+#include "manus_ros2/msg/manus_ergonomics_state.hpp"
+#include "manus_ros2/msg/manus_layout.hpp"
+#include "manus_ros2/msg/manus_gestures.hpp"
+#include "manus_ros2/msg/manus_gesture_names.hpp"
+#include "manus_ros2/msg/manus_raw_skeleton.hpp"
+#include "manus_ros2/msg/manus_raw_skeleton_layout.hpp"
+#include "manus_ros2/msg/clock_sync.hpp"
+#include "manus_ros2/msg/latency_stats.hpp"
+#include "manus_ros2/msg/prediction_stats.hpp"
+#include "ErgonomicsNames.hpp"
+#include "HandSkeletonLayout.hpp"
+#include "LatencyStats.hpp"
+#include "MotionPredictor.hpp"
+#include "PoseResampler.hpp"
+#include "SDKMinimalClient.hpp"
+#include "SignalFilter.hpp"
+#include "tracker_tf.hpp"
+
+
+/// @brief The hand topics of one user, and the messages published on them.
+/// The messages live as long as the topics, with their frame IDs and pose storage set up once, so a frame only
+/// rewrites the stamp and the poses.
+struct UserHandPublishers
+{
+	rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr left;
+	rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr right;
+	rclcpp::Publisher<manus_ros2::msg::ManusHand>::SharedPtr left_fixed;
+	rclcpp::Publisher<manus_ros2::msg::ManusHand>::SharedPtr right_fixed;
+	rclcpp::Publisher<manus_ros2::msg::ManusHandState>::SharedPtr left_compact;
+	rclcpp::Publisher<manus_ros2::msg::ManusHandState>::SharedPtr right_compact;
+	// Published from the resampling thread.
+	rclcpp::Publisher<manus_ros2::msg::ManusHandState>::SharedPtr left_resampled;
+	rclcpp::Publisher<manus_ros2::msg::ManusHandState>::SharedPtr right_resampled;
+	geometry_msgs::msg::PoseArray left_message;
+	geometry_msgs::msg::PoseArray right_message;
+	// One transform per skeleton node with the frame IDs filled in, indexed by node ID.
+	std::vector<geometry_msgs::msg::TransformStamped> left_transforms;
+	std::vector<geometry_msgs::msg::TransformStamped> right_transforms;
+};
+
+/// @brief Backing arrays of a TrackerPoseArrays block that holds every tracker of a frame.
+struct TrackerPoseStorage
+{
+	std::array<double, MAX_NUMBER_OF_TRACKERS> x, y, z, qx, qy, qz, qw;
+
+	TrackerPoseArrays arrays() { return { x.data(), y.data(), z.data(), qx.data(), qy.data(), qz.data(), qw.data() }; }
+};
+
+/// @brief ROS2 publisher class for the manus_ros2 node
+class ManusROS2Publisher : public rclcpp::Node
+{
+public:
+	explicit ManusROS2Publisher(const rclcpp::NodeOptions& options = rclcpp::NodeOptions()) : Node("manus_ros2", options)
+	{
+		// Set by the component container or the standalone executable, hands the bounded messages to co-located
+		// subscribers by pointer.
+		intra_process_ = options.use_intra_process_comms();
+
+		// The original PoseArray / JointState topics, and the bounded fixed-size topics that middleware can loan.
+		legacy_messages_ = this->declare_parameter<bool>("legacy_messages", true);
+		fixed_size_messages_ = this->declare_parameter<bool>("fixed_size_messages", false);
+
+		// float32 hand and ergonomics messages, described once by the latched manus_layout topic.
+		compact_messages_ = this->declare_parameter<bool>("compact_messages", false);
+		if (compact_messages_) {
+			manus_ergonomics_compact_publisher_ = this->create_publisher<manus_ros2::msg::ManusErgonomicsState>("manus_ergonomics_compact", 10);
+			manus_layout_publisher_ = this->create_publisher<manus_ros2::msg::ManusLayout>("manus_layout", rclcpp::QoS(1).transient_local());
+			publish_layout();
+		}
+
+		// Hand skeletons for every user in the landscape, each on its own user_<id>/ topics.
+		multi_user_ = this->declare_parameter<bool>("multi_user", false);
+
+		// Every skeleton node as a TF frame, plus the bind pose as static frames.
+		publish_tf_ = this->declare_parameter<bool>("publish_tf", false);
+		tf_parent_frame_ = this->declare_parameter<std::string>("tf_parent_frame", "world");
+		if (publish_tf_) {
+			tf_broadcaster_ = std::make_shared<tf2_ros::TransformBroadcaster>(*this);
+			tf_static_broadcaster_ = std::make_shared<tf2_ros::StaticTransformBroadcaster>(*this);
+			tf_frame_transforms_.reserve((size_t)MAX_NUMBER_OF_SKELETONS * c_HandNodeCount);
+		}
+
+		if (legacy_messages_) {
+			manus_ergonomics_publisher = this->create_publisher<sensor_msgs::msg::JointState>("manus_ergonomics", 10);
+			ergonomics_message_.name = ergonomics_joint_names();
+			ergonomics_message_.position.assign(ErgonomicsDataType_MAX_SIZE, 0.0);
+		}
+		if (fixed_size_messages_) {
+			manus_ergonomics_fixed_publisher_ = this->create_publisher<manus_ros2::msg::ManusErgonomics>("manus_ergonomics_fixed", 10);
+			RCLCPP_INFO(this->get_logger(), "Fixed-size hand messages %s",
+				intra_process_ ? "are handed to intra-process subscribers without copying" :
+				manus_ergonomics_fixed_publisher_->can_loan_messages() ? "are loaned by the middleware" : "cannot be loaned by the middleware");
+		}
+		// Hand and tracker poses interpolated at resample_rate_hz, resample_delay_ms behind the stream, off at 0.
+		resample_rate_hz_ = this->declare_parameter<double>("resample_rate_hz", 0.0);
+		resample_delay_ns_ = (int64_t)(this->declare_parameter<double>("resample_delay_ms", 10.0) * 1e6);
+		const std::string interpolation = this->declare_parameter<std::string>("resample_interpolation", "hermite");
+		if (!ParseResampleInterpolation(interpolation, resample_interpolation_)) {
+			RCLCPP_WARN(this->get_logger(), "Unknown resample_interpolation '%s', expected linear or hermite", interpolation.c_str());
+		}
+		if (resample_rate_hz_ > 0.0) {
+			skeleton_history_.Configure(c_FilterHandCount * c_HandNodeCount, c_HandNodeCount);
+			resample_skeleton_values_.assign(7 * c_FilterHandCount * c_HandNodeCount, 0.0);
+			for (size_t c = 0; c < 7; c++) {
+				resample_skeleton_components_[c] = &resample_skeleton_values_[c * c_FilterHandCount * c_HandNodeCount];
+			}
+			for (int side = 0; side < 2; side++) {
+				// One group per hand: trackers are only interpolated between frames with as many of them.
+				tracker_histories_[side].Configure(MAX_NUMBER_OF_TRACKERS, MAX_NUMBER_OF_TRACKERS);
+				resample_tracker_messages_[side].header.frame_id = side == 1 ? "manus_tracker_right" : "manus_tracker_left";
+				resample_tracker_messages_[side].poses.reserve(MAX_NUMBER_OF_TRACKERS);
+			}
+			manus_tracker_left_resampled_publisher_ = this->create_publisher<geometry_msgs::msg::PoseArray>("manus_tracker_left_resampled", 10);
+			manus_tracker_right_resampled_publisher_ = this->create_publisher<geometry_msgs::msg::PoseArray>("manus_tracker_right_resampled", 10);
+			RCLCPP_INFO(this->get_logger(), "Resampling hands and trackers at %.1f Hz, %.1f ms behind the stream",
+				resample_rate_hz_, (double)resample_delay_ns_ * 1e-6);
+		}
+		if (!multi_user_) {
+			// The single user keeps the original topic names.
+			add_user(0, 0);
+		}
+		// The gesture_top_k most probable gestures of every glove, off at 0.
+		gesture_top_k_ = (uint32_t)std::min<int64_t>(std::max<int64_t>(this->declare_parameter<int64_t>("gesture_top_k", 0), 0),
+			manus_ros2::msg::ManusGestures::MAX_GESTURES);
+		if (gesture_top_k_ > 0) {
+			manus_gestures_publisher_ = this->create_publisher<manus_ros2::msg::ManusGestures>("manus_gestures", 10);
+			manus_gesture_names_publisher_ = this->create_publisher<manus_ros2::msg::ManusGestureNames>("manus_gesture_names", rclcpp::QoS(1).transient_local());
+		}
+		// The raw estimation skeleton of every glove, as Core has it before retargeting.
+		raw_skeletons_ = this->declare_parameter<bool>("raw_skeletons", false);
+		if (raw_skeletons_) {
+			manus_raw_skeleton_publisher_ = this->create_publisher<manus_ros2::msg::ManusRawSkeleton>("manus_raw_skeleton", 10);
+			// Deep enough to keep the layout of every glove for late subscribers.
+			manus_raw_skeleton_layout_publisher_ = this->create_publisher<manus_ros2::msg::ManusRawSkeletonLayout>("manus_raw_skeleton_layout",
+				rclcpp::QoS(MAX_NUMBER_OF_GLOVES).transient_local());
+		}
+		manus_leftTrackerData_publisher_ = this->create_publisher<geometry_msgs::msg::Pose>("manus_tracker_left", 10);
+		manus_rightTrackerData_publisher_ = this->create_publisher<geometry_msgs::msg::Pose>("manus_tracker_right", 10);
+
+		// Smoothing of each stream before it is published, off unless <stream>_filter is set. Poses are filtered as
+		// x, y, z and a quaternion.
+		skeleton_filter_.Configure(declare_filter_parameters("skeleton"), 7, c_FilterHandCount * c_HandNodeCount, 3);
+		filter_skeleton_values_.assign(7 * c_FilterHandCount * c_HandNodeCount, 0.0);
+		for (size_t c = 0; c < 7; c++) {
+			filter_skeleton_components_[c] = &filter_skeleton_values_[c * c_FilterHandCount * c_HandNodeCount];
+		}
+		ergonomics_filter_.Configure(declare_filter_parameters("ergonomics"), 1, ErgonomicsDataType_MAX_SIZE);
+		const SignalFilterConfig tracker_filter = declare_filter_parameters("tracker");
+		for (SignalFilterBank& filter : tracker_filters_) {
+			filter.Configure(tracker_filter, 7, MAX_NUMBER_OF_TRACKERS, 3);
+		}
+
+		// Skeleton and tracker poses extrapolated <stream>_prediction_ms ahead of their sample time, after filtering.
+		// The look-ahead can be changed while running, to tune it against the errors on manus_prediction_stats.
+		skeleton_prediction_s_.store(this->declare_parameter<double>("skeleton_prediction_ms", 0.0) * 1e-3);
+		tracker_prediction_s_.store(this->declare_parameter<double>("tracker_prediction_ms", 0.0) * 1e-3);
+		skeleton_predictor_.Configure(c_FilterHandCount * c_HandNodeCount,
+			this->declare_parameter<double>("skeleton_prediction_velocity_cutoff", 15.0));
+		const double tracker_velocity_cutoff = this->declare_parameter<double>("tracker_prediction_velocity_cutoff", 15.0);
+		for (PosePredictor& predictor : tracker_predictors_) {
+			predictor.Configure(MAX_NUMBER_OF_TRACKERS, tracker_velocity_cutoff);
+		}
+		prediction_parameters_callback_ = this->add_on_set_parameters_callback(
+			[this](const std::vector<rclcpp::Parameter>& parameters) { return set_prediction_parameters(parameters); });
+
+		// Stamp messages with the Core publish time mapped onto the local clock, rather than the conversion time.
+		use_core_timestamps_ = this->declare_parameter<bool>("use_core_timestamps", true);
+		manus_clock_sync_publisher_ = this->create_publisher<manus_ros2::msg::ClockSync>("manus_clock_sync", 10);
+		clock_sync_timer_ = this->create_wall_timer(std::chrono::seconds(1), [this]() { publish_clock_sync(); });
+
+		// Low rate per-stage latency percentiles of every stream, 0 disables the topic.
+		const int64_t latency_stats_period_s = this->declare_parameter<int64_t>("latency_stats_period_s", 1);
+		if (latency_stats_period_s > 0) {
+			manus_latency_stats_publisher_ = this->create_publisher<manus_ros2::msg::LatencyStats>("manus_latency_stats", 10);
+			manus_prediction_stats_publisher_ = this->create_publisher<manus_ros2::msg::PredictionStats>("manus_prediction_stats", 10);
+			latency_stats_timer_ = this->create_wall_timer(std::chrono::seconds(latency_stats_period_s),
+				[this, latency_stats_period_s]() {
+					publish_latency_stats((double)latency_stats_period_s);
+					publish_prediction_stats((double)latency_stats_period_s);
+				});
+		}
+	}
+
+	/// @brief Starts timing the filter and publish calls of a new frame. Called from the publishing thread.
+	void begin_frame() {
+		frame_filter_ns_ = 0;
+		frame_publish_ns_ = 0;
+	}
+
+	/// @brief Records the stage latencies of a frame once all of its messages have been published.
+	/// @param callback_ns Steady clock time the SDK callback delivering the frame was entered.
+	/// @param swap_ns Steady clock time the frame was swapped in on the publishing thread.
+	void end_frame(LatencyStream stream, int64_t callback_ns, int64_t swap_ns) {
+		if (callback_ns == 0) {
+			return;
+		}
+		latency_.RecordFrame(stream, callback_ns, swap_ns, frame_filter_ns_, frame_publish_ns_, FrameSignal::SteadyNowNs());
+	}
+
+	/// @brief Publishes the percentiles of every stream and stage recorded since the last call.
+	void publish_latency_stats(double window_s) {
+		manus_ros2::msg::LatencyStats message;
+		message.stamp = this->now();
+		message.window = window_s;
+		for (int stream = 0; stream < (int)LatencyStream::Count; stream++) {
+			for (int stage = 0; stage < (int)LatencyStage::Count; stage++) {
+				const LatencyHistogram::Summary summary = latency_.Get((LatencyStream)stream, (LatencyStage)stage).TakeWindow();
+				if (summary.count == 0) {
+					continue;
+				}
+				manus_ros2::msg::StageLatency stage_latency;
+				stage_latency.stream = LatencyStreamName((LatencyStream)stream);
+				stage_latency.stage = LatencyStageName((LatencyStage)stage);
+				stage_latency.count = summary.count;
+				stage_latency.mean = summary.meanUs;
+				stage_latency.p50 = summary.p50Us;
+				stage_latency.p90 = summary.p90Us;
+				stage_latency.p99 = summary.p99Us;
+				stage_latency.max = summary.maxUs;
+				message.stages.push_back(stage_latency);
+			}
+		}
+		if (!message.stages.empty()) {
+			manus_latency_stats_publisher_->publish(message);
+		}
+	}
+
+	/// @brief Publishes the prediction errors of every stream that is predicted.
+	void publish_prediction_stats(double window_s) {
+		const struct {
+			const char* stream;
+			double horizon_s;
+			PredictionErrorStats& stats;
+		} streams[] = {
+			{ "skeleton", skeleton_prediction_s_.load(std::memory_order_relaxed), skeleton_prediction_stats_ },
+			{ "tracker", tracker_prediction_s_.load(std::memory_order_relaxed), tracker_prediction_stats_ },
+		};
+		for (const auto& stream : streams) {
+			const PredictionErrorStats::Summary summary = stream.stats.TakeWindow();
+			if (stream.horizon_s <= 0.0 && summary.count == 0) {
+				continue;
+			}
+			manus_ros2::msg::PredictionStats message;
+			message.stamp = this->now();
+			message.stream = stream.stream;
+			message.horizon = stream.horizon_s;
+			message.window = window_s;
+			message.count = summary.count;
+			message.position_error_mean = summary.positionMean;
+			message.position_error_max = summary.positionMax;
+			message.rotation_error_mean = summary.rotationMean;
+			message.rotation_error_max = summary.rotationMax;
+			manus_prediction_stats_publisher_->publish(message);
+		}
+	}
+
+	/// @brief Applies look-ahead changes made while running. Called by the executor before the parameters are set.
+	rcl_interfaces::msg::SetParametersResult set_prediction_parameters(const std::vector<rclcpp::Parameter>& parameters) {
+		rcl_interfaces::msg::SetParametersResult result;
+		result.successful = true;
+		for (const rclcpp::Parameter& parameter : parameters) {
+			if (parameter.get_name() != "skeleton_prediction_ms" && parameter.get_name() != "tracker_prediction_ms") {
+				continue;
+			}
+			if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_DOUBLE) {
+				result.successful = false;
+				result.reason = parameter.get_name() + " must be a double";
+				return result;
+			}
+			const double horizon_ms = parameter.as_double();
+			if (horizon_ms < 0.0 || horizon_ms > PosePredictor::c_MaxHorizonS * 1e3) {
+				result.successful = false;
+				result.reason = parameter.get_name() + " must be between 0 and " + std::to_string((int)(PosePredictor::c_MaxHorizonS * 1e3));
+				return result;
+			}
+		}
+		for (const rclcpp::Parameter& parameter : parameters) {
+			if (parameter.get_name() == "skeleton_prediction_ms") {
+				skeleton_prediction_s_.store(parameter.as_double() * 1e-3, std::memory_order_relaxed);
+			} else if (parameter.get_name() == "tracker_prediction_ms") {
+				tracker_prediction_s_.store(parameter.as_double() * 1e-3, std::memory_order_relaxed);
+			}
+		}
+		return result;
+	}
+
+	/// @brief Feeds the Core publish time and local receive time of a stream frame to the clock offset estimator.
+	/// Called from the publishing thread for every new frame.
+	void observe_core_time(const ManusTimestamp& publish_time, int64_t receive_ns) {
+		int64_t core_ns = 0;
+		frame_local_ns_ = receive_ns;
+		if (!sdk_timestamps_ || !ManusTimestampToUnixNs(publish_time, core_ns)) {
+			frame_sample_ns_ = receive_ns;
+			return;
+		}
+		// Filters step by the Core publish times, which do not carry the jitter of the delivery.
+		frame_sample_ns_ = core_ns;
+		clock_estimator_.AddSample(core_ns, receive_ns);
+		if (clock_estimator_.IsValid()) {
+			frame_local_ns_ = std::min(clock_estimator_.ToLocalNs(core_ns), receive_ns);
+		}
+
+		clock_raw_offset_ns_.store(clock_estimator_.LastRawOffsetNs(), std::memory_order_relaxed);
+		clock_offset_ns_.store(clock_estimator_.OffsetAtNs(core_ns), std::memory_order_relaxed);
+		clock_skew_ppm_.store(clock_estimator_.SkewPpm(), std::memory_order_relaxed);
+		clock_sample_count_.store(clock_estimator_.SampleCount(), std::memory_order_relaxed);
+	}
+
+	/// @brief Header stamp for data Core published at publish_time and the node received at receive_ns.
+	/// Falls back to the current time when Core timestamps are disabled or cannot be decoded.
+	builtin_interfaces::msg::Time acquisition_stamp(const ManusTimestamp& publish_time, int64_t receive_ns) {
+		int64_t core_ns = 0;
+		if (use_core_timestamps_ && sdk_timestamps_ && clock_estimator_.IsValid() && ManusTimestampToUnixNs(publish_time, core_ns)) {
+			// Never stamp data later than it was actually received.
+			return rclcpp::Time(std::min(clock_estimator_.ToLocalNs(core_ns), receive_ns));
+		}
+		return this->now();
+	}
+
+	/// @brief Publishes the raw and filtered clock offset and the skew for monitoring.
+	void publish_clock_sync() {
+		const uint64_t sample_count = clock_sample_count_.load(std::memory_order_relaxed);
+		if (sample_count == 0) {
+			return;
+		}
+		manus_ros2::msg::ClockSync message;
+		message.stamp = this->now();
+		message.raw_offset = (double)clock_raw_offset_ns_.load(std::memory_order_relaxed) * 1e-9;
+		message.offset = clock_offset_ns_.load(std::memory_order_relaxed) * 1e-9;
+		message.skew_ppm = clock_skew_ppm_.load(std::memory_order_relaxed);
+		message.sample_count = sample_count;
+		manus_clock_sync_publisher_->publish(message);
+	}
+
+	bool legacy_messages() const { return legacy_messages_; }
+	bool intra_process() const { return intra_process_; }
+	bool fixed_size_messages() const { return fixed_size_messages_; }
+	bool compact_messages() const { return compact_messages_; }
+	bool multi_user() const { return multi_user_; }
+	uint32_t gesture_top_k() const { return gesture_top_k_; }
+	bool raw_skeletons() const { return raw_skeletons_; }
+
+	/// @brief Decoding Core publish times needs an initialized SDK, which a replay never has. Without it the clock
+	/// estimator is not fed and messages are stamped with the time they are converted. Set before the first frame.
+	void set_sdk_timestamps(bool sdk_timestamps) { sdk_timestamps_ = sdk_timestamps; }
+
+	/// @brief Creates the hand topics of a client user slot, if it has none yet.
+	/// Not thread safe against itself, call it from one thread. The publishing thread picks the new topics up through
+	/// user_publishers().
+	void add_user(uint32_t slot, uint32_t user_id) {
+		if (slot >= user_publishers_.size() || user_publishers_[slot].load(std::memory_order_acquire) != nullptr) {
+			return;
+		}
+		const std::string prefix = multi_user_ ? "user_" + std::to_string(user_id) + "/" : "";
+		std::unique_ptr<UserHandPublishers> hands(new UserHandPublishers());
+		if (legacy_messages_) {
+			hands->left = this->create_publisher<geometry_msgs::msg::PoseArray>(prefix + "manus_left", 10);
+			hands->right = this->create_publisher<geometry_msgs::msg::PoseArray>(prefix + "manus_right", 10);
+			hands->left_message.header.frame_id = prefix + "manus_left";
+			hands->right_message.header.frame_id = prefix + "manus_right";
+			hands->left_message.poses.reserve(MAX_NUMBER_OF_NODES_PER_ESTIMATION_SKELETON);
+			hands->right_message.poses.reserve(MAX_NUMBER_OF_NODES_PER_ESTIMATION_SKELETON);
+		}
+		if (fixed_size_messages_) {
+			hands->left_fixed = this->create_publisher<manus_ros2::msg::ManusHand>(prefix + "manus_left_fixed", 10);
+			hands->right_fixed = this->create_publisher<manus_ros2::msg::ManusHand>(prefix + "manus_right_fixed", 10);
+		}
+		if (compact_messages_) {
+			hands->left_compact = this->create_publisher<manus_ros2::msg::ManusHandState>(prefix + "manus_left_compact", 10);
+			hands->right_compact = this->create_publisher<manus_ros2::msg::ManusHandState>(prefix + "manus_right_compact", 10);
+		}
+		if (resample_rate_hz_ > 0.0) {
+			hands->left_resampled = this->create_publisher<manus_ros2::msg::ManusHandState>(prefix + "manus_left_resampled", 10);
+			hands->right_resampled = this->create_publisher<manus_ros2::msg::ManusHandState>(prefix + "manus_right_resampled", 10);
+		}
+		if (publish_tf_) {
+			hands->left_transforms = hand_transforms(prefix + "manus_left");
+			hands->right_transforms = hand_transforms(prefix + "manus_right");
+			tf_static_broadcaster_->sendTransform(hand_bind_transforms(prefix + "manus_left", c_HandBindPositionsLeft));
+			tf_static_broadcaster_->sendTransform(hand_bind_transforms(prefix + "manus_right", c_HandBindPositionsRight));
+		}
+		if (multi_user_) {
+			RCLCPP_INFO(this->get_logger(), "Publishing the hands of user %u on %s*", user_id, prefix.c_str());
+		}
+		user_publishers_[slot].store(hands.get(), std::memory_order_release);
+		user_publisher_storage_.push_back(std::move(hands));
+	}
+
+	/// @brief Hand topics of a client user slot, nullptr until add_user() created them. The publishing thread owns
+	/// their messages.
+	UserHandPublishers* user_publishers(uint32_t slot) {
+		return slot < user_publishers_.size() ? user_publishers_[slot].load(std::memory_order_acquire) : nullptr;
+	}
+
+	/// @brief Reads the filter configuration of a stream from the <stream>_filter* parameters.
+	SignalFilterConfig declare_filter_parameters(const std::string& stream) {
+		SignalFilterConfig config;
+		const std::string type = this->declare_parameter<std::string>(stream + "_filter", "none");
+		if (!ParseSignalFilterType(type, config.type)) {
+			RCLCPP_WARN(this->get_logger(), "Unknown %s_filter '%s', expected none, one_euro, critically_damped or median",
+				stream.c_str(), type.c_str());
+		}
+		config.minCutoffHz = this->declare_parameter<double>(stream + "_filter_min_cutoff", config.minCutoffHz);
+		config.beta = this->declare_parameter<double>(stream + "_filter_beta", config.beta);
+		config.derivativeCutoffHz = this->declare_parameter<double>(stream + "_filter_d_cutoff", config.derivativeCutoffHz);
+		config.timeConstantS = this->declare_parameter<double>(stream + "_filter_time_constant", config.timeConstantS);
+		config.medianWindow = (uint32_t)this->declare_parameter<int64_t>(stream + "_filter_median_window", config.medianWindow);
+		config.outlierThreshold = this->declare_parameter<double>(stream + "_filter_outlier_threshold", config.outlierThreshold);
+		if (config.type != SignalFilterType::None) {
+			RCLCPP_INFO(this->get_logger(), "Filtering the %s stream with %s", stream.c_str(), type.c_str());
+		}
+		return config;
+	}
+
+	/// @brief Filters and predicts the nodes of every routed hand skeleton of a frame in place, in one pass over all of
+	/// them, and adds them to the resampling history. Each hand keeps the state of its user slot and side, which
+	/// restarts when the hand skips a frame or is replaced by another skeleton.
+	void filter_skeletons(ClientSkeletonCollection& skeletons, SDKMinimalClient& client) {
+		const double horizon_s = skeleton_prediction_s_.load(std::memory_order_relaxed);
+		const bool resampling = skeleton_history_.IsConfigured();
+		if (!skeleton_filter_.IsEnabled() && horizon_s <= 0.0 && !resampling) {
+			skeleton_predicting_ = false;
+			return;
+		}
+		const int64_t start_ns = FrameSignal::SteadyNowNs();
+		std::array<bool, c_FilterHandCount> present{};
+		size_t hand_count = 0;
+		for (size_t i = 0; i < skeletons.skeletons.size(); ++i) {
+			const ClientSkeleton &skeleton = skeletons.skeletons[i];
+			const HandSkeletonRoute* route = client.FindHandSkeleton(skeleton.info.id);
+			filter_skeleton_hands_[i] = route != nullptr ? route->userSlot * 2 + (route->isRightHand ? 1 : 0) : c_FilterHandCount;
+			const size_t hand = filter_skeleton_hands_[i];
+			if (hand >= c_FilterHandCount) {
+				continue;
+			}
+			const size_t first = hand * c_HandNodeCount;
+			if (!filter_hand_present_[hand] || filter_hand_skeleton_ids_[hand] != skeleton.info.id) {
+				skeleton_filter_.Reset(first, first + c_HandNodeCount);
+				skeleton_predictor_.Reset(first, first + c_HandNodeCount);
+				filter_hand_skeleton_ids_[hand] = skeleton.info.id;
+			}
+			present[hand] = true;
+			hand_count = std::max(hand_count, hand + 1);
+
+			const size_t node_count = std::min<size_t>(skeleton.nodes.size(), c_HandNodeCount);
+			for (size_t j = 0; j < node_count; ++j) {
+				const ManusTransform &transform = skeleton.nodes[j].transform;
+				filter_skeleton_components_[0][first + j] = transform.position.x;
+				filter_skeleton_components_[1][first + j] = transform.position.y;
+				filter_skeleton_components_[2][first + j] = transform.position.z;
+				filter_skeleton_components_[3][first + j] = transform.rotation.x;
+				filter_skeleton_components_[4][first + j] = transform.rotation.y;
+				filter_skeleton_components_[5][first + j] = transform.rotation.z;
+				filter_skeleton_components_[6][first + j] = transform.rotation.w;
+			}
+		}
+		filter_hand_present_ = present;
+		// Slots of absent hands below the highest one ride along on stale values, restarted every frame so they are
+		// neither smoothed nor counted in the prediction errors.
+		for (size_t hand = 0; hand < hand_count; hand++) {
+			if (!present[hand]) {
+				skeleton_filter_.Reset(hand * c_HandNodeCount, (hand + 1) * c_HandNodeCount);
+				skeleton_predictor_.Reset(hand * c_HandNodeCount, (hand + 1) * c_HandNodeCount);
+			}
+		}
+
+		skeleton_filter_.Process(filter_skeleton_components_, hand_count * c_HandNodeCount, frame_sample_ns_);
+		if (horizon_s > 0.0) {
+			if (!skeleton_predicting_) {
+				skeleton_predictor_.Reset(0, c_FilterHandCount * c_HandNodeCount);
+				skeleton_predicting_ = true;
+			}
+			skeleton_predictor_.Process(filter_skeleton_components_, hand_count * c_HandNodeCount, frame_sample_ns_, horizon_s, skeleton_prediction_stats_);
+		} else {
+			skeleton_predicting_ = false;
+		}
+		if (resampling) {
+			// Predicted poses are where the hand will be a horizon after the frame, so that is when they are kept for.
+			for (size_t hand = 0; hand < hand_count; hand++) {
+				resample_hand_keys_[hand] = present[hand] ? filter_hand_skeleton_ids_[hand] : PoseHistory::c_Absent;
+			}
+			skeleton_history_.Push(filter_skeleton_components_, hand_count * c_HandNodeCount, resample_hand_keys_.data(),
+				frame_local_ns_ + (skeleton_predicting_ ? (int64_t)(horizon_s * 1e9) : 0));
+			if (!skeleton_filter_.IsEnabled() && !skeleton_predicting_) {
+				frame_filter_ns_ += FrameSignal::SteadyNowNs() - start_ns;
+				return;
+			}
+		}
+
+		for (size_t i = 0; i < skeletons.skeletons.size(); ++i) {
+			const size_t hand = filter_skeleton_hands_[i];
+			if (hand >= c_FilterHandCount) {
+				continue;
+			}
+			const size_t first = hand * c_HandNodeCount;
+			ClientSkeleton &skeleton = skeletons.skeletons[i];
+			const size_t node_count = std::min<size_t>(skeleton.nodes.size(), c_HandNodeCount);
+			for (size_t j = 0; j < node_count; ++j) {
+				ManusTransform &transform = skeleton.nodes[j].transform;
+				transform.position.x = (float)filter_skeleton_components_[0][first + j];
+				transform.position.y = (float)filter_skeleton_components_[1][first + j];
+				transform.position.z = (float)filter_skeleton_components_[2][first + j];
+				transform.rotation.x = (float)filter_skeleton_components_[3][first + j];
+				transform.rotation.y = (float)filter_skeleton_components_[4][first + j];
+				transform.rotation.z = (float)filter_skeleton_components_[5][first + j];
+				transform.rotation.w = (float)filter_skeleton_components_[6][first + j];
+			}
+		}
+		frame_filter_ns_ += FrameSignal::SteadyNowNs() - start_ns;
+	}
+
+	/// @brief Filters the ergonomics values of both hands in place.
+	void filter_ergonomics(ClientErgonomics& ergonomics) {
+		if (!ergonomics_filter_.IsEnabled()) {
+			return;
+		}
+		const int64_t start_ns = FrameSignal::SteadyNowNs();
+		for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++) {
+			const ErgonomicsData &data = IsLeftHandErgonomicsDataType(i) ? ergonomics.data_left : ergonomics.data_right;
+			filter_ergonomics_values_[i] = data.data[i];
+		}
+		double* const components[1] = { filter_ergonomics_values_.data() };
+		ergonomics_filter_.Process(components, ErgonomicsDataType_MAX_SIZE, frame_sample_ns_);
+		for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++) {
+			ErgonomicsData &data = IsLeftHandErgonomicsDataType(i) ? ergonomics.data_left : ergonomics.data_right;
+			data.data[i] = (float)filter_ergonomics_values_[i];
+		}
+		frame_filter_ns_ += FrameSignal::SteadyNowNs() - start_ns;
+	}
+
+	/// @brief Publishes one hand skeleton as a PoseArray, rewriting the hand's persistent message in place (see
+	/// publish_persistent).
+	void publish_hand(UserHandPublishers& hands, const ClientSkeleton& skeleton, bool is_right_hand, const builtin_interfaces::msg::Time& stamp) {
+		geometry_msgs::msg::PoseArray& message = is_right_hand ? hands.right_message : hands.left_message;
+		message.header.stamp = stamp;
+		// Stays within the reserved storage, so this only moves the end.
+		message.poses.resize(skeleton.nodes.size());
+		for (size_t j = 0; j < skeleton.nodes.size(); ++j) {
+			const auto &joint = skeleton.nodes[j];
+			auto &pose = message.poses[j];
+			pose.position.x = joint.transform.position.x;
+			pose.position.y = joint.transform.position.y;
+			pose.position.z = joint.transform.position.z;
+			pose.orientation.x = joint.transform.rotation.x;
+			pose.orientation.y = joint.transform.rotation.y;
+			pose.orientation.z = joint.transform.rotation.z;
+			pose.orientation.w = joint.transform.rotation.w;
+		}
+		publish_persistent(is_right_hand ? hands.right : hands.left, message);
+	}
+
+	bool publish_tf() const { return publish_tf_; }
+
+	/// @brief Adds the node transforms of one hand to the TF batch of the current frame.
+	/// Skeleton transforms are local, so every node is published relative to its parent node.
+	void add_hand_tf(UserHandPublishers& hands, const ClientSkeleton& skeleton, bool is_right_hand, const builtin_interfaces::msg::Time& stamp) {
+		const std::vector<geometry_msgs::msg::TransformStamped>& hand_transforms = is_right_hand ? hands.right_transforms : hands.left_transforms;
+		for (size_t j = 0; j < skeleton.nodes.size(); ++j) {
+			const SkeletonNode &node = skeleton.nodes[j];
+			if (node.id >= hand_transforms.size()) {
+				continue;
+			}
+			// Copy assigning reuses the storage of the frame IDs once the batch has held this many transforms.
+			if (tf_frame_count_ == tf_frame_transforms_.size()) {
+				tf_frame_transforms_.emplace_back();
+			}
+			geometry_msgs::msg::TransformStamped &transform = tf_frame_transforms_[tf_frame_count_++];
+			transform = hand_transforms[node.id];
+			transform.header.stamp = stamp;
+			transform.transform.translation.x = node.transform.position.x;
+			transform.transform.translation.y = node.transform.position.y;
+			transform.transform.translation.z = node.transform.position.z;
+			transform.transform.rotation.x = node.transform.rotation.x;
+			transform.transform.rotation.y = node.transform.rotation.y;
+			transform.transform.rotation.z = node.transform.rotation.z;
+			transform.transform.rotation.w = node.transform.rotation.w;
+		}
+	}
+
+	/// @brief Broadcasts the TF batch of the current frame in one call.
+	void send_tf() {
+		if (tf_frame_count_ == 0) {
+			return;
+		}
+		// Only shrinks when hands left since the last frame.
+		tf_frame_transforms_.resize(tf_frame_count_);
+		timed_publish([&]() { tf_broadcaster_->sendTransform(tf_frame_transforms_); });
+		tf_frame_count_ = 0;
+	}
+
+	/// @brief Publishes the ergonomics of both hands as a JointState. The joint names were filled in once, only the
+	/// stamp and positions are rewritten.
+	void publish_ergonomics(const ClientErgonomics& ergonomics, const builtin_interfaces::msg::Time& stamp) {
+		ergonomics_message_.header.stamp = stamp;
+		for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++) {
+			const ErgonomicsData &data = IsLeftHandErgonomicsDataType(i) ? ergonomics.data_left : ergonomics.data_right;
+			ergonomics_message_.position[i] = data.data[i];
+		}
+		publish_persistent(manus_ergonomics_publisher, ergonomics_message_);
+	}
+
+	/// @brief Publishes one hand skeleton as a fixed-size message, filled in place in middleware memory when possible.
+	void publish_hand_fixed(const UserHandPublishers& hands, const ClientSkeleton& skeleton, bool is_right_hand, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(is_right_hand ? hands.right_fixed : hands.left_fixed,
+			[&skeleton, &stamp](manus_ros2::msg::ManusHand& hand) {
+				const size_t node_count = std::min<size_t>(skeleton.nodes.size(), manus_ros2::msg::ManusHand::NODE_COUNT);
+				hand.stamp = stamp;
+				hand.skeleton_id = skeleton.info.id;
+				hand.node_count = (uint8_t)node_count;
+				for (size_t j = 0; j < manus_ros2::msg::ManusHand::NODE_COUNT; ++j) {
+					auto &pose = hand.poses[j];
+					if (j < node_count) {
+						const auto &joint = skeleton.nodes[j];
+						pose.position.x = joint.transform.position.x;
+						pose.position.y = joint.transform.position.y;
+						pose.position.z = joint.transform.position.z;
+						pose.orientation.x = joint.transform.rotation.x;
+						pose.orientation.y = joint.transform.rotation.y;
+						pose.orientation.z = joint.transform.rotation.z;
+						pose.orientation.w = joint.transform.rotation.w;
+					} else {
+						pose = geometry_msgs::msg::Pose();
+					}
+				}
+			});
+	}
+
+	/// @brief Publishes one hand skeleton as float32 arrays, loaned when possible.
+	void publish_hand_compact(const UserHandPublishers& hands, const ClientSkeleton& skeleton, bool is_right_hand, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(is_right_hand ? hands.right_compact : hands.left_compact,
+			[&skeleton, &stamp](manus_ros2::msg::ManusHandState& hand) {
+				const size_t node_count = std::min<size_t>(skeleton.nodes.size(), manus_ros2::msg::ManusHandState::NODE_COUNT);
+				hand.stamp = stamp;
+				hand.skeleton_id = skeleton.info.id;
+				hand.node_count = (uint8_t)node_count;
+				for (size_t j = 0; j < node_count; ++j) {
+					const ManusTransform &transform = skeleton.nodes[j].transform;
+					hand.positions[j * 3 + 0] = transform.position.x;
+					hand.positions[j * 3 + 1] = transform.position.y;
+					hand.positions[j * 3 + 2] = transform.position.z;
+					hand.rotations[j * 4 + 0] = transform.rotation.x;
+					hand.rotations[j * 4 + 1] = transform.rotation.y;
+					hand.rotations[j * 4 + 2] = transform.rotation.z;
+					hand.rotations[j * 4 + 3] = transform.rotation.w;
+				}
+				std::fill(hand.positions.begin() + node_count * 3, hand.positions.end(), 0.0f);
+				std::fill(hand.rotations.begin() + node_count * 4, hand.rotations.end(), 0.0f);
+			});
+	}
+
+	/// @brief Publishes the ergonomics of both hands as float32 values, loaned when possible.
+	void publish_ergonomics_compact(const ClientErgonomics& ergonomics, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(manus_ergonomics_compact_publisher_,
+			[&ergonomics, &stamp](manus_ros2::msg::ManusErgonomicsState& message) {
+				message.stamp = stamp;
+				for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++) {
+					const ErgonomicsData &data = IsLeftHandErgonomicsDataType(i) ? ergonomics.data_left : ergonomics.data_right;
+					message.values[i] = (float)data.data[i];
+				}
+			});
+	}
+
+	/// @brief Publishes the most probable gestures of a glove, loaned when possible.
+	void publish_gestures(const GloveGestures& glove, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(manus_gestures_publisher_,
+			[&glove, &stamp](manus_ros2::msg::ManusGestures& message) {
+				message.stamp = stamp;
+				message.glove_id = glove.gloveID;
+				message.side = glove.side == Side::Side_Left ? manus_ros2::msg::ManusGestures::SIDE_LEFT :
+					glove.side == Side::Side_Right ? manus_ros2::msg::ManusGestures::SIDE_RIGHT : manus_ros2::msg::ManusGestures::SIDE_UNKNOWN;
+				message.total_gesture_count = glove.totalGestureCount;
+				const size_t count = std::min<size_t>(glove.top.size(), manus_ros2::msg::ManusGestures::MAX_GESTURES);
+				message.gesture_count = (uint8_t)count;
+				for (size_t i = 0; i < manus_ros2::msg::ManusGestures::MAX_GESTURES; i++) {
+					message.ids[i] = i < count ? glove.top[i].id : 0;
+					message.probabilities[i] = i < count ? glove.top[i].percent : 0.0f;
+				}
+			});
+	}
+
+	/// @brief Publishes the names of the gesture IDs on the latched gesture names topic.
+	void publish_gesture_names(const std::vector<GestureLandscapeData>& gestures) {
+		manus_ros2::msg::ManusGestureNames message;
+		message.stamp = this->now();
+		for (const GestureLandscapeData& gesture : gestures) {
+			message.ids.push_back(gesture.id);
+			message.names.emplace_back(gesture.name, strnlen(gesture.name, sizeof(gesture.name)));
+		}
+		manus_gesture_names_publisher_->publish(message);
+	}
+
+	/// @brief Publishes the raw skeleton of a glove as float32 arrays, loaned when possible.
+	void publish_raw_skeleton(const ClientRawSkeleton& skeleton, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(manus_raw_skeleton_publisher_,
+			[&skeleton, &stamp](manus_ros2::msg::ManusRawSkeleton& message) {
+				const size_t node_count = std::min<size_t>(skeleton.nodes.size(), manus_ros2::msg::ManusRawSkeleton::MAX_NODES);
+				message.stamp = stamp;
+				message.glove_id = skeleton.info.gloveId;
+				message.side = skeleton.side == Side::Side_Left ? manus_ros2::msg::ManusRawSkeleton::SIDE_LEFT :
+					skeleton.side == Side::Side_Right ? manus_ros2::msg::ManusRawSkeleton::SIDE_RIGHT : manus_ros2::msg::ManusRawSkeleton::SIDE_UNKNOWN;
+				message.node_count = (uint8_t)node_count;
+				for (size_t j = 0; j < node_count; ++j) {
+					const ManusTransform &transform = skeleton.nodes[j].transform;
+					message.positions[j * 3 + 0] = transform.position.x;
+					message.positions[j * 3 + 1] = transform.position.y;
+					message.positions[j * 3 + 2] = transform.position.z;
+					message.rotations[j * 4 + 0] = transform.rotation.x;
+					message.rotations[j * 4 + 1] = transform.rotation.y;
+					message.rotations[j * 4 + 2] = transform.rotation.z;
+					message.rotations[j * 4 + 3] = transform.rotation.w;
+				}
+				std::fill(message.positions.begin() + node_count * 3, message.positions.end(), 0.0f);
+				std::fill(message.rotations.begin() + node_count * 4, message.rotations.end(), 0.0f);
+			});
+	}
+
+	/// @brief Publishes the node layout of a glove's raw skeleton on the latched raw skeleton layout topic.
+	void publish_raw_skeleton_layout(const RawSkeletonLayout& layout) {
+		manus_ros2::msg::ManusRawSkeletonLayout message;
+		message.stamp = this->now();
+		message.glove_id = layout.gloveID;
+		for (const NodeInfo& node : layout.nodes) {
+			message.node_ids.push_back(node.nodeId);
+			message.parent_ids.push_back(node.parentId);
+			message.chain_types.push_back((uint8_t)node.chainType);
+			message.sides.push_back((uint8_t)node.side);
+			message.finger_joint_types.push_back((uint8_t)node.fingerJointType);
+		}
+		manus_raw_skeleton_layout_publisher_->publish(message);
+	}
+
+	/// @brief Publishes the meaning of the compact message indices on the latched layout topic.
+	void publish_layout() {
+		manus_ros2::msg::ManusLayout layout;
+		layout.node_names.assign(std::begin(c_HandNodeNames), std::end(c_HandNodeNames));
+		for (uint32_t id = 0; id < c_HandNodeCount; id++) {
+			layout.node_parents.push_back(HandNodeParentID(id));
+			// The root sits at the skeleton origin.
+			const ManusVec3 left = id == 0 ? ManusVec3{ 0.0f, 0.0f, 0.0f } : c_HandBindPositionsLeft[id - 1];
+			const ManusVec3 right = id == 0 ? ManusVec3{ 0.0f, 0.0f, 0.0f } : c_HandBindPositionsRight[id - 1];
+			layout.left_bind_positions.insert(layout.left_bind_positions.end(), { left.x, left.y, left.z });
+			layout.right_bind_positions.insert(layout.right_bind_positions.end(), { right.x, right.y, right.z });
+		}
+		layout.ergonomics_names = ergonomics_joint_names();
+		// Matches the CoordinateSystemVUH set up in SDKMinimalClient::Initialize().
+		layout.coordinate_system = "right handed, z up, x from viewer";
+		layout.unit_scale = 1.0f;
+		manus_layout_publisher_->publish(layout);
+	}
+
+	/// @brief Publishes the ergonomics of both hands as a fixed-size message, loaned when possible.
+	void publish_ergonomics_fixed(const ClientErgonomics& ergonomics, const builtin_interfaces::msg::Time& stamp) {
+		publish_fixed(manus_ergonomics_fixed_publisher_,
+			[&ergonomics, &stamp](manus_ros2::msg::ManusErgonomics& message) {
+				message.stamp = stamp;
+				for (int i = 0; i < ErgonomicsDataType_MAX_SIZE; i++) {
+					const ErgonomicsData &data = IsLeftHandErgonomicsDataType(i) ? ergonomics.data_left : ergonomics.data_right;
+					message.values[i] = data.data[i];
+				}
+			});
+	}
+
+	/// @brief Converts the hand trackers of a frame to the human frame, in one batch per hand, and publishes them in
+	/// frame order.
+	void publish_trackers(const TrackerDataCollection& trackers) {
+		// Gather the poses of each hand into its SoA block, remembering where every tracker went.
+		size_t counts[2] = { 0, 0 };
+		for (size_t i = 0; i < trackers.trackerData.size(); ++i) {
+			const TrackerData &data = trackers.trackerData[i];
+			tracker_sides_[i] = data.trackerType == TrackerType_RightHand ? 1 : data.trackerType == TrackerType_LeftHand ? 0 : -1;
+			if (tracker_sides_[i] < 0) {
+				continue;
+			}
+			TrackerPoseStorage &block = tracker_input_[tracker_sides_[i]];
+			const size_t slot = tracker_slots_[i] = counts[tracker_sides_[i]]++;
+			block.x[slot] = data.position.x;
+			block.y[slot] = data.position.y;
+			block.z[slot] = data.position.z;
+			block.qx[slot] = data.rotation.x;
+			block.qy[slot] = data.rotation.y;
+			block.qz[slot] = data.rotation.z;
+			block.qw[slot] = data.rotation.w;
+		}
+
+		// Trackers keep their filter and prediction state by order of appearance per hand, which restarts when that
+		// order may have changed.
+		const double horizon_s = tracker_prediction_s_.load(std::memory_order_relaxed);
+		for (int side = 0; side < 2; side++) {
+			if (!tracker_filters_[side].IsEnabled() && horizon_s <= 0.0) {
+				tracker_predicting_[side] = false;
+				continue;
+			}
+			const int64_t start_ns = FrameSignal::SteadyNowNs();
+			if (counts[side] != filter_tracker_counts_[side]) {
+				tracker_filters_[side].Reset(0, MAX_NUMBER_OF_TRACKERS);
+				tracker_predictors_[side].Reset(0, MAX_NUMBER_OF_TRACKERS);
+				filter_tracker_counts_[side] = counts[side];
+			}
+			const TrackerPoseArrays block = tracker_input_[side].arrays();
+			double* const components[7] = { block.x, block.y, block.z, block.qx, block.qy, block.qz, block.qw };
+			tracker_filters_[side].Process(components, counts[side], frame_sample_ns_);
+			if (horizon_s > 0.0) {
+				if (!tracker_predicting_[side]) {
+					tracker_predictors_[side].Reset(0, MAX_NUMBER_OF_TRACKERS);
+					tracker_predicting_[side] = true;
+				}
+				tracker_predictors_[side].Process(components, counts[side], frame_sample_ns_, horizon_s, tracker_prediction_stats_);
+			} else {
+				tracker_predicting_[side] = false;
+			}
+			frame_filter_ns_ += FrameSignal::SteadyNowNs() - start_ns;
+		}
+
+		for (int side = 0; side < 2; side++) {
+			trackers_to_human_batch(tracker_input_[side].arrays(), tracker_output_[side].arrays(), counts[side], side == 1);
+			if (tracker_histories_[side].IsConfigured()) {
+				const TrackerPoseArrays block = tracker_output_[side].arrays();
+				const double* const components[7] = { block.x, block.y, block.z, block.qx, block.qy, block.qz, block.qw };
+				const uint32_t key = (uint32_t)counts[side];
+				tracker_histories_[side].Push(components, counts[side], &key,
+					frame_local_ns_ + (tracker_predicting_[side] ? (int64_t)(horizon_s * 1e9) : 0));
+			}
+		}
+
+		for (size_t i = 0; i < trackers.trackerData.size(); ++i) {
+			if (tracker_sides_[i] < 0) {
+				continue;
+			}
+			const TrackerPoseStorage &block = tracker_output_[tracker_sides_[i]];
+			const size_t slot = tracker_slots_[i];
+			// geometry_msgs/Pose is fixed-size already, so it can be loaned as is.
+			publish_fixed(tracker_sides_[i] == 1 ? manus_rightTrackerData_publisher_ : manus_leftTrackerData_publisher_,
+				[&block, slot](geometry_msgs::msg::Pose& pose) {
+					pose.position.x = block.x[slot];
+					pose.position.y = block.y[slot];
+					pose.position.z = block.z[slot];
+					pose.orientation.x = block.qx[slot];
+					pose.orientation.y = block.qy[slot];
+					pose.orientation.z = block.qz[slot];
+					pose.orientation.w = block.qw[slot];
+				});
+		}
+	}
+
+	/// @brief Publishes a variable-size message the publishing thread keeps and rewrites every frame.
+	/// Without intra-process communication it is published by reference and stays in place, so publishing does not
+	/// allocate once its storage has grown. With it, the message is moved into a unique_ptr that the subscribers in the
+	/// same process take over, rather than rclcpp deep-copying it for them, and the persistent message starts over
+	/// from its constant fields.
+	/// @param timed Adds the publish call to the publish stage of the current frame, from the publishing thread only.
+	template <typename MessageT>
+	void publish_persistent(const std::shared_ptr<rclcpp::Publisher<MessageT>>& publisher, MessageT& message, bool timed = true) {
+		if (intra_process_) {
+			auto owned = std::make_unique<MessageT>(std::move(message));
+			restore_persistent(message, *owned);
+			if (timed) {
+				timed_publish([&]() { publisher->publish(std::move(owned)); });
+			} else {
+				publisher->publish(std::move(owned));
+			}
+		} else if (timed) {
+			timed_publish([&]() { publisher->publish(message); });
+		} else {
+			publisher->publish(message);
+		}
+	}
+
+	/// @brief Gives a persistent message that was handed over the fields and storage the next frame expects.
+	static void restore_persistent(geometry_msgs::msg::PoseArray& message, const geometry_msgs::msg::PoseArray& published) {
+		message.header.frame_id = published.header.frame_id;
+		message.poses.reserve(published.poses.capacity());
+	}
+
+	/// The ergonomics message is the only JointState published this way, its names come from the shared table rather
+	/// than from the message handed over.
+	static void restore_persistent(sensor_msgs::msg::JointState& message, const sensor_msgs::msg::JointState& published) {
+		message.header.frame_id = published.header.frame_id;
+		message.name = ergonomics_joint_names();
+		message.position.resize(published.position.size());
+	}
+
+	/// @brief The joint names of the ergonomics JointState, converted from c_ErgonomicsDataTypeNames once.
+	static const std::vector<std::string>& ergonomics_joint_names() {
+		static const std::vector<std::string> names(std::begin(c_ErgonomicsDataTypeNames), std::end(c_ErgonomicsDataTypeNames));
+		return names;
+	}
+
+	/// @brief Publishes a bounded message through a middleware loan, so shared memory transports can skip serialization.
+	/// With intra-process communication the message is filled in a unique_ptr instead and handed over, so subscribers
+	/// in the same process receive it without a copy. Falls back to publishing a copy for middleware that cannot loan.
+	/// The fill function must set every field, as loaned memory is not guaranteed to be initialized.
+	/// @param timed Adds the publish call to the publish stage of the current frame, from the publishing thread only.
+	template <typename MessageT, typename FillT>
+	void publish_fixed(const std::shared_ptr<rclcpp::Publisher<MessageT>>& publisher, FillT&& fill, bool timed = true) {
+		if (intra_process_) {
+			// Loans only cover the inter-process path, the intra-process manager needs a message it can own.
+			auto message = std::make_unique<MessageT>();
+			fill(*message);
+			if (timed) {
+				timed_publish([&]() { publisher->publish(std::move(message)); });
+			} else {
+				publisher->publish(std::move(message));
+			}
+		} else if (publisher->can_loan_messages()) {
+			auto loaned = publisher->borrow_loaned_message();
+			fill(loaned.get());
+			if (timed) {
+				timed_publish([&]() { publisher->publish(std::move(loaned)); });
+			} else {
+				publisher->publish(std::move(loaned));
+			}
+		} else {
+			MessageT message;
+			fill(message);
+			if (timed) {
+				timed_publish([&]() { publisher->publish(message); });
+			} else {
+				publisher->publish(message);
+			}
+		}
+	}
+
+	double resample_rate_hz() const { return resample_rate_hz_; }
+	ResampleStats& resample_stats() { return resample_stats_; }
+
+	/// @brief Publishes the resampled hands and trackers at resample_rate_hz until keep_running returns false. Runs on
+	/// its own thread, so the schedule does not depend on when frames arrive.
+	template <typename KeepRunningT>
+	void run_resampler(KeepRunningT&& keep_running) {
+		PeriodicSchedule schedule;
+		schedule.Start((int64_t)(1e9 / resample_rate_hz_));
+		// Sample times are evenly spaced on the wall clock the frames are stamped with, anchored once to the monotonic
+		// clock the schedule runs on.
+		const int64_t wall_offset_ns = SystemNowNs() - PeriodicSchedule::MonotonicNowNs();
+		while (keep_running()) {
+			int64_t late_ns = 0;
+			const uint64_t skipped = schedule.WaitNext(late_ns);
+			const bool held = publish_resampled(schedule.TickNs() + wall_offset_ns - resample_delay_ns_);
+			resample_stats_.Record(late_ns, skipped, held);
+		}
+	}
+
+	/// @brief Publishes the hands and trackers interpolated at sample_ns, stamped with it.
+	/// @return Whether any stream had no frame past sample_ns yet, so older poses were repeated.
+	bool publish_resampled(int64_t sample_ns) {
+		const builtin_interfaces::msg::Time stamp = rclcpp::Time(sample_ns);
+		bool held = false;
+		bool stream_held = false;
+		const size_t node_count = skeleton_history_.Sample(sample_ns, resample_interpolation_, resample_skeleton_components_,
+			resample_sample_keys_.data(), stream_held);
+		held |= stream_held;
+		for (size_t hand = 0; hand < node_count / c_HandNodeCount; hand++) {
+			if (resample_sample_keys_[hand] == PoseHistory::c_Absent) {
+				continue;
+			}
+			const UserHandPublishers* hands = user_publishers((uint32_t)(hand / 2));
+			if (hands == nullptr) {
+				continue;
+			}
+			const uint32_t skeleton_id = resample_sample_keys_[hand];
+			const size_t first = hand * c_HandNodeCount;
+			double* const* components = resample_skeleton_components_;
+			publish_fixed(hand % 2 == 1 ? hands->right_resampled : hands->left_resampled,
+				[&stamp, skeleton_id, first, components](manus_ros2::msg::ManusHandState& message) {
+					message.stamp = stamp;
+					message.skeleton_id = skeleton_id;
+					message.node_count = (uint8_t)c_HandNodeCount;
+					for (size_t j = 0; j < c_HandNodeCount; ++j) {
+						for (size_t c = 0; c < 3; c++) {
+							message.positions[j * 3 + c] = (float)components[c][first + j];
+						}
+						for (size_t c = 0; c < 4; c++) {
+							message.rotations[j * 4 + c] = (float)components[3 + c][first + j];
+						}
+					}
+				}, false);
+		}
+
+		for (int side = 0; side < 2; side++) {
+			const TrackerPoseArrays block = resample_trackers_[side].arrays();
+			double* const components[7] = { block.x, block.y, block.z, block.qx, block.qy, block.qz, block.qw };
+			uint32_t key = 0;
+			const size_t count = tracker_histories_[side].Sample(sample_ns, resample_interpolation_, components, &key, stream_held);
+			held |= stream_held;
+			if (count == 0) {
+				continue;
+			}
+			geometry_msgs::msg::PoseArray& message = resample_tracker_messages_[side];
+			message.header.stamp = stamp;
+			// Stays within the reserved storage, so this only moves the end.
+			message.poses.resize(count);
+			for (size_t i = 0; i < count; i++) {
+				geometry_msgs::msg::Pose& pose = message.poses[i];
+				pose.position.x = block.x[i];
+				pose.position.y = block.y[i];
+				pose.position.z = block.z[i];
+				pose.orientation.x = block.qx[i];
+				pose.orientation.y = block.qy[i];
+				pose.orientation.z = block.qz[i];
+				pose.orientation.w = block.qw[i];
+			}
+			publish_persistent(side == 1 ? manus_tracker_right_resampled_publisher_ : manus_tracker_left_resampled_publisher_, message, false);
+		}
+		return held;
+	}
+
+	/// @brief Transforms for the nodes of a hand with their frame IDs set: the root is the hand frame under the TF parent
+	/// frame, every joint is <hand frame>_<joint> under its parent node.
+	std::vector<geometry_msgs::msg::TransformStamped> hand_transforms(const std::string& hand_frame) const {
+		std::vector<geometry_msgs::msg::TransformStamped> transforms(c_HandNodeCount);
+		for (uint32_t id = 0; id < c_HandNodeCount; id++) {
+			transforms[id].header.frame_id = id == 0 ? tf_parent_frame_ : hand_node_frame(hand_frame, HandNodeParentID(id));
+			transforms[id].child_frame_id = hand_node_frame(hand_frame, id);
+		}
+		return transforms;
+	}
+
+	/// @brief Static transforms of the bind pose the skeleton was set up with, as <hand frame>_bind_<joint> frames
+	/// hanging off the live hand frame, to compare the tracked fingers against.
+	std::vector<geometry_msgs::msg::TransformStamped> hand_bind_transforms(const std::string& hand_frame, const ManusVec3* positions) {
+		std::vector<geometry_msgs::msg::TransformStamped> transforms(c_HandNodeCount - 1);
+		for (uint32_t id = 1; id < c_HandNodeCount; id++) {
+			const uint32_t parent_id = HandNodeParentID(id);
+			geometry_msgs::msg::TransformStamped &transform = transforms[id - 1];
+			transform.header.stamp = this->now();
+			transform.header.frame_id = parent_id == 0 ? hand_frame : hand_frame + "_bind_" + c_HandNodeNames[parent_id];
+			transform.child_frame_id = hand_frame + "_bind_" + c_HandNodeNames[id];
+			transform.transform.translation.x = positions[id - 1].x;
+			transform.transform.translation.y = positions[id - 1].y;
+			transform.transform.translation.z = positions[id - 1].z;
+			transform.transform.rotation.w = 1.0;
+		}
+		return transforms;
+	}
+
+	static std::string hand_node_frame(const std::string& hand_frame, uint32_t id) {
+		return id == 0 ? hand_frame : hand_frame + "_" + c_HandNodeNames[id];
+	}
+
+	/// @brief Runs a publish call and adds its duration to the publish stage of the current frame.
+	template <typename PublishT>
+	void timed_publish(PublishT&& publish) {
+		const int64_t start_ns = FrameSignal::SteadyNowNs();
+		publish();
+		frame_publish_ns_ += FrameSignal::SteadyNowNs() - start_ns;
+	}
+
+private:
+	rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr manus_ergonomics_publisher;
+	sensor_msgs::msg::JointState ergonomics_message_; // Publishing thread only.
+	rclcpp::Publisher<geometry_msgs::msg::Pose>::SharedPtr manus_leftTrackerData_publisher_;
+  	rclcpp::Publisher<geometry_msgs::msg::Pose>::SharedPtr manus_rightTrackerData_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusErgonomics>::SharedPtr manus_ergonomics_fixed_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusErgonomicsState>::SharedPtr manus_ergonomics_compact_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusLayout>::SharedPtr manus_layout_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusGestures>::SharedPtr manus_gestures_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusGestureNames>::SharedPtr manus_gesture_names_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusRawSkeleton>::SharedPtr manus_raw_skeleton_publisher_;
+	rclcpp::Publisher<manus_ros2::msg::ManusRawSkeletonLayout>::SharedPtr manus_raw_skeleton_layout_publisher_;
+
+	bool intra_process_ = false;
+	bool legacy_messages_ = true;
+	bool fixed_size_messages_ = false;
+	bool compact_messages_ = false;
+	uint32_t gesture_top_k_ = 0;
+	bool raw_skeletons_ = false;
+
+	// Tracker batches per hand, left at 0 and right at 1. Publishing thread only.
+	TrackerPoseStorage tracker_input_[2];
+	TrackerPoseStorage tracker_output_[2];
+	std::array<int8_t, MAX_NUMBER_OF_TRACKERS> tracker_sides_;
+	std::array<size_t, MAX_NUMBER_OF_TRACKERS> tracker_slots_;
+	bool multi_user_ = false;
+
+	// Filter stage, publishing thread only. Skeleton nodes are indexed by hand (user slot * 2 + side) * node count.
+	static constexpr size_t c_FilterHandCount = 2 * SDKMinimalClient::c_MaxUsers;
+	SignalFilterBank skeleton_filter_;
+	std::vector<double> filter_skeleton_values_;
+	double* filter_skeleton_components_[7] = {};
+	std::array<size_t, MAX_NUMBER_OF_SKELETONS> filter_skeleton_hands_{};
+	std::array<uint32_t, c_FilterHandCount> filter_hand_skeleton_ids_{};
+	std::array<bool, c_FilterHandCount> filter_hand_present_{};
+	SignalFilterBank ergonomics_filter_;
+	std::array<double, ErgonomicsDataType_MAX_SIZE> filter_ergonomics_values_{};
+	SignalFilterBank tracker_filters_[2];
+	size_t filter_tracker_counts_[2] = { 0, 0 };
+	// Look-aheads in seconds, set by the parameter callback and read by the publishing thread.
+	std::atomic<double> skeleton_prediction_s_{0.0};
+	std::atomic<double> tracker_prediction_s_{0.0};
+	PosePredictor skeleton_predictor_;
+	PosePredictor tracker_predictors_[2];
+	bool skeleton_predicting_ = false;
+	bool tracker_predicting_[2] = { false, false };
+	PredictionErrorStats skeleton_prediction_stats_;
+	PredictionErrorStats tracker_prediction_stats_;
+	rclcpp::Publisher<manus_ros2::msg::PredictionStats>::SharedPtr manus_prediction_stats_publisher_;
+	rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr prediction_parameters_callback_;
+	// Sample time of the current frame: its Core publish time, or its receive time if that cannot be decoded.
+	int64_t frame_sample_ns_ = 0;
+	// The same time on the local wall clock, as the frame is stamped when the clock estimate is valid.
+	int64_t frame_local_ns_ = 0;
+
+	// Resampling. The histories are pushed by the publishing thread, the rest belongs to the resampling thread.
+	double resample_rate_hz_ = 0.0;
+	int64_t resample_delay_ns_ = 0;
+	ResampleInterpolation resample_interpolation_ = ResampleInterpolation::Hermite;
+	PoseHistory skeleton_history_;
+	PoseHistory tracker_histories_[2];
+	std::array<uint32_t, c_FilterHandCount> resample_hand_keys_{};
+	std::vector<double> resample_skeleton_values_;
+	double* resample_skeleton_components_[7] = {};
+	std::array<uint32_t, c_FilterHandCount> resample_sample_keys_{};
+	TrackerPoseStorage resample_trackers_[2];
+	geometry_msgs::msg::PoseArray resample_tracker_messages_[2];
+	rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr manus_tracker_left_resampled_publisher_;
+	rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr manus_tracker_right_resampled_publisher_;
+	ResampleStats resample_stats_;
+
+	bool publish_tf_ = false;
+	std::string tf_parent_frame_;
+	std::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
+	std::shared_ptr<tf2_ros::StaticTransformBroadcaster> tf_static_broadcaster_;
+	// The batch of the current frame, publishing thread only. Keeps the size of the last frame, so a steady frame
+	// reuses every entry and the storage of its frame IDs.
+	std::vector<geometry_msgs::msg::TransformStamped> tf_frame_transforms_;
+	size_t tf_frame_count_ = 0;
+
+	// Indexed by client user slot. Set once per slot and never freed while the node lives, so the publishing thread
+	// can use them without locking.
+	std::array<std::atomic<UserHandPublishers*>, SDKMinimalClient::c_MaxUsers> user_publishers_{};
+	std::vector<std::unique_ptr<UserHandPublishers>> user_publisher_storage_;
+
+	// Only touched from the publishing thread; the atomics below mirror it for the monitoring timer.
+	ClockOffsetEstimator clock_estimator_;
+	bool use_core_timestamps_ = true;
+	bool sdk_timestamps_ = true;
+	std::atomic<int64_t> clock_raw_offset_ns_{0};
+	std::atomic<double> clock_offset_ns_{0.0};
+	std::atomic<double> clock_skew_ppm_{0.0};
+	std::atomic<uint64_t> clock_sample_count_{0};
+	rclcpp::Publisher<manus_ros2::msg::ClockSync>::SharedPtr manus_clock_sync_publisher_;
+	rclcpp::TimerBase::SharedPtr clock_sync_timer_;
+
+	// Histograms are recorded from the publishing thread and drained by the stats timer.
+	PipelineLatency latency_;
+	int64_t frame_filter_ns_ = 0;
+	int64_t frame_publish_ns_ = 0;
+	rclcpp::Publisher<manus_ros2::msg::LatencyStats>::SharedPtr manus_latency_stats_publisher_;
+	rclcpp::TimerBase::SharedPtr latency_stats_timer_;
+};
+
+
+/// @brief Publishes the current skeletons of the client, one message per hand, on the topics of the hand's user.
+void convertSkeletonDataToROS(ManusROS2Publisher& publisher);
+
+/// @brief Publishes the current ergonomics of the client for both hands.
+void convertErgonomicsDataToROS(ManusROS2Publisher& publisher);
+
+/// @brief Publishes the current hand tracker poses of the client.
+void convertTrackerDataToROS(ManusROS2Publisher& publisher);
+
+/// @brief Publishes the current most probable gestures of the client, one message per glove.
+void convertGestureDataToROS(ManusROS2Publisher& publisher);
+
+/// @brief Publishes the current raw skeletons of the client, one message per glove.
+void convertRawSkeletonDataToROS(ManusROS2Publisher& publisher);
+
+/// @brief Swaps in the latest frames from the SDK and republishes them, recording how long they waited.
+void publishPendingFrames(SDKMinimalClient& client, ManusROS2Publisher& publisher, FrameHandoffStats& stats);
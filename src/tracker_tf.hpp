@@ -1,24 +1,28 @@
 // Header-only utility functions to convert tracker coordinates to human coordinates
 
+#pragma once
+
 #include <iostream>
 #include <cmath>
 #include <array>
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Geometry>
 
+using Eigen::Map;
+using Eigen::Matrix4d;
 using Eigen::Quaterniond;
 using Eigen::Vector3d;
 using Eigen::Vector4d;
 using Eigen::AngleAxisd;
 
 
-Vector3d tracker_xyz_to_human_xyz(const Vector3d& tracker_xyz) {
+inline Vector3d tracker_xyz_to_human_xyz(const Vector3d& tracker_xyz) {
     Vector3d human_xyz;
     human_xyz << -tracker_xyz[0], -tracker_xyz[1], tracker_xyz[2];
     return human_xyz;
 }
 
-Quaterniond tracker_quat_to_human_rotation(const Vector4d& tracker_quat, bool is_right_hand) {
+inline Quaterniond tracker_quat_to_human_rotation(const Vector4d& tracker_quat, bool is_right_hand) {
     static bool initialized = false;
     static Vector4d SIGNS;
     static Vector4d Q0;
@@ -42,3 +46,65 @@ Quaterniond tracker_quat_to_human_rotation(const Vector4d& tracker_quat, bool is
 
     return rot;
 }
+
+
+// Precomposed tracker_quat_to_human_rotation() for one side. The sign flip, R0_INV and the z rotation are all linear
+// in the tracker quaternion, so together they are one 4x4 matrix on its xyzw coefficients, built once from the
+// function itself.
+inline const Matrix4d& tracker_quat_to_human_matrix(bool is_right_hand) {
+    static const std::array<Matrix4d, 2> matrices = []() {
+        std::array<Matrix4d, 2> sides;
+        for (int side = 0; side < 2; side++) {
+            for (int i = 0; i < 4; i++) {
+                sides[side].col(i) = tracker_quat_to_human_rotation(Vector4d::Unit(i), side == 1).coeffs();
+            }
+        }
+        return sides;
+    }();
+    return matrices[is_right_hand ? 1 : 0];
+}
+
+// A block of tracker poses in structure of arrays layout, one array per coefficient.
+struct TrackerPoseArrays {
+    double* x;
+    double* y;
+    double* z;
+    double* qx;
+    double* qy;
+    double* qz;
+    double* qw;
+};
+
+// tracker_xyz_to_human_xyz() and tracker_quat_to_human_rotation() for count poses of one hand at once.
+// Poses are processed in blocks of 4 as fixed-size Eigen arrays, which Eigen maps onto SIMD packets and inlines even
+// without aggressive optimization, with the remainder done one by one. in and out must not overlap.
+inline void trackers_to_human_batch(const TrackerPoseArrays& in, const TrackerPoseArrays& out, size_t count, bool is_right_hand) {
+    using Eigen::Array4d;
+    const Matrix4d& m = tracker_quat_to_human_matrix(is_right_hand);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Map<Array4d>(out.x + i) = -Map<const Array4d>(in.x + i);
+        Map<Array4d>(out.y + i) = -Map<const Array4d>(in.y + i);
+        Map<Array4d>(out.z + i) = Map<const Array4d>(in.z + i);
+
+        const Array4d qx = Map<const Array4d>(in.qx + i);
+        const Array4d qy = Map<const Array4d>(in.qy + i);
+        const Array4d qz = Map<const Array4d>(in.qz + i);
+        const Array4d qw = Map<const Array4d>(in.qw + i);
+        Map<Array4d>(out.qx + i) = m(0, 0) * qx + m(0, 1) * qy + m(0, 2) * qz + m(0, 3) * qw;
+        Map<Array4d>(out.qy + i) = m(1, 0) * qx + m(1, 1) * qy + m(1, 2) * qz + m(1, 3) * qw;
+        Map<Array4d>(out.qz + i) = m(2, 0) * qx + m(2, 1) * qy + m(2, 2) * qz + m(2, 3) * qw;
+        Map<Array4d>(out.qw + i) = m(3, 0) * qx + m(3, 1) * qy + m(3, 2) * qz + m(3, 3) * qw;
+    }
+    for (; i < count; i++) {
+        out.x[i] = -in.x[i];
+        out.y[i] = -in.y[i];
+        out.z[i] = in.z[i];
+        const Vector4d q = m * Vector4d(in.qx[i], in.qy[i], in.qz[i], in.qw[i]);
+        out.qx[i] = q[0];
+        out.qy[i] = q[1];
+        out.qz[i] = q[2];
+        out.qw[i] = q[3];
+    }
+}
@@ -0,0 +1,98 @@
+/// @file test_manus_clock.cpp
+/// @brief Tests the Core to local clock mapping against a simulated stream with transport jitter, skew and clock steps.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "ManusClock.hpp"
+
+
+namespace
+{
+constexpr int64_t c_FramePeriodNs = 1000000000LL / 90;
+constexpr int64_t c_StartNs = 1700000000LL * 1000000000LL;
+
+/// @brief A Core host streaming at 90 Hz to a local clock that runs 5 s ahead, drifts by 20 ppm and may be stepped.
+struct SimulatedLink
+{
+	std::mt19937 random{ 42 };
+	// Transport delay, the lowest delay is what the estimator converges to.
+	std::uniform_int_distribution<int64_t> delayNs{ 500000, 3000000 };
+	int64_t remoteNs = c_StartNs;
+	int64_t stepNs = 0;
+
+	int64_t TrueOffsetNs() const
+	{
+		return 5000000000LL + (int64_t)((double)(remoteNs - c_StartNs) * 20e-6) + stepNs;
+	}
+
+	/// @brief Feeds the next frame, then returns the error of its stamp against the true offset plus the lowest delay.
+	double Step(ClockOffsetEstimator& p_Estimator)
+	{
+		remoteNs += c_FramePeriodNs;
+		p_Estimator.AddSample(remoteNs, remoteNs + TrueOffsetNs() + delayNs(random));
+		return (double)(p_Estimator.ToLocalNs(remoteNs) - (remoteNs + TrueOffsetNs() + delayNs.min()));
+	}
+
+	/// @brief Runs for a duration and returns the largest stamp error over it.
+	double Run(ClockOffsetEstimator& p_Estimator, double p_Seconds)
+	{
+		double t_MaxErrorNs = 0.0;
+		for (int64_t i = 0; i < (int64_t)(p_Seconds * 90.0); i++)
+		{
+			t_MaxErrorNs = std::max(t_MaxErrorNs, std::fabs(Step(p_Estimator)));
+		}
+		return t_MaxErrorNs;
+	}
+};
+
+constexpr double c_ToleranceNs = 2000000.0;
+}
+
+
+TEST(ClockOffsetEstimator, TracksOffsetAndSkew)
+{
+	ClockOffsetEstimator t_Estimator;
+	SimulatedLink t_Link;
+	t_Link.Run(t_Estimator, 10.0);
+	EXPECT_LT(t_Link.Run(t_Estimator, 60.0), c_ToleranceNs);
+	EXPECT_NEAR(t_Estimator.SkewPpm(), 20.0, 2.0);
+}
+
+TEST(ClockOffsetEstimator, RecoversFromBackwardStep)
+{
+	ClockOffsetEstimator t_Estimator;
+	SimulatedLink t_Link;
+	t_Link.Run(t_Estimator, 30.0);
+	t_Link.stepNs = -200000000LL;
+	// Restarts on the first sample below the fit, and is settled once its first window closed.
+	t_Link.Run(t_Estimator, 1.5);
+	EXPECT_LT(t_Link.Run(t_Estimator, 60.0), c_ToleranceNs);
+}
+
+TEST(ClockOffsetEstimator, RecoversFromForwardStep)
+{
+	ClockOffsetEstimator t_Estimator;
+	SimulatedLink t_Link;
+	t_Link.Run(t_Estimator, 30.0);
+	t_Link.stepNs = 200000000LL;
+	// Restarts once a whole window stayed above the fit, without overshooting afterwards.
+	t_Link.Run(t_Estimator, 2.5);
+	EXPECT_LT(t_Link.Run(t_Estimator, 60.0), c_ToleranceNs);
+}
+
+TEST(ClockOffsetEstimator, KeepsFitThroughDelaySpikes)
+{
+	ClockOffsetEstimator t_Estimator;
+	SimulatedLink t_Link;
+	t_Link.Run(t_Estimator, 30.0);
+	// A congested link delays frames for half a second, which is not a clock step.
+	t_Link.delayNs = std::uniform_int_distribution<int64_t>(150000000, 160000000);
+	t_Link.Run(t_Estimator, 0.5);
+	t_Link.delayNs = std::uniform_int_distribution<int64_t>(500000, 3000000);
+	EXPECT_LT(t_Link.Run(t_Estimator, 30.0), c_ToleranceNs);
+}
@@ -0,0 +1,223 @@
+/// @file test_motion_predictor.cpp
+/// @brief Tests PosePredictor on poses moving at constant linear and angular velocity, and which of its predictions
+/// PredictionErrorStats counts.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+
+#include "MotionPredictor.hpp"
+
+
+namespace
+{
+constexpr int64_t c_StartNs = 1000000000LL;
+constexpr int64_t c_PeriodNs = 10000000LL; // 100 Hz
+constexpr double c_HorizonS = 0.05;
+// Not a multiple of the lanes, so the last block is partly padding.
+constexpr size_t c_Count = 6;
+
+/// @brief Elements moving at their own constant linear and angular velocity, the rotation in the world frame.
+class ConstantMotion
+{
+public:
+	ConstantMotion()
+	{
+		for (size_t i = 0; i < c_Count; i++)
+		{
+			const double t_I = (double)i;
+			m_Position.push_back(Eigen::Vector3d(0.1 * t_I, -0.2, 1.0 + 0.05 * t_I));
+			m_Linear.push_back(Eigen::Vector3d(0.3 - 0.1 * t_I, 0.05 * t_I, -0.2));
+			m_Rotation.push_back(Eigen::Quaterniond(Eigen::AngleAxisd(0.4 * t_I, Eigen::Vector3d(1.0, t_I, 0.5).normalized())));
+			// Up to about 3 rad/s, quick for a finger joint.
+			m_Angular.push_back(Eigen::Vector3d(1.0 + 0.2 * t_I, -0.5 * t_I, 0.8));
+		}
+		for (std::vector<double>& t_Component : m_Poses) t_Component.assign(8, 0.0);
+		for (size_t c = 0; c < 7; c++) m_Pointers[c] = m_Poses[c].data();
+	}
+
+	Eigen::Vector3d PositionAt(size_t p_Element, double p_TimeS) const
+	{
+		return m_Position[p_Element] + m_Linear[p_Element] * p_TimeS;
+	}
+
+	Eigen::Quaterniond RotationAt(size_t p_Element, double p_TimeS) const
+	{
+		const Eigen::Vector3d t_Rotation = m_Angular[p_Element] * p_TimeS;
+		const Eigen::Quaterniond t_Delta(Eigen::AngleAxisd(t_Rotation.norm(), t_Rotation.normalized()));
+		return t_Delta * m_Rotation[p_Element];
+	}
+
+	/// @brief Fills the component arrays with the poses at a frame.
+	double* const* Frame(int p_Frame)
+	{
+		const double t_TimeS = (double)p_Frame * (double)c_PeriodNs * 1e-9;
+		for (size_t i = 0; i < c_Count; i++)
+		{
+			const Eigen::Vector3d t_P = PositionAt(i, t_TimeS);
+			const Eigen::Quaterniond t_Q = RotationAt(i, t_TimeS);
+			const double t_Pose[7] = { t_P.x(), t_P.y(), t_P.z(), t_Q.x(), t_Q.y(), t_Q.z(), t_Q.w() };
+			for (size_t c = 0; c < 7; c++) m_Poses[c][i] = t_Pose[c];
+		}
+		return m_Pointers;
+	}
+
+	double Pose(size_t p_Component, size_t p_Element) const { return m_Poses[p_Component][p_Element]; }
+
+private:
+	std::vector<Eigen::Vector3d> m_Position, m_Linear, m_Angular;
+	std::vector<Eigen::Quaterniond> m_Rotation;
+	std::vector<double> m_Poses[7];
+	double* m_Pointers[7];
+};
+
+int64_t FrameTimeNs(int p_Frame)
+{
+	return c_StartNs + (int64_t)p_Frame * c_PeriodNs;
+}
+}
+
+
+TEST(PosePredictor, PredictsConstantVelocity)
+{
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(c_Count, 15.0);
+	PredictionErrorStats t_Stats;
+	ConstantMotion t_Motion;
+
+	for (int t_Frame = 0; t_Frame < 100; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+		// The filtered velocities start at rest and have converged well within half a second.
+		if (t_Frame < 50) continue;
+
+		const double t_TargetS = (double)t_Frame * (double)c_PeriodNs * 1e-9 + c_HorizonS;
+		for (size_t i = 0; i < c_Count; i++)
+		{
+			const Eigen::Vector3d t_Position = t_Motion.PositionAt(i, t_TargetS);
+			for (size_t c = 0; c < 3; c++)
+			{
+				EXPECT_NEAR(t_Motion.Pose(c, i), t_Position[c], 1e-6) << "frame " << t_Frame << " element " << i;
+			}
+			const Eigen::Quaterniond t_Predicted(t_Motion.Pose(6, i), t_Motion.Pose(3, i), t_Motion.Pose(4, i), t_Motion.Pose(5, i));
+			EXPECT_NEAR(t_Predicted.norm(), 1.0, 1e-9);
+			EXPECT_LT(t_Predicted.angularDistance(t_Motion.RotationAt(i, t_TargetS)), 1e-6) << "frame " << t_Frame << " element " << i;
+		}
+	}
+}
+
+TEST(PosePredictor, ZeroHorizonLeavesPosesUnchanged)
+{
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(c_Count, 15.0);
+	PredictionErrorStats t_Stats;
+	ConstantMotion t_Motion;
+	for (int t_Frame = 0; t_Frame < 10; t_Frame++)
+	{
+		double* const* t_Poses = t_Motion.Frame(t_Frame);
+		std::vector<double> t_Before[7];
+		for (size_t c = 0; c < 7; c++) t_Before[c].assign(t_Poses[c], t_Poses[c] + c_Count);
+		t_Predictor.Process(t_Poses, c_Count, FrameTimeNs(t_Frame), 0.0, t_Stats);
+		for (size_t c = 0; c < 7; c++)
+		{
+			for (size_t i = 0; i < c_Count; i++) EXPECT_EQ(t_Motion.Pose(c, i), t_Before[c][i]);
+		}
+	}
+	EXPECT_EQ(t_Stats.TakeWindow().count, 0u);
+}
+
+TEST(PosePredictor, MeasuresEachPredictionAtItsTargetFrame)
+{
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(c_Count, 15.0);
+	PredictionErrorStats t_Stats;
+	ConstantMotion t_Motion;
+	for (int t_Frame = 0; t_Frame < 60; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+	}
+	t_Stats.TakeWindow();
+
+	// Each frame measures the prediction made five frames earlier, for the elements only and not the padding.
+	for (int t_Frame = 60; t_Frame < 80; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+	}
+	const PredictionErrorStats::Summary t_Summary = t_Stats.TakeWindow();
+	EXPECT_EQ(t_Summary.count, 20u * c_Count);
+	// The kept frames are stored as float.
+	EXPECT_LT(t_Summary.positionMax, 1e-5);
+	EXPECT_LT(t_Summary.rotationMax, 1e-5);
+	EXPECT_LE(t_Summary.positionMean, t_Summary.positionMax);
+	EXPECT_LE(t_Summary.rotationMean, t_Summary.rotationMax);
+}
+
+TEST(PosePredictor, SkipsPredictionsOfRestartedElements)
+{
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(c_Count, 15.0);
+	PredictionErrorStats t_Stats;
+	ConstantMotion t_Motion;
+	for (int t_Frame = 0; t_Frame < 60; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+	}
+	t_Stats.TakeWindow();
+
+	// The predictions kept up to and including the restart frame are not measured for the restarted elements.
+	t_Predictor.Reset(0, 2);
+	for (int t_Frame = 60; t_Frame < 66; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+	}
+	EXPECT_EQ(t_Stats.TakeWindow().count, 6u * (c_Count - 2));
+	t_Predictor.Process(t_Motion.Frame(66), c_Count, FrameTimeNs(66), c_HorizonS, t_Stats);
+	EXPECT_EQ(t_Stats.TakeWindow().count, c_Count);
+}
+
+TEST(PosePredictor, GapDropsPendingPredictions)
+{
+	PosePredictor t_Predictor;
+	t_Predictor.Configure(c_Count, 15.0);
+	PredictionErrorStats t_Stats;
+	ConstantMotion t_Motion;
+	for (int t_Frame = 0; t_Frame < 20; t_Frame++)
+	{
+		t_Predictor.Process(t_Motion.Frame(t_Frame), c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+	}
+	t_Stats.TakeWindow();
+
+	// Past the gap every element restarts, nothing kept before it is measured and the first pose is not moved.
+	const int t_Resume = 20 + (int)(PosePredictor::c_MaxGapS * 1e9 / (double)c_PeriodNs) + 5;
+	for (int t_Frame = t_Resume; t_Frame < t_Resume + 5; t_Frame++)
+	{
+		double* const* t_Poses = t_Motion.Frame(t_Frame);
+		const double t_X = t_Poses[0][0];
+		t_Predictor.Process(t_Poses, c_Count, FrameTimeNs(t_Frame), c_HorizonS, t_Stats);
+		if (t_Frame == t_Resume)
+		{
+			EXPECT_EQ(t_Motion.Pose(0, 0), t_X);
+		}
+	}
+	EXPECT_EQ(t_Stats.TakeWindow().count, 0u);
+}
+
+TEST(PredictionErrorStats, SummarizesAndClearsTheWindow)
+{
+	PredictionErrorStats t_Stats;
+	t_Stats.RecordFrame(0, 1.0, 1.0, 1.0, 1.0);
+	t_Stats.RecordFrame(2, 0.002, 0.0015, 0.02, 0.012);
+	t_Stats.RecordFrame(2, 0.004, 0.003, 0.01, 0.006);
+	const PredictionErrorStats::Summary t_Summary = t_Stats.TakeWindow();
+	EXPECT_EQ(t_Summary.count, 4u);
+	EXPECT_NEAR(t_Summary.positionMean, 0.0015, 1e-9);
+	EXPECT_NEAR(t_Summary.positionMax, 0.003, 1e-9);
+	EXPECT_NEAR(t_Summary.rotationMean, 0.0075, 1e-9);
+	EXPECT_NEAR(t_Summary.rotationMax, 0.012, 1e-9);
+	EXPECT_EQ(t_Stats.TakeWindow().count, 0u);
+}
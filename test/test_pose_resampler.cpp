@@ -0,0 +1,262 @@
+/// @file test_pose_resampler.cpp
+/// @brief Tests PoseHistory sampling: linear and Hermite positions on unevenly spaced frames, the fallbacks to the
+/// nearest frame for group key changes and gaps, and times outside the history.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "PoseResampler.hpp"
+
+
+namespace
+{
+constexpr int64_t c_MsNs = 1000000LL;
+constexpr int64_t c_StartNs = 1000000000LL;
+
+/// @brief Seven component arrays of a fixed size, for pushing or sampling poses.
+struct Poses
+{
+	explicit Poses(size_t p_Count) : values(7, std::vector<double>(p_Count, 0.0))
+	{
+		for (size_t c = 0; c < 7; c++) pointers[c] = values[c].data();
+		for (size_t i = 0; i < p_Count; i++) values[6][i] = 1.0;
+	}
+
+	std::vector<std::vector<double>> values;
+	double* pointers[7];
+};
+
+/// @brief Pushes a frame whose element i sits at p_X(t) + i along x, with the identity rotation.
+void PushFrame(PoseHistory& p_History, size_t p_Count, const std::vector<uint32_t>& p_Keys, int64_t p_TimeNs, const std::function<double(double)>& p_X)
+{
+	Poses t_Frame(p_Count);
+	const double t_TimeS = (double)(p_TimeNs - c_StartNs) * 1e-9;
+	for (size_t i = 0; i < p_Count; i++) t_Frame.values[0][i] = p_X(t_TimeS) + (double)i;
+	p_History.Push(t_Frame.pointers, p_Count, p_Keys.data(), p_TimeNs);
+}
+
+/// @brief x of element 0 sampled at a time, or NaN when nothing was written.
+double SampleX(PoseHistory& p_History, int64_t p_TimeNs, ResampleInterpolation p_Interpolation)
+{
+	Poses t_Out(4);
+	uint32_t t_Keys[4];
+	bool t_Held;
+	return p_History.Sample(p_TimeNs, p_Interpolation, t_Out.pointers, t_Keys, t_Held) > 0 ? t_Out.values[0][0] : NAN;
+}
+}
+
+
+TEST(PoseHistory, InterpolatesLinearMotionExactlyOnUnevenSpacing)
+{
+	// Catmull-Rom slopes taken across uneven neighbours must be scaled to the interval, or even a straight line bends.
+	const std::function<double(double)> t_Line = [](double p_T) { return 0.5 + 2.0 * p_T; };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	for (int64_t t_Ms : { 0, 5, 20, 28, 50 }) PushFrame(t_History, 1, { 1 }, c_StartNs + t_Ms * c_MsNs, t_Line);
+
+	for (int64_t t_Ms = 0; t_Ms <= 50; t_Ms++)
+	{
+		const double t_Expected = t_Line((double)t_Ms * 1e-3);
+		EXPECT_NEAR(SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Linear), t_Expected, 1e-12) << t_Ms << " ms";
+		EXPECT_NEAR(SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite), t_Expected, 1e-12) << t_Ms << " ms";
+	}
+}
+
+TEST(PoseHistory, HermiteReproducesCurvesOnEvenSpacing)
+{
+	// Catmull-Rom slopes are exact for a parabola when the frames are evenly spaced.
+	const std::function<double(double)> t_Curve = [](double p_T) { return 100.0 * p_T * p_T; };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	for (int64_t t_Ms : { 0, 10, 20, 30 }) PushFrame(t_History, 1, { 1 }, c_StartNs + t_Ms * c_MsNs, t_Curve);
+	for (int64_t t_Ms = 10; t_Ms <= 20; t_Ms++)
+	{
+		EXPECT_NEAR(SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite), t_Curve((double)t_Ms * 1e-3), 1e-12) << t_Ms << " ms";
+	}
+}
+
+TEST(PoseHistory, HermiteScalesSlopesOnUnevenSpacing)
+{
+	const std::function<double(double)> t_Curve = [](double p_T) { return 100.0 * p_T * p_T; };
+	const double t_Times[4] = { 0.0, 0.010, 0.030, 0.040 };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	for (double t_Time : t_Times) PushFrame(t_History, 1, { 1 }, c_StartNs + (int64_t)std::llround(t_Time * 1e9), t_Curve);
+
+	// Between the middle frames, with each slope taken across the neighbours of its frame in units per second.
+	const double t_Dt = t_Times[2] - t_Times[1];
+	const double t_SlopeA = (t_Curve(t_Times[2]) - t_Curve(t_Times[0])) / (t_Times[2] - t_Times[0]);
+	const double t_SlopeB = (t_Curve(t_Times[3]) - t_Curve(t_Times[1])) / (t_Times[3] - t_Times[1]);
+	for (int64_t t_Ms = 10; t_Ms <= 30; t_Ms += 2)
+	{
+		const double t_U = ((double)t_Ms * 1e-3 - t_Times[1]) / t_Dt;
+		const double t_U2 = t_U * t_U, t_U3 = t_U2 * t_U;
+		const double t_Expected = (2.0 * t_U3 - 3.0 * t_U2 + 1.0) * t_Curve(t_Times[1]) + (t_U3 - 2.0 * t_U2 + t_U) * t_Dt * t_SlopeA +
+			(-2.0 * t_U3 + 3.0 * t_U2) * t_Curve(t_Times[2]) + (t_U3 - t_U2) * t_Dt * t_SlopeB;
+		const double t_Hermite = SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite);
+		EXPECT_NEAR(t_Hermite, t_Expected, 1e-12) << t_Ms << " ms";
+
+		// And closer to the curve than straight lines between the frames.
+		const double t_Truth = t_Curve((double)t_Ms * 1e-3);
+		const double t_Linear = SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Linear);
+		EXPECT_LE(std::fabs(t_Hermite - t_Truth), 0.6 * std::fabs(t_Linear - t_Truth) + 1e-12) << t_Ms << " ms";
+	}
+}
+
+TEST(PoseHistory, HermiteWithoutNeighboursIsLinear)
+{
+	const std::function<double(double)> t_Curve = [](double p_T) { return 100.0 * p_T * p_T; };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	PushFrame(t_History, 1, { 1 }, c_StartNs, t_Curve);
+	PushFrame(t_History, 1, { 1 }, c_StartNs + 20 * c_MsNs, t_Curve);
+	for (int64_t t_Ms = 0; t_Ms <= 20; t_Ms += 4)
+	{
+		EXPECT_NEAR(SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite),
+			SampleX(t_History, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Linear), 1e-12);
+	}
+}
+
+TEST(PoseHistory, HermiteIgnoresNeighboursWithAnotherKey)
+{
+	// A neighbour holding another skeleton gives no slope, as if it were not there.
+	const std::function<double(double)> t_Curve = [](double p_T) { return 100.0 * p_T * p_T; };
+	PoseHistory t_Changed, t_Missing;
+	t_Changed.Configure(1, 1);
+	t_Missing.Configure(1, 1);
+	PushFrame(t_Changed, 1, { 2 }, c_StartNs, t_Curve);
+	for (int64_t t_Ms : { 10, 20, 30 })
+	{
+		PushFrame(t_Changed, 1, { 1 }, c_StartNs + t_Ms * c_MsNs, t_Curve);
+		PushFrame(t_Missing, 1, { 1 }, c_StartNs + t_Ms * c_MsNs, t_Curve);
+	}
+	for (int64_t t_Ms = 10; t_Ms <= 20; t_Ms += 2)
+	{
+		EXPECT_EQ(SampleX(t_Changed, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite),
+			SampleX(t_Missing, c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Hermite)) << t_Ms << " ms";
+	}
+}
+
+TEST(PoseHistory, GroupsWithChangedKeysTakeTheNearestFrame)
+{
+	// Two groups of two elements. The second group holds another skeleton in the second frame.
+	const std::function<double(double)> t_Line = [](double p_T) { return 10.0 * p_T; };
+	PoseHistory t_History;
+	t_History.Configure(4, 2);
+	PushFrame(t_History, 4, { 1, 5 }, c_StartNs, t_Line);
+	PushFrame(t_History, 4, { 1, 6 }, c_StartNs + 10 * c_MsNs, t_Line);
+
+	for (int64_t t_Ms : { 3, 7 })
+	{
+		Poses t_Out(4);
+		uint32_t t_Keys[2];
+		bool t_Held;
+		ASSERT_EQ(t_History.Sample(c_StartNs + t_Ms * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 4u);
+		EXPECT_EQ(t_Keys[0], 1u);
+		EXPECT_NEAR(t_Out.values[0][1], t_Line((double)t_Ms * 1e-3) + 1.0, 1e-12);
+		const bool t_Later = t_Ms > 5;
+		EXPECT_EQ(t_Keys[1], t_Later ? 6u : 5u);
+		EXPECT_NEAR(t_Out.values[0][3], t_Line(t_Later ? 0.01 : 0.0) + 3.0, 1e-12);
+	}
+}
+
+TEST(PoseHistory, AbsentGroupsAndShorterFramesTakeTheNearestFrame)
+{
+	const std::function<double(double)> t_Line = [](double p_T) { return 10.0 * p_T; };
+	PoseHistory t_History;
+	t_History.Configure(4, 2);
+	PushFrame(t_History, 4, { PoseHistory::c_Absent, 2 }, c_StartNs, t_Line);
+	// The second group is gone in the next frame.
+	PushFrame(t_History, 2, { PoseHistory::c_Absent }, c_StartNs + 10 * c_MsNs, t_Line);
+
+	Poses t_Out(4);
+	uint32_t t_Keys[2];
+	bool t_Held;
+	ASSERT_EQ(t_History.Sample(c_StartNs + 4 * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 4u);
+	EXPECT_EQ(t_Keys[0], PoseHistory::c_Absent);
+	EXPECT_EQ(t_Keys[1], 2u);
+	EXPECT_NEAR(t_Out.values[0][0], 0.0, 1e-12);
+	EXPECT_NEAR(t_Out.values[0][3], 3.0, 1e-12);
+	EXPECT_EQ(t_History.Sample(c_StartNs + 6 * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 2u);
+	EXPECT_NEAR(t_Out.values[0][0], 0.1, 1e-12);
+}
+
+TEST(PoseHistory, GapsAreNotInterpolated)
+{
+	const std::function<double(double)> t_Line = [](double p_T) { return p_T; };
+	const int64_t t_GapNs = (int64_t)((PoseHistory::c_MaxGapS + 0.05) * 1e9);
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	PushFrame(t_History, 1, { 1 }, c_StartNs, t_Line);
+	PushFrame(t_History, 1, { 1 }, c_StartNs + t_GapNs, t_Line);
+	for (ResampleInterpolation t_Interpolation : { ResampleInterpolation::Linear, ResampleInterpolation::Hermite })
+	{
+		EXPECT_EQ(SampleX(t_History, c_StartNs + t_GapNs / 4, t_Interpolation), 0.0);
+		EXPECT_EQ(SampleX(t_History, c_StartNs + t_GapNs * 3 / 4, t_Interpolation), (double)t_GapNs * 1e-9);
+	}
+}
+
+TEST(PoseHistory, HoldsOutsideTheHistory)
+{
+	const std::function<double(double)> t_Line = [](double p_T) { return p_T; };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	Poses t_Out(1);
+	uint32_t t_Keys[1];
+	bool t_Held = true;
+	EXPECT_EQ(t_History.Sample(c_StartNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 0u);
+	EXPECT_FALSE(t_Held);
+
+	PushFrame(t_History, 1, { 1 }, c_StartNs, t_Line);
+	PushFrame(t_History, 1, { 1 }, c_StartNs + 10 * c_MsNs, t_Line);
+
+	// Before the oldest frame it is taken as is, and that is not holding.
+	ASSERT_EQ(t_History.Sample(c_StartNs - 5 * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 1u);
+	EXPECT_EQ(t_Out.values[0][0], 0.0);
+	EXPECT_FALSE(t_Held);
+	// At the newest frame nothing is held yet, past it the newest frame is.
+	ASSERT_EQ(t_History.Sample(c_StartNs + 10 * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 1u);
+	EXPECT_NEAR(t_Out.values[0][0], 0.01, 1e-12);
+	EXPECT_FALSE(t_Held);
+	ASSERT_EQ(t_History.Sample(c_StartNs + 15 * c_MsNs, ResampleInterpolation::Hermite, t_Out.pointers, t_Keys, t_Held), 1u);
+	EXPECT_NEAR(t_Out.values[0][0], 0.01, 1e-12);
+	EXPECT_TRUE(t_Held);
+
+	t_History.Clear();
+	EXPECT_EQ(t_History.Sample(c_StartNs + 5 * c_MsNs, ResampleInterpolation::Linear, t_Out.pointers, t_Keys, t_Held), 0u);
+}
+
+TEST(PoseHistory, DropsOlderFramesAndReplacesEqualTimes)
+{
+	const std::function<double(double)> t_Line = [](double p_T) { return p_T; };
+	const std::function<double(double)> t_Other = [](double) { return 7.0; };
+	PoseHistory t_History;
+	t_History.Configure(1, 1);
+	PushFrame(t_History, 1, { 1 }, c_StartNs + 10 * c_MsNs, t_Line);
+	PushFrame(t_History, 1, { 1 }, c_StartNs, t_Other);
+	EXPECT_NEAR(SampleX(t_History, c_StartNs, ResampleInterpolation::Linear), 0.01, 1e-12);
+	PushFrame(t_History, 1, { 1 }, c_StartNs + 10 * c_MsNs, t_Other);
+	EXPECT_EQ(SampleX(t_History, c_StartNs + 10 * c_MsNs, ResampleInterpolation::Linear), 7.0);
+}
+
+TEST(PoseHistory, SlerpTakesTheShorterArc)
+{
+	// The identity and a quarter turn about z, the latter also given with the opposite sign.
+	const double t_Identity[4] = { 0.0, 0.0, 0.0, 1.0 };
+	const double t_Half = std::sqrt(0.5);
+	const double t_Quarter[4] = { 0.0, 0.0, t_Half, t_Half };
+	const double t_Negated[4] = { 0.0, 0.0, -t_Half, -t_Half };
+	for (const double* t_Target : { t_Quarter, t_Negated })
+	{
+		double t_Out[4];
+		PoseHistory::Slerp(t_Identity, t_Target, 0.5, t_Out);
+		EXPECT_NEAR(t_Out[0], 0.0, 1e-12);
+		EXPECT_NEAR(t_Out[1], 0.0, 1e-12);
+		EXPECT_NEAR(t_Out[2], std::sin(M_PI / 8), 1e-12);
+		EXPECT_NEAR(t_Out[3], std::cos(M_PI / 8), 1e-12);
+	}
+}
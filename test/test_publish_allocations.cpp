@@ -0,0 +1,122 @@
+/// @file test_publish_allocations.cpp
+/// @brief Checks that publishing a frame does not touch the heap once the persistent messages were sized by the first
+/// one, and that with intra-process communication it only allocates the messages handed over. Synthetic frames go
+/// through the real SDKMinimalClient callbacks and convert*DataToROS, counting the allocations of this thread with the
+/// malloc replacements of bench/allocation_counter.cpp.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "allocation_counter.hpp"
+#include "conversion_environment.hpp"
+
+
+namespace
+{
+constexpr int c_Frames = 100;
+
+/// @brief Converts c_Frames frames after a warm up frame and returns the allocations they made.
+template<typename Convert>
+uint64_t AllocationsAfterWarmUp(Convert p_Convert)
+{
+	p_Convert(); // Sizes the persistent messages.
+	const uint64_t t_Before = ThreadAllocationCount();
+	for (int i = 0; i < c_Frames; i++)
+	{
+		p_Convert();
+	}
+	return ThreadAllocationCount() - t_Before;
+}
+
+/// @brief Heap blocks a copy of p_String needs, none when it fits the small string buffer.
+uint64_t StringAllocations(const std::string& p_String)
+{
+	return p_String.size() > std::string().capacity() ? 1 : 0;
+}
+
+/// @brief A publisher like the one of ConversionEnvironment, but with intra-process communication, converting the
+/// frames fed to the shared client.
+ManusROS2Publisher& IntraProcessPublisher()
+{
+	ConversionEnvironment::Get();
+	static std::shared_ptr<ManusROS2Publisher> s_Publisher = []() {
+		auto t_Publisher = std::make_shared<ManusROS2Publisher>(
+			rclcpp::NodeOptions().use_intra_process_comms(true).parameter_overrides({ { "multi_user", true } }));
+		for (uint32_t t_User = 0; t_User < SDKMinimalClient::c_MaxUsers; t_User++)
+		{
+			t_Publisher->add_user(t_User, 100 + t_User);
+		}
+		return t_Publisher;
+	}();
+	return *s_Publisher;
+}
+}
+
+
+TEST(PublishAllocations, SkeletonFrames)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	for (uint32_t t_SkeletonCount : { 2u, (uint32_t)MAX_NUMBER_OF_SKELETONS })
+	{
+		t_Environment.FeedSkeletons(t_SkeletonCount);
+		EXPECT_EQ(AllocationsAfterWarmUp([&]() { convertSkeletonDataToROS(*t_Environment.publisher); }), 0u)
+			<< t_SkeletonCount << " skeletons";
+	}
+}
+
+TEST(PublishAllocations, ErgonomicsFrames)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	t_Environment.FeedErgonomics();
+	EXPECT_EQ(AllocationsAfterWarmUp([&]() { convertErgonomicsDataToROS(*t_Environment.publisher); }), 0u);
+}
+
+TEST(PublishAllocations, TrackerFrames)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	for (uint32_t t_TrackerCount : { 2u, (uint32_t)MAX_NUMBER_OF_TRACKERS })
+	{
+		t_Environment.FeedTrackers(t_TrackerCount);
+		EXPECT_EQ(AllocationsAfterWarmUp([&]() { convertTrackerDataToROS(*t_Environment.publisher); }), 0u)
+			<< t_TrackerCount << " trackers";
+	}
+}
+
+// Every PoseArray handed over takes a new message, its poses and its frame ID when that outgrows the small string
+// buffer, as user_100/manus_left does.
+TEST(PublishAllocations, IntraProcessSkeletonFrames)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	ManusROS2Publisher& t_Publisher = IntraProcessPublisher();
+	for (uint32_t t_SkeletonCount : { 2u, (uint32_t)MAX_NUMBER_OF_SKELETONS })
+	{
+		t_Environment.FeedSkeletons(t_SkeletonCount);
+		uint64_t t_PerFrame = 0;
+		for (uint32_t t_User = 0; t_User < t_SkeletonCount / 2; t_User++)
+		{
+			const UserHandPublishers* t_Hands = t_Publisher.user_publishers(t_User);
+			t_PerFrame += 2 + StringAllocations(t_Hands->left_message.header.frame_id);
+			t_PerFrame += 2 + StringAllocations(t_Hands->right_message.header.frame_id);
+		}
+		EXPECT_EQ(AllocationsAfterWarmUp([&]() { convertSkeletonDataToROS(t_Publisher); }), c_Frames * t_PerFrame)
+			<< t_SkeletonCount << " skeletons";
+	}
+}
+
+// The JointState handed over takes a new message, its positions, its name vector and every name that outgrows the
+// small string buffer, which is most of them.
+TEST(PublishAllocations, IntraProcessErgonomicsFrames)
+{
+	ConversionEnvironment& t_Environment = ConversionEnvironment::Get();
+	ManusROS2Publisher& t_Publisher = IntraProcessPublisher();
+	t_Environment.FeedErgonomics();
+	uint64_t t_PerFrame = 3;
+	for (const char* t_Name : c_ErgonomicsDataTypeNames)
+	{
+		t_PerFrame += StringAllocations(t_Name);
+	}
+	EXPECT_EQ(AllocationsAfterWarmUp([&]() { convertErgonomicsDataToROS(t_Publisher); }), c_Frames * t_PerFrame);
+}
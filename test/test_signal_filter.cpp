@@ -0,0 +1,300 @@
+/// @file test_signal_filter.cpp
+/// @brief Tests the SignalFilterBank passes against scalar references, and its seeding, restarts and quaternion
+/// handling.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "SignalFilter.hpp"
+
+
+namespace
+{
+constexpr int64_t c_StartNs = 1000000000LL;
+constexpr int64_t c_PeriodNs = 10000000LL; // 100 Hz
+constexpr double c_Dt = 0.01;
+
+/// @brief Values of a bank, one array per component padded to whole blocks, as the publisher keeps them.
+struct Frame
+{
+	Frame(size_t p_Components, size_t p_Count)
+		: values(p_Components, std::vector<double>((p_Count + SignalFilterBank::c_Lanes - 1) / SignalFilterBank::c_Lanes * SignalFilterBank::c_Lanes, 0.0))
+	{
+		for (std::vector<double>& t_Component : values) pointers.push_back(t_Component.data());
+	}
+
+	std::vector<std::vector<double>> values;
+	std::vector<double*> pointers;
+};
+
+SignalFilterConfig MakeConfig(SignalFilterType p_Type)
+{
+	SignalFilterConfig t_Config;
+	t_Config.type = p_Type;
+	return t_Config;
+}
+}
+
+
+TEST(SignalFilterBank, NoneLeavesValuesUnchanged)
+{
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(MakeConfig(SignalFilterType::None), 1, 3);
+	EXPECT_FALSE(t_Bank.IsEnabled());
+	Frame t_Frame(1, 3);
+	t_Frame.values[0] = { 1.0, 2.0, 3.0, 0.0 };
+	t_Bank.Process(t_Frame.pointers.data(), 3, c_StartNs);
+	t_Frame.values[0] = { 4.0, 5.0, 6.0, 0.0 };
+	t_Bank.Process(t_Frame.pointers.data(), 3, c_StartNs + c_PeriodNs);
+	EXPECT_EQ(t_Frame.values[0], std::vector<double>({ 4.0, 5.0, 6.0, 0.0 }));
+}
+
+TEST(SignalFilterBank, FirstSamplePassesThrough)
+{
+	for (SignalFilterType t_Type : { SignalFilterType::OneEuro, SignalFilterType::CriticallyDamped, SignalFilterType::Median })
+	{
+		SignalFilterBank t_Bank;
+		t_Bank.Configure(MakeConfig(t_Type), 2, 5);
+		Frame t_Frame(2, 5);
+		for (size_t i = 0; i < 5; i++)
+		{
+			t_Frame.values[0][i] = (double)i;
+			t_Frame.values[1][i] = -(double)i;
+		}
+		const std::vector<std::vector<double>> t_Expected = t_Frame.values;
+		t_Bank.Process(t_Frame.pointers.data(), 5, c_StartNs);
+		for (size_t c = 0; c < 2; c++)
+		{
+			for (size_t i = 0; i < 5; i++) EXPECT_EQ(t_Frame.values[c][i], t_Expected[c][i]) << "type " << (int)t_Type;
+		}
+	}
+}
+
+TEST(SignalFilterBank, OneEuroMatchesScalarReference)
+{
+	SignalFilterConfig t_Config = MakeConfig(SignalFilterType::OneEuro);
+	t_Config.minCutoffHz = 2.0;
+	t_Config.beta = 0.5;
+	t_Config.derivativeCutoffHz = 1.5;
+	// Not a multiple of the lanes, so the last block is partly padding.
+	constexpr size_t c_Count = 7;
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(t_Config, 1, c_Count);
+
+	std::mt19937 t_Random(7);
+	std::normal_distribution<double> t_Noise(0.0, 0.05);
+	std::array<double, c_Count> t_Value{}, t_Rate{};
+	Frame t_Frame(1, c_Count);
+	for (int t_Step = 0; t_Step < 200; t_Step++)
+	{
+		std::array<double, c_Count> t_Samples;
+		for (size_t i = 0; i < c_Count; i++)
+		{
+			t_Samples[i] = std::sin(0.05 * t_Step + (double)i) + t_Noise(t_Random);
+			t_Frame.values[0][i] = t_Samples[i];
+		}
+		t_Bank.Process(t_Frame.pointers.data(), c_Count, c_StartNs + t_Step * c_PeriodNs);
+
+		for (size_t i = 0; i < c_Count; i++)
+		{
+			if (t_Step == 0)
+			{
+				t_Value[i] = t_Samples[i];
+				t_Rate[i] = 0.0;
+			}
+			else
+			{
+				const double t_RateAlpha = 1.0 / (1.0 + 1.0 / (2.0 * M_PI * t_Config.derivativeCutoffHz * c_Dt));
+				t_Rate[i] += t_RateAlpha * ((t_Samples[i] - t_Value[i]) / c_Dt - t_Rate[i]);
+				const double t_Cutoff = t_Config.minCutoffHz + t_Config.beta * std::fabs(t_Rate[i]);
+				const double t_Alpha = 1.0 / (1.0 + 1.0 / (2.0 * M_PI * t_Cutoff * c_Dt));
+				t_Value[i] += t_Alpha * (t_Samples[i] - t_Value[i]);
+			}
+			ASSERT_NEAR(t_Frame.values[0][i], t_Value[i], 1e-12) << "step " << t_Step << " element " << i;
+		}
+	}
+}
+
+TEST(SignalFilterBank, CriticallyDampedStepResponse)
+{
+	SignalFilterConfig t_Config = MakeConfig(SignalFilterType::CriticallyDamped);
+	t_Config.timeConstantS = 0.1;
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(t_Config, 1, 1);
+	Frame t_Frame(1, 1);
+	t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs);
+
+	// x(t) = 1 - (1 + w t) exp(-w t) with w = 2 / T, and never past the target.
+	const double t_Omega = 2.0 / t_Config.timeConstantS;
+	double t_Last = 0.0;
+	for (int t_Step = 1; t_Step <= 200; t_Step++)
+	{
+		t_Frame.values[0][0] = 1.0;
+		t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs + t_Step * c_PeriodNs);
+		const double t_Output = t_Frame.values[0][0];
+		const double t_Wt = t_Omega * t_Step * c_Dt;
+		EXPECT_NEAR(t_Output, 1.0 - (1.0 + t_Wt) * std::exp(-t_Wt), 0.01) << "step " << t_Step;
+		EXPECT_GE(t_Output, t_Last);
+		EXPECT_LE(t_Output, 1.0);
+		t_Last = t_Output;
+	}
+	EXPECT_NEAR(t_Last, 1.0, 1e-6);
+}
+
+TEST(SignalFilterBank, MedianOfFiveEveryOrder)
+{
+	// One element per ordering of five distinct values, each fed in that order.
+	std::array<double, 5> t_Order = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+	std::vector<std::array<double, 5>> t_Orders;
+	do
+	{
+		t_Orders.push_back(t_Order);
+	} while (std::next_permutation(t_Order.begin(), t_Order.end()));
+
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(MakeConfig(SignalFilterType::Median), 1, t_Orders.size());
+	Frame t_Frame(1, t_Orders.size());
+	for (int t_Step = 0; t_Step < 5; t_Step++)
+	{
+		for (size_t i = 0; i < t_Orders.size(); i++) t_Frame.values[0][i] = t_Orders[i][t_Step];
+		t_Bank.Process(t_Frame.pointers.data(), t_Orders.size(), c_StartNs + t_Step * c_PeriodNs);
+	}
+	// The seeded history is gone after the fifth sample.
+	for (size_t i = 0; i < t_Orders.size(); i++) EXPECT_EQ(t_Frame.values[0][i], 3.0) << "order " << i;
+}
+
+TEST(SignalFilterBank, MedianOfThreeEveryOrder)
+{
+	std::array<double, 3> t_Order = { 1.0, 2.0, 3.0 };
+	std::vector<std::array<double, 3>> t_Orders;
+	do
+	{
+		t_Orders.push_back(t_Order);
+	} while (std::next_permutation(t_Order.begin(), t_Order.end()));
+
+	SignalFilterConfig t_Config = MakeConfig(SignalFilterType::Median);
+	t_Config.medianWindow = 3;
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(t_Config, 1, t_Orders.size());
+	Frame t_Frame(1, t_Orders.size());
+	for (int t_Step = 0; t_Step < 3; t_Step++)
+	{
+		for (size_t i = 0; i < t_Orders.size(); i++) t_Frame.values[0][i] = t_Orders[i][t_Step];
+		t_Bank.Process(t_Frame.pointers.data(), t_Orders.size(), c_StartNs + t_Step * c_PeriodNs);
+	}
+	for (size_t i = 0; i < t_Orders.size(); i++) EXPECT_EQ(t_Frame.values[0][i], 2.0) << "order " << i;
+}
+
+TEST(SignalFilterBank, MedianReplacesOnlyOutliers)
+{
+	SignalFilterConfig t_Config = MakeConfig(SignalFilterType::Median);
+	t_Config.outlierThreshold = 0.5;
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(t_Config, 1, 2);
+	Frame t_Frame(1, 2);
+	t_Bank.Process(t_Frame.pointers.data(), 2, c_StartNs);
+
+	// Within the threshold of the median the sample passes unchanged, a spike is replaced by the median.
+	t_Frame.values[0][0] = 0.3;
+	t_Frame.values[0][1] = 10.0;
+	t_Bank.Process(t_Frame.pointers.data(), 2, c_StartNs + c_PeriodNs);
+	EXPECT_EQ(t_Frame.values[0][0], 0.3);
+	EXPECT_EQ(t_Frame.values[0][1], 0.0);
+}
+
+TEST(SignalFilterBank, ResetRestartsOnlyTheGivenElements)
+{
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(MakeConfig(SignalFilterType::OneEuro), 1, 8);
+	Frame t_Frame(1, 8);
+	t_Bank.Process(t_Frame.pointers.data(), 8, c_StartNs);
+
+	std::fill(t_Frame.values[0].begin(), t_Frame.values[0].end(), 1.0);
+	t_Bank.Reset(2, 5);
+	t_Bank.Process(t_Frame.pointers.data(), 8, c_StartNs + c_PeriodNs);
+	for (size_t i = 0; i < 8; i++)
+	{
+		if (i >= 2 && i < 5) EXPECT_EQ(t_Frame.values[0][i], 1.0) << "element " << i;
+		else EXPECT_LT(t_Frame.values[0][i], 0.5) << "element " << i;
+	}
+}
+
+TEST(SignalFilterBank, GapRestartsEveryFilter)
+{
+	for (SignalFilterType t_Type : { SignalFilterType::OneEuro, SignalFilterType::CriticallyDamped, SignalFilterType::Median })
+	{
+		SignalFilterBank t_Bank;
+		t_Bank.Configure(MakeConfig(t_Type), 1, 1);
+		Frame t_Frame(1, 1);
+		t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs);
+
+		// Within the gap the step is smoothed or rejected, past it the sample is taken as the new state.
+		t_Frame.values[0][0] = 1.0;
+		t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs + c_PeriodNs);
+		EXPECT_LT(t_Frame.values[0][0], 1.0) << "type " << (int)t_Type;
+
+		const int64_t t_AfterGapNs = c_StartNs + c_PeriodNs + (int64_t)((SignalFilterBank::c_MaxGapS + 0.01) * 1e9);
+		t_Frame.values[0][0] = 2.0;
+		t_Bank.Process(t_Frame.pointers.data(), 1, t_AfterGapNs);
+		EXPECT_EQ(t_Frame.values[0][0], 2.0) << "type " << (int)t_Type;
+
+		// Time going backwards, such as a replay looping, restarts too.
+		t_Frame.values[0][0] = 3.0;
+		t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs);
+		EXPECT_EQ(t_Frame.values[0][0], 3.0) << "type " << (int)t_Type;
+	}
+}
+
+TEST(SignalFilterBank, QuaternionsStayInTheHemisphereOfTheLastOutput)
+{
+	for (SignalFilterType t_Type : { SignalFilterType::OneEuro, SignalFilterType::CriticallyDamped, SignalFilterType::Median })
+	{
+		// A position followed by a quaternion, as the skeleton nodes are filtered.
+		SignalFilterBank t_Bank;
+		t_Bank.Configure(MakeConfig(t_Type), 7, 1, 3);
+		Frame t_Frame(7, 1);
+		const double t_Q[4] = { 0.5, 0.5, 0.5, 0.5 };
+		for (int c = 0; c < 4; c++) t_Frame.values[3 + c][0] = t_Q[c];
+		t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs);
+
+		// The same rotation with the opposite sign must not be averaged towards zero.
+		for (int t_Step = 1; t_Step <= 4; t_Step++)
+		{
+			const double t_Sign = t_Step % 2 == 0 ? 1.0 : -1.0;
+			for (int c = 0; c < 4; c++) t_Frame.values[3 + c][0] = t_Sign * t_Q[c];
+			t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs + t_Step * c_PeriodNs);
+			double t_Norm = 0.0;
+			for (int c = 0; c < 4; c++)
+			{
+				EXPECT_NEAR(t_Frame.values[3 + c][0], t_Q[c], 1e-9) << "type " << (int)t_Type << " step " << t_Step;
+				t_Norm += t_Frame.values[3 + c][0] * t_Frame.values[3 + c][0];
+			}
+			EXPECT_NEAR(t_Norm, 1.0, 1e-12);
+		}
+	}
+}
+
+TEST(SignalFilterBank, QuaternionsAreRenormalized)
+{
+	SignalFilterBank t_Bank;
+	t_Bank.Configure(MakeConfig(SignalFilterType::OneEuro), 4, 1, 0);
+	Frame t_Frame(4, 1);
+	t_Frame.values[0][0] = 1.0;
+	t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs);
+
+	// Halfway between two rotations the component wise average is shorter than a unit quaternion.
+	t_Frame.values[0][0] = 0.0;
+	t_Frame.values[1][0] = 1.0;
+	t_Bank.Process(t_Frame.pointers.data(), 1, c_StartNs + c_PeriodNs);
+	double t_Norm = 0.0;
+	for (int c = 0; c < 4; c++) t_Norm += t_Frame.values[c][0] * t_Frame.values[c][0];
+	EXPECT_NEAR(t_Norm, 1.0, 1e-12);
+	EXPECT_GT(t_Frame.values[0][0], 0.0);
+	EXPECT_GT(t_Frame.values[1][0], 0.0);
+}